@@ -0,0 +1,438 @@
+#include "Batch.h"
+#include "NumberParser.h"
+#include "Paging.h"
+#include "Server.h"
+
+#define MAX_BATCH_ARGUMENTS 4 // arguments of the longest command, add
+#define BATCH_OUTPUT_BUFFER 1048576 // bytes of output collected before a write
+
+
+/* A command of the batch mode, the arguments are the words that follow its name on the line */
+typedef struct BatchCommand_t {
+    const char* name;
+    int arguments;
+    int optional;  // arguments that may be left out after the others, NULL when they are
+    bool readOnly; // runs alongside other reads, and renders its output instead of printing it
+    status (*run)(JerryBoree* daycare, char** arguments);
+    // when set, runs instead on the current listing without taking the lock, so writers never wait for it (may be NULL)
+    status (*runOnListing)(JerryListing* listing, char** arguments);
+} BatchCommand;
+
+
+// reads a whole number argument, returns false if the argument is anything else
+static bool parseIntArgument(const char* text, int* value) {
+    char* end;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed < -2147483647L || parsed > 2147483647L) {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+
+// add <id> <planet> <dimension> <happiness>
+static status batchAdd(JerryBoree* daycare, char** arguments) {
+    if (lookupJerry(daycare, arguments[0])) {
+        printf("Rick did you forgot ? you already left him here ! \n");
+        return success;
+    }
+    Planet* planet = lookupInHashTable(daycare->planetsByName, arguments[1]);
+    if (!planet) {
+        printf("%s is not a known planet ! \n", arguments[1]);
+        return success;
+    }
+    int happiness;
+    if (!parseIntArgument(arguments[3], &happiness)) {
+        printf("Rick this value is not known to the daycare ! \n");
+        return success;
+    }
+    return intakeJerry(daycare, arguments[0], planet, arguments[2], happiness);
+}
+
+
+// addpc <id> <characteristic> <value>
+static status batchAddCharacteristic(JerryBoree* daycare, char** arguments) {
+    Jerry* jerry = lookupJerry(daycare, arguments[0]);
+    if (!jerry) {
+        printf("Rick this Jerry is not in the daycare ! \n");
+        return success;
+    }
+    if (hasPhysicalCharacteristic(jerry, arguments[1])) {
+        printf("The information about his %s already available to the daycare ! \n", arguments[1]);
+        return success;
+    }
+    double value;
+    if (!parseDecimal(arguments[2], NULL, &value)) {
+        printf("Rick this value is not known to the daycare ! \n");
+        return success;
+    }
+    return addCharacteristicAndShow(daycare, jerry, arguments[1], value);
+}
+
+
+// delpc <id> <characteristic>
+static status batchRemoveCharacteristic(JerryBoree* daycare, char** arguments) {
+    Jerry* jerry = lookupJerry(daycare, arguments[0]);
+    if (!jerry) {
+        printf("Rick this Jerry is not in the daycare ! \n");
+        return success;
+    }
+    if (!hasPhysicalCharacteristic(jerry, arguments[1])) {
+        printf("The information about his %s not available to the daycare ! \n", arguments[1]);
+        return success;
+    }
+    return removeCharacteristicAndShow(daycare, jerry, arguments[1]);
+}
+
+
+// checkout <id>
+static status batchCheckout(JerryBoree* daycare, char** arguments) {
+    Jerry* jerry = lookupJerry(daycare, arguments[0]);
+    if (!jerry) {
+        printf("Rick this Jerry is not in the daycare ! \n");
+        return success;
+    }
+    return deleteJerryFromStructures(daycare, jerry);
+}
+
+
+// checkoutdim <dimension>
+static status batchCheckoutDimension(JerryBoree* daycare, char** arguments) {
+    return checkoutJerriesFromDimension(daycare, arguments[0]);
+}
+
+
+// checkoutplanet <planet>
+static status batchCheckoutPlanet(JerryBoree* daycare, char** arguments) {
+    return checkoutJerriesFromPlanet(daycare, arguments[0]);
+}
+
+
+// similar <characteristic> <value>
+static status batchSimilar(JerryBoree* daycare, char** arguments) {
+    status indexed = loadLazyCharacteristic(daycare, arguments[0]);
+    if (indexed != success) {
+        return indexed;
+    }
+    LinkedList jerries_with_pc = lookupInMultiValueHashTable(daycare->jerriesByCharacteristics, arguments[0]);
+    if (!jerries_with_pc) {
+        printf("Rick we can not help you - we do not know any Jerry's %s ! \n", arguments[0]);
+        return success;
+    }
+    double target_value;
+    if (!parseDecimal(arguments[1], NULL, &target_value)) {
+        printf("Rick this value is not known to the daycare ! \n");
+        return success;
+    }
+    return takeSimilarJerry(daycare, jerries_with_pc, arguments[0], target_value);
+}
+
+
+// saddest
+static status batchSaddest(JerryBoree* daycare, char** arguments) {
+    return removeSaddestJerry(daycare);
+}
+
+
+// play <activity>, the activities are numbered like in the menu
+static status batchPlay(JerryBoree* daycare, char** arguments) {
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) return loaded;
+    if (getLengthList(daycare->jerries) == 0) {
+        printf("Rick we can not help you - we currently have no Jerries in the daycare ! \n");
+        return success;
+    }
+    if (strlen(arguments[0]) != 1 || arguments[0][0] < '1' || arguments[0][0] > '3') {
+        printf("Rick this option is not known to the daycare ! \n");
+        return success;
+    }
+    return playAndShow(daycare, arguments[0][0] - '0');
+}
+
+
+// list
+static status batchList(JerryBoree* daycare, char** arguments) {
+    return printAllJerries(daycare);
+}
+
+static status batchListVersion(JerryListing* listing, char** arguments) {
+    return displayJerryListing(listing);
+}
+
+
+// the keys that find the place of a page's last item again
+static char* jerryKey(Element jerry) {
+    return ((Jerry*)jerry)->id;
+}
+
+static char* planetKey(Element planet) {
+    return ((Planet*)planet)->name;
+}
+
+
+// reads the size of a page, returns false if it is not a positive whole number
+static bool parsePageLimit(const char* text, int* limit) {
+    if (!parseIntArgument(text, limit) || *limit < 1) {
+        displayMessage("Rick this value is not known to the daycare ! \n");
+        return false;
+    }
+    return true;
+}
+
+
+// finds where a page starts, returns false if the cursor is not one of the daycare's
+static bool parsePageCursor(LinkedList list, ListCursor* reader, const char* cursor, char* (*keyOf)(Element), int* first) {
+    *first = resumePosition(list, reader, cursor, keyOf);
+    if (*first < 1) {
+        displayMessage("Rick this cursor is not known to the daycare ! \n");
+        return false;
+    }
+    return true;
+}
+
+
+// page <limit> [cursor]
+static status batchPage(JerryBoree* daycare, char** arguments) {
+    int limit, first;
+    ListCursor reader = { .list = NULL };
+    if (!parsePageLimit(arguments[0], &limit)) {
+        return success;
+    }
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) return loaded;
+    if (getLengthList(daycare->jerries) == 0) {
+        return displayMessage("Rick we can not help you - we currently have no Jerries in the daycare ! \n");
+    }
+    if (!parsePageCursor(daycare->jerries, &reader, arguments[1], jerryKey, &first)) {
+        return success;
+    }
+    return displayPage(daycare->jerries, &reader, first, limit, jerryKey);
+}
+
+
+// pagepc <characteristic> <limit> [cursor], the first page starts with the name like the full listing
+static status batchPageCharacteristic(JerryBoree* daycare, char** arguments) {
+    int limit, first;
+    ListCursor reader = { .list = NULL };
+    if (!parsePageLimit(arguments[1], &limit)) {
+        return success;
+    }
+    status indexed = loadLazyCharacteristic(daycare, arguments[0]);
+    if (indexed != success) {
+        return indexed;
+    }
+    LinkedList jerries_with_pc = lookupInMultiValueHashTable(daycare->jerriesByCharacteristics, arguments[0]);
+    if (!jerries_with_pc || getLengthList(jerries_with_pc) == 0) {
+        return displayUnknownCharacteristic(arguments[0]);
+    }
+    if (!parsePageCursor(jerries_with_pc, &reader, arguments[2], jerryKey, &first)) {
+        return success;
+    }
+    if (first == 1) {
+        status state = print_pc_name(arguments[0]);
+        if (state != success) return state;
+    }
+    return displayPage(jerries_with_pc, &reader, first, limit, jerryKey);
+}
+
+
+// show <id>
+static status batchShow(JerryBoree* daycare, char** arguments) {
+    Jerry* jerry = lookupJerry(daycare, arguments[0]);
+    if (!jerry) {
+        return displayMessage("Rick this Jerry is not in the daycare ! \n");
+    }
+    return printJerry(jerry);
+}
+
+
+// closest <characteristic> <value>, like similar but the Jerry stays in the daycare
+static status batchClosest(JerryBoree* daycare, char** arguments) {
+    status indexed = loadLazyCharacteristic(daycare, arguments[0]);
+    if (indexed != success) {
+        return indexed;
+    }
+    LinkedList jerries_with_pc = lookupInMultiValueHashTable(daycare->jerriesByCharacteristics, arguments[0]);
+    if (!jerries_with_pc) {
+        return displayUnknownCharacteristic(arguments[0]);
+    }
+    double target_value;
+    if (!parseDecimal(arguments[1], NULL, &target_value)) {
+        return displayMessage("Rick this value is not known to the daycare ! \n");
+    }
+    Jerry* closest_jerry = findSimilarJerry(daycare, jerries_with_pc, arguments[0], target_value);
+    if (!closest_jerry) {
+        return success;
+    }
+    status state = displayMessage("Rick this is the most suitable Jerry we found : \n");
+    return state == success ? printJerry(closest_jerry) : state;
+}
+
+
+// pageplanets <limit> [cursor]
+static status batchPagePlanets(JerryBoree* daycare, char** arguments) {
+    int limit, first;
+    ListCursor reader = { .list = NULL };
+    if (!parsePageLimit(arguments[0], &limit) || !parsePageCursor(daycare->planets, &reader, arguments[1], planetKey, &first)) {
+        return success;
+    }
+    return displayPage(daycare->planets, &reader, first, limit, planetKey);
+}
+
+
+static const BatchCommand batchCommands[] = {
+    { "add", 4, 0, false, batchAdd, NULL },
+    { "addpc", 3, 0, false, batchAddCharacteristic, NULL },
+    { "delpc", 2, 0, false, batchRemoveCharacteristic, NULL },
+    { "checkout", 1, 0, false, batchCheckout, NULL },
+    { "checkoutdim", 1, 0, false, batchCheckoutDimension, NULL },
+    { "checkoutplanet", 1, 0, false, batchCheckoutPlanet, NULL },
+    { "similar", 2, 0, false, batchSimilar, NULL },
+    { "saddest", 0, 0, false, batchSaddest, NULL },
+    { "play", 1, 0, false, batchPlay, NULL },
+    { "list", 0, 0, true, batchList, batchListVersion },
+    { "page", 1, 1, true, batchPage, NULL },
+    { "pagepc", 2, 1, true, batchPageCharacteristic, NULL },
+    { "pageplanets", 1, 1, true, batchPagePlanets, NULL },
+    { "show", 1, 0, true, batchShow, NULL },
+    { "closest", 2, 0, true, batchClosest, NULL },
+};
+
+
+// runs a command under the daycare's lock, shared when it only reads, or on a listing pinned by its epoch
+static status runBatchCommand(JerryBoree* daycare, const BatchCommand* command, char** arguments) {
+    status result;
+    if (command->runOnListing) {
+        long epoch;
+        JerryListing* listing = pinJerryListing(daycare, &epoch);
+        if (listing) {
+            result = command->runOnListing(listing, arguments);
+            unpinListing(daycare->listings, epoch);
+            return result;
+        }
+    }
+    if (command->readOnly) {
+        lockRead(daycare->lock);
+        // a lazy daycare still builds Jerries on first use, and reading them changes it until all are built
+        if (isDaycareLoaded(daycare)) {
+            result = command->run(daycare, arguments);
+            unlockRead(daycare->lock);
+            return result;
+        }
+        unlockRead(daycare->lock);
+    }
+    lockWrite(daycare->lock);
+    result = command->run(daycare, arguments);
+    unlockWrite(daycare->lock);
+    return result;
+}
+
+
+status runBatchLine(JerryBoree* daycare, char* line, int number) {
+    char* words[MAX_BATCH_ARGUMENTS + 2] = { NULL };
+    int count = 0;
+    char* position;
+    for (char* word = strtok_r(line, " \t\r\n", &position); word && count < MAX_BATCH_ARGUMENTS + 2;
+         word = strtok_r(NULL, " \t\r\n", &position)) {
+        words[count++] = word;
+    }
+    if (count == 0 || words[0][0] == '#') { // empty line or comment
+        return success;
+    }
+    for (size_t i = 0; i < sizeof(batchCommands) / sizeof(batchCommands[0]); i++) {
+        const BatchCommand* command = &batchCommands[i];
+        if (strcmp(words[0], command->name) == 0 && count - 1 >= command->arguments &&
+            count - 1 <= command->arguments + command->optional) {
+            return runBatchCommand(daycare, command, words + 1);
+        }
+    }
+    Renderer out = getStandardRenderer();
+    status state = renderString(out, "Rick line ");
+    if (state == success) state = renderInt(out, number);
+    if (state == success) state = renderString(out, " is not a command known to the daycare ! \n");
+    status written = flushRenderer(out);
+    return state != success ? state : written;
+}
+
+
+bool isReadOnlyBatchLine(const char* line) {
+    line += strspn(line, " \t\r\n");
+    size_t length = strcspn(line, " \t\r\n");
+    for (size_t i = 0; i < sizeof(batchCommands) / sizeof(batchCommands[0]); i++) {
+        if (strlen(batchCommands[i].name) == length && strncmp(line, batchCommands[i].name, length) == 0) {
+            return batchCommands[i].readOnly;
+        }
+    }
+    // unknown commands, empty lines and comments only print, if anything
+    return true;
+}
+
+
+status runBatch(DaycareCheckpoint* checkpoint, FILE* commands, int checkpointEvery) {
+    JerryBoree* daycare = checkpoint->daycare;
+    setvbuf(stdout, NULL, _IOFBF, BATCH_OUTPUT_BUFFER);
+
+    char* line = NULL;
+    size_t capacity = 0;
+    int number = 0;
+    status result = success;
+    while (result == success && getline(&line, &capacity, commands) >= 0) {
+        pollDaycareCheckpoint(checkpoint);
+        result = runBatchLine(daycare, line, ++number);
+        if (result == success && checkpointEvery > 0 && getJournalRecords(daycare->journal) >= checkpointEvery) {
+            startDaycareCheckpoint(checkpoint);
+        }
+    }
+    free(line);
+    return result;
+}
+
+
+/* What the server needs to run the commands of its clients on the daycare */
+typedef struct DaycareServer_t {
+    DaycareCheckpoint* checkpoint;
+    int checkpointEvery;
+} DaycareServer;
+
+
+// runs a command line of a client, its output is the client's answer
+// read only lines run on the workers, the others on the thread of the loop
+static status serveBatchLine(void* context, char* line, int number) {
+    DaycareServer* server = (DaycareServer*)context;
+    JerryBoree* daycare = server->checkpoint->daycare;
+    bool readOnly = isReadOnlyBatchLine(line);
+    status result = runBatchLine(daycare, line, number);
+    if (result == success && !readOnly && server->checkpointEvery > 0 &&
+        getJournalRecords(daycare->journal) >= server->checkpointEvery) {
+        // the child must not copy the daycare while a reader is in the middle of it
+        lockWrite(daycare->lock);
+        startDaycareCheckpoint(server->checkpoint);
+        unlockWrite(daycare->lock);
+    }
+    return result;
+}
+
+
+static bool isSharedBatchLine(void* context, const char* line) {
+    return isReadOnlyBatchLine(line);
+}
+
+
+static void serveIdle(void* context) {
+    DaycareServer* server = (DaycareServer*)context;
+    pollDaycareCheckpoint(server->checkpoint);
+    // frees the listings whose readers finished after the last change
+    reclaimListings(server->checkpoint->daycare->listings);
+    fflush(stdout);
+}
+
+
+status runDaycareServer(DaycareCheckpoint* checkpoint, const char* socketPath, int checkpointEvery, int workers) {
+    DaycareServer server = { checkpoint, checkpointEvery };
+    ServerHandlers handlers = { &server, serveBatchLine, serveIdle, isSharedBatchLine, workers };
+    setvbuf(stdout, NULL, _IOFBF, BATCH_OUTPUT_BUFFER);
+    printf("The daycare is open at '%s' ! \n", socketPath);
+    fflush(stdout);
+    return runServer(socketPath, &handlers);
+}
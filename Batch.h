@@ -0,0 +1,64 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include <stdio.h>
+#include "JerryBoree.h"
+
+
+/**
+ * Welcome to the Batch module!
+ * This module runs the daycare from command lines instead of the menu, one command per line:
+ * add, addpc, delpc, checkout, checkoutdim, checkoutplanet, similar, saddest, play, list, page, pagepc, pageplanets,
+ * show and closest, followed by their arguments, separated by spaces.
+ * Every command takes the daycare's lock (JerryBoree) itself: shared for the commands that only read, which may run
+ * on many threads at once, and alone for the others. The list command reads the current listing (Listing) without it.
+ * Empty lines and lines that start with '#' are skipped.
+ * The lines come from a batch file, or from the clients of a socket (Server) that one loaded daycare answers.
+ */
+
+
+
+/**
+ * Runs one command line, a line that is not a known command with the right number of arguments is reported and skipped
+ * The lines of read only commands may run on many threads at once
+ * @param daycare The daycare
+ * @param line The line, its words are cut in place
+ * @param number The number of the line, for the report
+ * @return Operation status indicating success, or memory problem / failure if the command failed
+ */
+status runBatchLine(JerryBoree* daycare, char* line, int number);
+
+
+
+/**
+ * Tells whether a line runs a read only command, without changing the line
+ * @param line The line
+ * @return true for read only commands, unknown commands, empty lines and comments
+ */
+bool isReadOnlyBatchLine(const char* line);
+
+
+
+/**
+ * Runs the commands of a batch file until its end, without prompts and with the output written in large blocks
+ * @param checkpoint The checkpoints of the daycare
+ * @param commands The batch file
+ * @param checkpointEvery Journaled changes that start a checkpoint, 0 for none
+ * @return Operation status indicating success, or the status of the first command that failed
+ */
+status runBatch(DaycareCheckpoint* checkpoint, FILE* commands, int checkpointEvery);
+
+
+
+/**
+ * Serves the batch commands to the clients of a socket until the server is stopped
+ * The read only commands run on the workers, alongside each other, the others on the thread of the server's loop
+ * @param checkpoint The checkpoints of the daycare
+ * @param socketPath The path of the socket
+ * @param checkpointEvery Journaled changes that start a checkpoint, 0 for none
+ * @param workers The threads that run the read only commands
+ * @return Operation status indicating success, or failure if the server could not run
+ */
+status runDaycareServer(DaycareCheckpoint* checkpoint, const char* socketPath, int checkpointEvery, int workers);
+
+
+#endif //BATCH_H
@@ -0,0 +1,100 @@
+#include "Checkpoint.h"
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+struct Checkpoint_s {
+    pid_t child;
+    int reportPipe; // read end, the child writes its report before it exits
+};
+
+
+static double getSeconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// runs in the child, which leaves with _exit so nothing of the parent (stdio buffers, open files) is flushed twice
+static void runCheckpoint(int reportPipe, CheckpointWriter writer, void* context) {
+    CheckpointReport report = { failure, 0, 0 };
+    double start = getSeconds();
+    report.result = writer(context, &report.bytesWritten);
+    report.seconds = getSeconds() - start;
+    // the report is smaller than PIPE_BUF, so it is written at once
+    bool sent = write(reportPipe, &report, sizeof(report)) == (ssize_t)sizeof(report);
+    _exit(sent && report.result == success ? 0 : 1);
+}
+
+// collects the report of a child that exited, and frees the checkpoint
+static void finishCheckpoint(Checkpoint checkpoint, int exitStatus, CheckpointReport* report) {
+    CheckpointReport received = { failure, 0, 0 };
+    // a child that was killed never wrote its report
+    if (WIFEXITED(exitStatus) && read(checkpoint->reportPipe, &received, sizeof(received)) != (ssize_t)sizeof(received)) {
+        received.result = failure;
+    }
+    *report = received;
+    close(checkpoint->reportPipe);
+    free(checkpoint);
+}
+
+
+
+// Interface Functions:
+
+Checkpoint startCheckpoint(CheckpointWriter writer, void* context) {
+    if (!writer) {
+        return NULL;
+    }
+    Checkpoint checkpoint = (Checkpoint)malloc(sizeof(struct Checkpoint_s));
+    int ends[2];
+    if (!checkpoint || pipe(ends) != 0) {
+        free(checkpoint);
+        return NULL;
+    }
+
+    pid_t child = fork();
+    if (child == 0) {
+        close(ends[0]);
+        runCheckpoint(ends[1], writer, context);
+    }
+    close(ends[1]);
+    if (child < 0) {
+        close(ends[0]);
+        free(checkpoint);
+        return NULL;
+    }
+    checkpoint->child = child;
+    checkpoint->reportPipe = ends[0];
+    return checkpoint;
+}
+
+
+bool pollCheckpoint(Checkpoint checkpoint, CheckpointReport* report) {
+    if (!checkpoint || !report) {
+        return false;
+    }
+    int exitStatus;
+    pid_t done = waitpid(checkpoint->child, &exitStatus, WNOHANG);
+    if (done == 0 || (done < 0 && errno == EINTR)) {
+        return false; // still running
+    }
+    finishCheckpoint(checkpoint, done < 0 ? -1 : exitStatus, report);
+    return true;
+}
+
+
+void waitCheckpoint(Checkpoint checkpoint, CheckpointReport* report) {
+    if (!checkpoint || !report) {
+        return;
+    }
+    int exitStatus;
+    pid_t done;
+    do {
+        done = waitpid(checkpoint->child, &exitStatus, 0);
+    } while (done < 0 && errno == EINTR);
+    finishCheckpoint(checkpoint, done < 0 ? -1 : exitStatus, report);
+}
@@ -0,0 +1,69 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the Checkpoint module!
+ * This module saves state in the background, without pausing the program that owns it.
+ * A checkpoint forks a child process that runs a write callback: the child sees the memory of the
+ * parent exactly as it was when the checkpoint started, through copy on write pages, so the state it
+ * writes is consistent while the parent keeps changing its own copy. The parent only pays for the fork.
+ * The child reports the result of the callback, the number of bytes it wrote and how long it took,
+ * and the parent collects the report once the child is done.
+ */
+
+
+/**
+ * A checkpoint being written by a child process
+ */
+typedef struct Checkpoint_s* Checkpoint;
+
+
+/**
+ * What a finished checkpoint reports
+ */
+typedef struct CheckpointReport_t {
+    status result;       // the status returned by the write callback, failure if the child died
+    size_t bytesWritten;
+    double seconds;      // time the child spent writing
+} CheckpointReport;
+
+
+/**
+ * Writes the state in the child process, the context is the child's copy of the parent's
+ * @return Operation status, bytesWritten set to the number of bytes written
+ */
+typedef status (*CheckpointWriter)(void* context, size_t* bytesWritten);
+
+
+
+/**
+ * Starts a checkpoint in a child process
+ * @param write The callback that writes the state, it runs in the child and must not change anything shared with the parent
+ * @param context Passed to the callback
+ * @return The running checkpoint, or NULL if the child could not be started
+ */
+Checkpoint startCheckpoint(CheckpointWriter write, void* context);
+
+
+
+/**
+ * Checks whether a checkpoint is done, without waiting for it
+ * @param checkpoint The checkpoint
+ * @param report Filled with the report of the checkpoint if it is done
+ * @return true if the checkpoint is done, in which case it is freed, false if it is still running
+ */
+bool pollCheckpoint(Checkpoint checkpoint, CheckpointReport* report);
+
+
+
+/**
+ * Waits for a checkpoint to be done, and frees it
+ * @param checkpoint The checkpoint
+ * @param report Filled with the report of the checkpoint
+ */
+void waitCheckpoint(Checkpoint checkpoint, CheckpointReport* report);
+
+
+#endif //CHECKPOINT_H
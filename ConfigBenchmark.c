@@ -0,0 +1,251 @@
+#include "ConfigParser.h"
+#include "StructuralScanner.h"
+#include "NumberParser.h"
+#include <time.h>
+#define MAX_LINE_LENGTH 301
+
+
+/**
+ * ConfigBenchmark.c
+ * Compares the configuration parsing paths on a given configuration file:
+ * - the original fgets + sscanf line parser
+ * - the memory mapped parser built on the structural scanner
+ * - the structural scanner alone, scalar against the vectorized one
+ * - the numeric fields alone, strtod against parseDecimal
+ * The records are only counted, so the numbers reflect parsing and not building the daycare.
+ */
+
+
+/* Record counters, filled by both parsers so their results can be compared */
+typedef struct RecordCounts_t {
+    long planets;
+    long jerries;
+    long characteristics;
+} RecordCounts;
+
+
+static double secondsSince(struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+
+/* fgets + sscanf path, as the daycare loaded the file before the memory mapped parser */
+
+static status legacyParse(const char* filename, int numPlanets, RecordCounts* counts) {
+    FILE* fp = fopen(filename, "r");
+    if (!fp) return failure;
+    char line[MAX_LINE_LENGTH];
+
+    // skip "Planets" header
+    if (!fgets(line, sizeof(line), fp)) {
+        fclose(fp);
+        return failure;
+    }
+    for (int i = 0; i < numPlanets; i++) {
+        char name[MAX_LINE_LENGTH];
+        float x, y, z;
+        if (!fgets(line, sizeof(line), fp) || sscanf(line, "%[^,],%f,%f,%f", name, &x, &y, &z) != 4) {
+            fclose(fp);
+            return failure;
+        }
+        counts->planets++;
+    }
+
+    // skip "Jerries" header
+    if (!fgets(line, sizeof(line), fp)) {
+        fclose(fp);
+        return failure;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = 0;
+        if (strlen(line) == 0) continue;
+        if (line[0] == '\t') {
+            char name[MAX_LINE_LENGTH];
+            double value;
+            if (sscanf(line + 1, "%[^:]:%lf", name, &value) != 2) break;
+            counts->characteristics++;
+        }
+        else {
+            char id[MAX_LINE_LENGTH], dimension[MAX_LINE_LENGTH], planetName[MAX_LINE_LENGTH];
+            int happiness;
+            if (sscanf(line, "%[^,],%[^,],%[^,],%d", id, dimension, planetName, &happiness) != 4) break;
+            counts->jerries++;
+        }
+    }
+    fclose(fp);
+    return success;
+}
+
+
+
+/* memory mapped parser path */
+
+static status countPlanet(void* context, char* name, double x, double y, double z) {
+    ((RecordCounts*)context)->planets++;
+    return success;
+}
+
+static status countJerry(void* context, char* id, char* dimension, char* planetName, int happiness) {
+    ((RecordCounts*)context)->jerries++;
+    return success;
+}
+
+static status countCharacteristic(void* context, char* name, double value) {
+    ((RecordCounts*)context)->characteristics++;
+    return success;
+}
+
+
+
+/* structural scanner alone, over the whole file in memory */
+
+static char* readWholeFile(const char* filename, size_t* length) {
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    char* data = (size > 0) ? (char*)malloc(size) : NULL;
+    if (data && fread(data, 1, size, fp) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    *length = data ? (size_t)size : 0;
+    return data;
+}
+
+static double timeScanner(size_t (*scanner)(const char*, size_t, size_t, size_t*), const char* data, size_t length,
+                          size_t* offsets, size_t window, size_t* found) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    *found = 0;
+    for (size_t position = 0; position < length; position += window) {
+        size_t end = position + window < length ? position + window : length;
+        *found += scanner(data, position, end, offsets);
+    }
+    return secondsSince(&start);
+}
+
+
+
+/* numeric fields alone, every value after a ',' or ':' in the file */
+
+static double timeNumbers(bool useStrtod, const char* data, size_t length, double* checksum) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    *checksum = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] != ',' && data[i] != ':') continue;
+        const char* text = data + i + 1;
+        char* end;
+        double value;
+        if (useStrtod) {
+            value = strtod(text, &end);
+        }
+        else if (!parseDecimal(text, &end, &value)) {
+            end = (char*)text;
+        }
+        if (end != text) {
+            *checksum += value;
+        }
+    }
+    return secondsSince(&start);
+}
+
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printf("Usage: %s <number_of_planets> <configuration_file> [repetitions]\n", argv[0]);
+        return 1;
+    }
+    int numPlanets = atoi(argv[1]);
+    const char* filename = argv[2];
+    int repetitions = argc > 3 ? atoi(argv[3]) : 5;
+    if (repetitions <= 0) repetitions = 1;
+
+    size_t length;
+    char* data = readWholeFile(filename, &length);
+    if (!data) {
+        printf("Failed to read configuration file '%s'.\n", filename);
+        return 1;
+    }
+    const size_t window = 65536;
+    size_t* offsets = (size_t*)malloc(window * sizeof(size_t));
+    if (!offsets) {
+        free(data);
+        return 1;
+    }
+
+    // the number loop reads past the last field, so keep the copy terminated
+    char* terminated = (char*)realloc(data, length + 1);
+    if (!terminated) {
+        free(offsets);
+        free(data);
+        return 1;
+    }
+    data = terminated;
+    data[length] = '\0';
+
+    double legacyBest = -1, mappedBest = -1, scalarBest = -1, vectorBest = -1, strtodBest = -1, decimalBest = -1;
+    double strtodSum = 0, decimalSum = 0;
+    RecordCounts legacyCounts, mappedCounts;
+    size_t scalarFound = 0, vectorFound = 0;
+    for (int i = 0; i < repetitions; i++) {
+        struct timespec start;
+
+        memset(&legacyCounts, 0, sizeof(legacyCounts));
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        status legacyState = legacyParse(filename, numPlanets, &legacyCounts);
+        double legacyTime = secondsSince(&start);
+
+        memset(&mappedCounts, 0, sizeof(mappedCounts));
+        ConfigHandlers handlers = { &mappedCounts, countPlanet, countJerry, countCharacteristic };
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        status mappedState = parseConfigurationFile(filename, numPlanets, &handlers);
+        double mappedTime = secondsSince(&start);
+
+        if (legacyState != success || mappedState != success) {
+            printf("Failed to parse configuration file '%s'.\n", filename);
+            free(offsets);
+            free(data);
+            return 1;
+        }
+
+        double scalarTime = timeScanner(scanStructuralsScalar, data, length, offsets, window, &scalarFound);
+        double vectorTime = timeScanner(scanStructurals, data, length, offsets, window, &vectorFound);
+
+        double strtodTime = timeNumbers(true, data, length, &strtodSum);
+        double decimalTime = timeNumbers(false, data, length, &decimalSum);
+
+        if (strtodBest < 0 || strtodTime < strtodBest) strtodBest = strtodTime;
+        if (decimalBest < 0 || decimalTime < decimalBest) decimalBest = decimalTime;
+        if (legacyBest < 0 || legacyTime < legacyBest) legacyBest = legacyTime;
+        if (mappedBest < 0 || mappedTime < mappedBest) mappedBest = mappedTime;
+        if (scalarBest < 0 || scalarTime < scalarBest) scalarBest = scalarTime;
+        if (vectorBest < 0 || vectorTime < vectorBest) vectorBest = vectorTime;
+    }
+
+    double megabytes = (double)length / (1024.0 * 1024.0);
+    printf("file : %s (%.2f MB), best of %d runs \n", filename, megabytes, repetitions);
+    printf("records (fgets + sscanf) : %ld planets , %ld Jerries , %ld characteristics \n",
+           legacyCounts.planets, legacyCounts.jerries, legacyCounts.characteristics);
+    printf("records (mapped parser)  : %ld planets , %ld Jerries , %ld characteristics \n",
+           mappedCounts.planets, mappedCounts.jerries, mappedCounts.characteristics);
+    printf("fgets + sscanf parse     : %8.2f ms (%8.2f MB/s) \n", legacyBest * 1e3, megabytes / legacyBest);
+    printf("mapped parse             : %8.2f ms (%8.2f MB/s) \n", mappedBest * 1e3, megabytes / mappedBest);
+    printf("scalar structural scan   : %8.2f ms (%8.2f MB/s) , %zu structurals \n", scalarBest * 1e3, megabytes / scalarBest, scalarFound);
+    printf("%-6s structural scan   : %8.2f ms (%8.2f MB/s) , %zu structurals \n", getStructuralScannerName(),
+           vectorBest * 1e3, megabytes / vectorBest, vectorFound);
+
+    printf("strtod numbers           : %8.2f ms \n", strtodBest * 1e3);
+    printf("parseDecimal numbers     : %8.2f ms \n", decimalBest * 1e3);
+
+    free(offsets);
+    free(data);
+    return (scalarFound == vectorFound && strtodSum == decimalSum) ? 0 : 1;
+}
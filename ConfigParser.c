@@ -0,0 +1,891 @@
+#include "ConfigParser.h"
+#include "StructuralScanner.h"
+#include "NumberParser.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PLANET_FIELDS 4 // name,x,y,z
+#define JERRY_FIELDS 4 // id,dimension,planet,happiness
+#define CHARACTERISTIC_FIELDS 2 // name:value
+#define SCAN_WINDOW 65536 // bytes handed to the structural scanner at a time
+#define MAX_LINE_DELIMITERS 8 // delimiters remembered per line, enough for every record of the format
+#define CHUNKS_PER_THREAD 4 // more chunks than threads, so one slow chunk doesn't leave the other threads idle
+#define MIN_CHUNK_SIZE 262144 // bytes of Jerries below which another chunk isn't worth a thread
+#define INITIAL_INDEX_SIZE 64 // first size of the index arrays and tables, they double when full
+
+
+/* The whole configuration file, every line in it (including the last one) ends with '\n' */
+typedef struct ConfigBuffer_t {
+    char* data;
+    size_t length;
+    bool mapped; // true if data is a private mapping, false if it was read into the heap
+} ConfigBuffer;
+
+
+/* Position of the tokenizer in the buffer, structurals are scanned one window ahead of the records */
+typedef struct Tokenizer_t {
+    char* data;
+    size_t length;
+    size_t cursor;   // start of the next line
+    size_t scanned;  // end of the part of the buffer already given to the scanner
+    size_t* offsets; // structural offsets of the current window
+    size_t count;    // number of offsets in the current window
+    size_t next;     // index of the next unread offset
+} Tokenizer;
+
+
+/* A terminated line and the delimiters found in it */
+typedef struct Line_t {
+    char* start;
+    size_t delimiters[MAX_LINE_DELIMITERS]; // offsets of the first ',' and ':' from the start of the line
+    int count;
+    bool overflow; // the line had more delimiters than we remember
+} Line;
+
+
+/* A part of the Jerries section, it starts at a Jerry line and ends right after a '\n' */
+typedef struct ConfigChunk_t {
+    size_t start;
+    size_t end;
+    void* context; // created by the handlers on the worker that parses the chunk
+    status state;  // result of parsing the chunk
+} ConfigChunk;
+
+
+/* Work shared by the parsing threads, each thread takes the next chunk until none are left */
+typedef struct ChunkWork_t {
+    char* data;
+    ConfigChunk* chunks;
+    int count;
+    int next; // index of the next chunk to parse, only accessed atomically
+    ConfigParallelHandlers* handlers;
+} ChunkWork;
+
+
+/* A characteristic name of an indexed file, and where its records are in the postings */
+typedef struct IndexedName_t {
+    size_t start;    // offset of the name in the buffer
+    size_t length;
+    uint32_t count;  // number of records with the name
+    uint32_t first;  // index of its first record in the postings
+    int lastRecord;  // last record added, a record is counted once even if it repeats the name
+} IndexedName;
+
+
+/* A characteristic line found while indexing, grouped by name once the whole section is read */
+typedef struct NamePosting_t {
+    uint32_t name;
+    uint32_t record;
+} NamePosting;
+
+
+/* A configuration file whose Jerries are only parsed on demand, see openConfigIndex */
+struct ConfigIndex_s {
+    ConfigBuffer buffer;
+    ConfigHandlers handlers;
+    size_t* records;      // start of every Jerry record, followed by the end of the section
+    int count;
+    int capacity;
+    uint32_t* idSlots;    // record + 1 by ID, 0 marks an empty slot
+    size_t idSize;        // power of two
+    IndexedName* names;
+    int nameCount;
+    int nameCapacity;
+    uint32_t* nameSlots;  // name + 1 by name, 0 marks an empty slot
+    size_t nameSize;      // power of two
+    NamePosting* found;   // characteristic lines in file order, only while indexing
+    size_t foundCount;
+    size_t foundCapacity;
+    uint32_t* postings;   // records of every name, in file order
+};
+
+
+typedef status (*JerryRecordFunction)(void* context, char* id, char* dimension, char* planetName, int happiness);
+typedef status (*CharacteristicRecordFunction)(void* context, char* name, double value);
+
+
+
+// Buffer helper functions:
+
+// reads the file into the heap and appends the missing final '\n'
+static status readConfigBuffer(int fd, size_t length, ConfigBuffer* buffer) {
+    buffer->data = (char*)malloc(length + 1);
+    if (!buffer->data) {
+        return memory_problem;
+    }
+    size_t total = 0;
+    while (total < length) {
+        ssize_t got = read(fd, buffer->data + total, length - total);
+        if (got <= 0) {
+            free(buffer->data);
+            buffer->data = NULL;
+            return failure;
+        }
+        total += got;
+    }
+    buffer->data[length] = '\n';
+    buffer->length = length + 1;
+    buffer->mapped = false;
+    return success;
+}
+
+static status openConfigBuffer(const char* filename, ConfigBuffer* buffer) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return failure;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return failure;
+    }
+    size_t length = (size_t)info.st_size;
+
+    status state = failure;
+    if (length > 0) {
+        // private and writable, so fields can be terminated in place without touching the file
+        char* data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED && data[length - 1] == '\n') {
+            madvise(data, length, MADV_SEQUENTIAL);
+            buffer->data = data;
+            buffer->length = length;
+            buffer->mapped = true;
+            state = success;
+        }
+        else if (data != MAP_FAILED) {
+            // there is no room in the mapping for the missing final '\n'
+            munmap(data, length);
+        }
+    }
+    if (state != success) {
+        state = readConfigBuffer(fd, length, buffer);
+    }
+    close(fd);
+    return state;
+}
+
+static void closeConfigBuffer(ConfigBuffer* buffer) {
+    if (buffer->mapped) {
+        munmap(buffer->data, buffer->length);
+    }
+    else {
+        free(buffer->data);
+    }
+    buffer->data = NULL;
+}
+
+
+
+// Tokenizer helper functions:
+
+// returns the offset of the next structural character, scanning the next window when needed
+static bool nextStructural(Tokenizer* tokenizer, size_t* offset) {
+    while (tokenizer->next == tokenizer->count) {
+        if (tokenizer->scanned >= tokenizer->length) {
+            return false;
+        }
+        size_t windowEnd = tokenizer->scanned + SCAN_WINDOW;
+        if (windowEnd > tokenizer->length) {
+            windowEnd = tokenizer->length;
+        }
+        tokenizer->count = scanStructurals(tokenizer->data, tokenizer->scanned, windowEnd, tokenizer->offsets);
+        tokenizer->next = 0;
+        tokenizer->scanned = windowEnd;
+    }
+    *offset = tokenizer->offsets[tokenizer->next++];
+    return true;
+}
+
+// finds the next line and its delimiters without changing the buffer, lineEnd is set to the offset of its '\n'
+// returns false at the end of the buffer
+static bool findLine(Tokenizer* tokenizer, Line* line, size_t* lineEnd) {
+    if (tokenizer->cursor >= tokenizer->length) {
+        return false;
+    }
+    line->start = tokenizer->data + tokenizer->cursor;
+    line->count = 0;
+    line->overflow = false;
+
+    // every line ends with '\n', so the structurals always reach the end of the line
+    size_t offset = tokenizer->cursor;
+    while (nextStructural(tokenizer, &offset) && tokenizer->data[offset] != '\n') {
+        if (line->count < MAX_LINE_DELIMITERS) {
+            line->delimiters[line->count++] = offset - tokenizer->cursor;
+        }
+        else {
+            line->overflow = true;
+        }
+    }
+    *lineEnd = offset;
+    tokenizer->cursor = offset + 1;
+    return true;
+}
+
+// reads the next line and terminates it in place, returns false at the end of the buffer
+static bool nextLine(Tokenizer* tokenizer, Line* line) {
+    size_t offset;
+    if (!findLine(tokenizer, line, &offset)) {
+        return false;
+    }
+    char* end = tokenizer->data + offset;
+    *end = '\0';
+    if (end > line->start && end[-1] == '\r') { // accept files with Windows line endings
+        end[-1] = '\0';
+    }
+    return true;
+}
+
+// splits a terminated text on a delimiter, byte by byte, used for lines with too many delimiters to remember
+static bool splitText(char* text, char delimiter, char** fields, int count) {
+    int found = 0;
+    fields[found++] = text;
+    char* current = text;
+    while (found < count) {
+        // states: inside a field until the delimiter, then the next field starts
+        while (*current != delimiter && *current != '\0') {
+            current++;
+        }
+        if (*current == '\0' || current == fields[found - 1]) { // missing or empty field
+            return false;
+        }
+        *current = '\0';
+        current++;
+        fields[found++] = current;
+    }
+    return *fields[count - 1] != '\0';
+}
+
+// splits a line on a delimiter, in place, into exactly count non empty fields starting at skip bytes into the line
+// the last field takes the rest of the line, returns false if the line has a different shape
+static bool splitLine(Line* line, size_t skip, char delimiter, char** fields, int count) {
+    if (line->overflow) {
+        return splitText(line->start + skip, delimiter, fields, count);
+    }
+    int found = 0;
+    fields[found++] = line->start + skip;
+    for (int i = 0; i < line->count && found < count; i++) {
+        char* position = line->start + line->delimiters[i];
+        if (*position != delimiter || position < fields[0]) {
+            continue;
+        }
+        if (position == fields[found - 1]) { // empty field
+            return false;
+        }
+        *position = '\0';
+        fields[found++] = position + 1;
+    }
+    return found == count && *fields[count - 1] != '\0';
+}
+
+// true if only blanks are left in a field
+static bool isFieldEnd(const char* text) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    return *text == '\0';
+}
+
+static bool parseDoubleField(const char* text, double* value) {
+    char* end;
+    return parseDecimal(text, &end, value) && isFieldEnd(end);
+}
+
+static bool parseIntField(const char* text, int* value) {
+    char* end;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || !isFieldEnd(end) || parsed < -2147483647L || parsed > 2147483647L) {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+
+
+// Section parsers:
+
+static status parsePlanets(Tokenizer* tokenizer, int numPlanets, ConfigHandlers* handlers) {
+    Line line;
+    // skip "Planets" header
+    if (!nextLine(tokenizer, &line)) return failure;
+
+    for (int i = 0; i < numPlanets; i++) {
+        if (!nextLine(tokenizer, &line)) return failure;
+
+        char* fields[PLANET_FIELDS];
+        double x, y, z;
+        if (!splitLine(&line, 0, ',', fields, PLANET_FIELDS)
+            || !parseDoubleField(fields[1], &x) || !parseDoubleField(fields[2], &y) || !parseDoubleField(fields[3], &z)) {
+            return failure;
+        }
+
+        status state = handlers->onPlanet(handlers->context, fields[0], x, y, z);
+        if (state != success) return state;
+    }
+    return success;
+}
+
+// parses Jerry records until the end of the tokenizer, the header must already be skipped
+static status parseJerryRecords(Tokenizer* tokenizer, void* context, JerryRecordFunction onJerry,
+                                CharacteristicRecordFunction onCharacteristic) {
+    Line line;
+    bool hasJerry = false; // characteristics belong to the last Jerry
+    while (nextLine(tokenizer, &line)) {
+        if (*line.start == '\0') continue;
+
+        status state;
+        if (*line.start == '\t') { // characteristic line
+            char* fields[CHARACTERISTIC_FIELDS];
+            double value;
+            if (!hasJerry || !splitLine(&line, 1, ':', fields, CHARACTERISTIC_FIELDS)
+                || !parseDoubleField(fields[1], &value)) {
+                return failure;
+            }
+            state = onCharacteristic(context, fields[0], value);
+        }
+        else { // Jerry line
+            char* fields[JERRY_FIELDS];
+            int happiness;
+            if (!splitLine(&line, 0, ',', fields, JERRY_FIELDS) || !parseIntField(fields[3], &happiness)) {
+                return failure;
+            }
+            state = onJerry(context, fields[0], fields[1], fields[2], happiness);
+            hasJerry = true;
+        }
+        if (state != success) return state;
+    }
+    return success;
+}
+
+static status parseJerries(Tokenizer* tokenizer, ConfigHandlers* handlers) {
+    Line line;
+    // skip "Jerries" header
+    if (!nextLine(tokenizer, &line)) return failure;
+
+    return parseJerryRecords(tokenizer, handlers->context, handlers->onJerry, handlers->onCharacteristic);
+}
+
+
+
+// Parallel parsing helper functions:
+
+// returns the start of the first Jerry line after an offset, a chunk never starts inside a record
+// empty lines are skipped too, so a chunk starts exactly where the sequential parser would see a Jerry
+static size_t nextRecordStart(const char* data, size_t offset, size_t end) {
+    while (offset < end) {
+        const char* lineEnd = memchr(data + offset, '\n', end - offset);
+        if (!lineEnd) {
+            return end;
+        }
+        offset = (size_t)(lineEnd - data) + 1;
+        if (offset < end && data[offset] != '\t' && data[offset] != '\n' && data[offset] != '\r') {
+            return offset;
+        }
+    }
+    return end;
+}
+
+// splits the section [start, end) into at most maxChunks chunks of about the same size, returns the number of chunks
+static int splitIntoChunks(const char* data, size_t start, size_t end, int maxChunks, ConfigChunk* chunks) {
+    int count = 0;
+    size_t chunkStart = start;
+    for (int i = 1; i <= maxChunks && chunkStart < end; i++) {
+        size_t chunkEnd = end;
+        if (i < maxChunks) {
+            size_t target = start + (end - start) / (size_t)maxChunks * (size_t)i;
+            chunkEnd = nextRecordStart(data, target > chunkStart ? target : chunkStart, end);
+        }
+        if (chunkEnd == chunkStart) {
+            continue;
+        }
+        chunks[count].start = chunkStart;
+        chunks[count].end = chunkEnd;
+        chunks[count].context = NULL;
+        chunks[count].state = success;
+        count++;
+        chunkStart = chunkEnd;
+    }
+    return count;
+}
+
+// thread function, parses chunks until none are left, every chunk gets its own tokenizer over the shared buffer
+static void* parseChunks(void* argument) {
+    ChunkWork* work = (ChunkWork*)argument;
+    ConfigParallelHandlers* handlers = work->handlers;
+    size_t* offsets = (size_t*)malloc(SCAN_WINDOW * sizeof(size_t));
+
+    int index;
+    while ((index = __atomic_fetch_add(&work->next, 1, __ATOMIC_RELAXED)) < work->count) {
+        ConfigChunk* chunk = &work->chunks[index];
+        chunk->context = offsets ? handlers->createChunk(handlers->context) : NULL;
+        if (!chunk->context) {
+            chunk->state = memory_problem;
+            continue;
+        }
+        // the chunks don't overlap, so terminating fields in place never touches another thread's bytes
+        Tokenizer tokenizer = { work->data, chunk->end, chunk->start, chunk->start, offsets, 0, 0 };
+        chunk->state = parseJerryRecords(&tokenizer, chunk->context, handlers->onJerry, handlers->onCharacteristic);
+    }
+    free(offsets);
+    return NULL;
+}
+
+static status parseJerriesParallel(Tokenizer* tokenizer, ConfigParallelHandlers* handlers, int threads) {
+    Line line;
+    // skip "Jerries" header
+    if (!nextLine(tokenizer, &line)) return failure;
+
+    size_t start = tokenizer->cursor;
+    size_t end = tokenizer->length;
+    size_t sizeChunks = (end - start) / MIN_CHUNK_SIZE;
+    int maxChunks = threads > 1 ? threads * CHUNKS_PER_THREAD : 1;
+    if ((size_t)maxChunks > sizeChunks) {
+        maxChunks = sizeChunks > 0 ? (int)sizeChunks : 1;
+    }
+
+    ConfigChunk* chunks = (ConfigChunk*)malloc(maxChunks * sizeof(ConfigChunk));
+    if (!chunks) {
+        return memory_problem;
+    }
+    ChunkWork work = { tokenizer->data, chunks, 0, 0, handlers };
+    work.count = splitIntoChunks(tokenizer->data, start, end, maxChunks, chunks);
+
+    // the calling thread parses too, a worker that can't be started just leaves more chunks to the others
+    int workers = threads < work.count ? threads - 1 : work.count - 1;
+    pthread_t* ids = workers > 0 ? (pthread_t*)malloc(workers * sizeof(pthread_t)) : NULL;
+    int started = 0;
+    while (ids && started < workers && pthread_create(&ids[started], NULL, parseChunks, &work) == 0) {
+        started++;
+    }
+    parseChunks(&work);
+    for (int i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    free(ids);
+
+    // merge in file order and stop at the first failure, like the sequential parser would
+    status state = success;
+    for (int i = 0; i < work.count; i++) {
+        if (state == success && chunks[i].context) {
+            state = handlers->mergeChunk(handlers->context, chunks[i].context);
+        }
+        if (state == success) {
+            state = chunks[i].state;
+        }
+        if (chunks[i].context) {
+            handlers->destroyChunk(chunks[i].context);
+        }
+    }
+    free(chunks);
+    return state;
+}
+
+
+
+// Index helper functions:
+
+// djb2 over a text that is not terminated
+static size_t hashText(const char* text, size_t length) {
+    size_t hash = 5381;
+    for (size_t i = 0; i < length; i++) {
+        hash = hash * 33 + (unsigned char)text[i];
+    }
+    return hash;
+}
+
+// offset of the first delimiter of a kind in a line of the given length, or the length if there is none
+static size_t findDelimiter(Line* line, char delimiter, size_t length) {
+    for (int i = 0; i < line->count; i++) {
+        if (line->start[line->delimiters[i]] == delimiter) {
+            return line->delimiters[i];
+        }
+    }
+    if (line->overflow) {
+        const char* position = memchr(line->start, delimiter, length);
+        return position ? (size_t)(position - line->start) : length;
+    }
+    return length;
+}
+
+// true if the ID of a record is exactly the text, the ID ends at the first ',' of the Jerry line
+static bool isRecordID(ConfigIndex index, uint32_t record, const char* id, size_t length) {
+    const char* start = index->buffer.data + index->records[record];
+    return memcmp(start, id, length) == 0 && start[length] == ',';
+}
+
+// returns the slot of an ID, either the one holding it or the empty one it would go to
+static size_t findIDSlot(ConfigIndex index, const char* id, size_t length) {
+    size_t mask = index->idSize - 1;
+    size_t slot = hashText(id, length) & mask;
+    while (index->idSlots[slot] && !isRecordID(index, index->idSlots[slot] - 1, id, length)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static size_t findNameSlot(ConfigIndex index, const char* name, size_t length) {
+    size_t mask = index->nameSize - 1;
+    size_t slot = hashText(name, length) & mask;
+    while (index->nameSlots[slot]) {
+        IndexedName* entry = &index->names[index->nameSlots[slot] - 1];
+        if (entry->length == length && memcmp(index->buffer.data + entry->start, name, length) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// doubles an open addressing table once it is half full, the keys are read back from the buffer
+static status growIDSlots(ConfigIndex index) {
+    if ((size_t)index->count * 2 < index->idSize) {
+        return success;
+    }
+    uint32_t* old = index->idSlots;
+    size_t oldSize = index->idSize;
+    index->idSize = oldSize ? oldSize * 2 : INITIAL_INDEX_SIZE;
+    index->idSlots = (uint32_t*)calloc(index->idSize, sizeof(uint32_t));
+    if (!index->idSlots) {
+        index->idSlots = old;
+        index->idSize = oldSize;
+        return memory_problem;
+    }
+    for (size_t i = 0; i < oldSize; i++) {
+        if (old[i]) {
+            size_t start = index->records[old[i] - 1];
+            const char* id = index->buffer.data + start;
+            size_t length = (size_t)((const char*)memchr(id, ',', index->buffer.length - start) - id);
+            index->idSlots[findIDSlot(index, id, length)] = old[i];
+        }
+    }
+    free(old);
+    return success;
+}
+
+static status growNameSlots(ConfigIndex index) {
+    if ((size_t)index->nameCount * 2 < index->nameSize) {
+        return success;
+    }
+    uint32_t* old = index->nameSlots;
+    size_t oldSize = index->nameSize;
+    index->nameSize = oldSize ? oldSize * 2 : INITIAL_INDEX_SIZE;
+    index->nameSlots = (uint32_t*)calloc(index->nameSize, sizeof(uint32_t));
+    if (!index->nameSlots) {
+        index->nameSlots = old;
+        index->nameSize = oldSize;
+        return memory_problem;
+    }
+    for (size_t i = 0; i < oldSize; i++) {
+        if (old[i]) {
+            IndexedName* entry = &index->names[old[i] - 1];
+            index->nameSlots[findNameSlot(index, index->buffer.data + entry->start, entry->length)] = old[i];
+        }
+    }
+    free(old);
+    return success;
+}
+
+// grows an array to hold one more element
+static status reserveOne(void** array, size_t count, size_t* capacity, size_t size) {
+    if (count < *capacity) {
+        return success;
+    }
+    size_t grown = *capacity ? *capacity * 2 : INITIAL_INDEX_SIZE;
+    void* larger = realloc(*array, grown * size);
+    if (!larger) {
+        return memory_problem;
+    }
+    *array = larger;
+    *capacity = grown;
+    return success;
+}
+
+// adds the Jerry line starting at an offset, whose ID has the given length, a repeated ID fails
+static status indexJerryLine(ConfigIndex index, size_t start, size_t idLength) {
+    size_t capacity = (size_t)index->capacity;
+    // one more slot for the end of the section
+    if (reserveOne((void**)&index->records, (size_t)index->count + 1, &capacity, sizeof(size_t)) != success
+        || growIDSlots(index) != success) {
+        return memory_problem;
+    }
+    index->capacity = (int)capacity;
+    index->records[index->count] = start;
+
+    size_t slot = findIDSlot(index, index->buffer.data + start, idLength);
+    if (index->idSlots[slot]) {
+        return failure;
+    }
+    index->idSlots[slot] = (uint32_t)index->count + 1;
+    index->count++;
+    return success;
+}
+
+// adds a characteristic of the last Jerry, the name starts at an offset
+static status indexCharacteristicLine(ConfigIndex index, size_t start, size_t length) {
+    if (growNameSlots(index) != success) {
+        return memory_problem;
+    }
+    size_t slot = findNameSlot(index, index->buffer.data + start, length);
+    if (!index->nameSlots[slot]) {
+        size_t capacity = (size_t)index->nameCapacity;
+        if (reserveOne((void**)&index->names, (size_t)index->nameCount, &capacity, sizeof(IndexedName)) != success) {
+            return memory_problem;
+        }
+        index->nameCapacity = (int)capacity;
+        IndexedName* entry = &index->names[index->nameCount];
+        entry->start = start;
+        entry->length = length;
+        entry->count = 0;
+        entry->lastRecord = -1;
+        index->nameSlots[slot] = (uint32_t)++index->nameCount;
+    }
+
+    uint32_t name = index->nameSlots[slot] - 1;
+    int record = index->count - 1;
+    if (index->names[name].lastRecord == record) {
+        return success;
+    }
+    if (reserveOne((void**)&index->found, index->foundCount, &index->foundCapacity, sizeof(NamePosting)) != success) {
+        return memory_problem;
+    }
+    index->names[name].lastRecord = record;
+    index->names[name].count++;
+    index->found[index->foundCount].name = name;
+    index->found[index->foundCount].record = (uint32_t)record;
+    index->foundCount++;
+    return success;
+}
+
+// finds the records and the characteristic names of the Jerries section, without parsing any field
+// only the ID of a Jerry line and the name of a characteristic line are checked here,
+// the rest of a record is checked when it is parsed
+static status indexJerries(ConfigIndex index, Tokenizer* tokenizer) {
+    Line line;
+    // skip "Jerries" header
+    if (!nextLine(tokenizer, &line)) return failure;
+
+    size_t lineEnd;
+    while (findLine(tokenizer, &line, &lineEnd)) {
+        size_t start = (size_t)(line.start - tokenizer->data);
+        size_t length = lineEnd - start;
+        if (length > 0 && line.start[length - 1] == '\r') {
+            length--;
+        }
+        if (length == 0) continue;
+
+        status state;
+        if (*line.start == '\t') { // characteristic line
+            size_t colon = findDelimiter(&line, ':', length);
+            if (index->count == 0 || colon <= 1 || colon + 1 >= length) {
+                return failure;
+            }
+            state = indexCharacteristicLine(index, start + 1, colon - 1);
+        }
+        else { // Jerry line
+            size_t comma = findDelimiter(&line, ',', length);
+            if (comma == 0 || comma >= length) {
+                return failure;
+            }
+            state = indexJerryLine(index, start, comma);
+        }
+        if (state != success) return state;
+    }
+    if (index->count == 0 && !index->records) {
+        index->records = (size_t*)malloc(sizeof(size_t));
+        if (!index->records) return memory_problem;
+    }
+    index->records[index->count] = tokenizer->length;
+    return success;
+}
+
+// groups the characteristic lines by name, keeping the file order within each name
+static status buildPostings(ConfigIndex index) {
+    uint32_t first = 0;
+    for (int i = 0; i < index->nameCount; i++) {
+        index->names[i].first = first;
+        first += index->names[i].count;
+        index->names[i].count = 0;
+    }
+    index->postings = (uint32_t*)malloc((index->foundCount + 1) * sizeof(uint32_t));
+    if (!index->postings) {
+        return memory_problem;
+    }
+    for (size_t i = 0; i < index->foundCount; i++) {
+        IndexedName* entry = &index->names[index->found[i].name];
+        index->postings[entry->first + entry->count++] = index->found[i].record;
+    }
+    free(index->found);
+    index->found = NULL;
+    return success;
+}
+
+
+
+// Interface Functions:
+
+status parseConfigurationFile(const char* filename, int numPlanets, ConfigHandlers* handlers) {
+    if (!filename || !handlers || !handlers->onPlanet || !handlers->onJerry || !handlers->onCharacteristic) {
+        return null_pointer;
+    }
+
+    ConfigBuffer buffer;
+    status state = openConfigBuffer(filename, &buffer);
+    if (state != success) {
+        return state;
+    }
+
+    Tokenizer tokenizer = { buffer.data, buffer.length, 0, 0, NULL, 0, 0 };
+    tokenizer.offsets = (size_t*)malloc(SCAN_WINDOW * sizeof(size_t));
+    if (!tokenizer.offsets) {
+        closeConfigBuffer(&buffer);
+        return memory_problem;
+    }
+
+    state = parsePlanets(&tokenizer, numPlanets, handlers);
+    if (state == success) {
+        state = parseJerries(&tokenizer, handlers);
+    }
+
+    free(tokenizer.offsets);
+    closeConfigBuffer(&buffer);
+    return state;
+}
+
+
+status parseConfigurationFileParallel(const char* filename, int numPlanets, ConfigParallelHandlers* handlers, int threads) {
+    if (!filename || !handlers || !handlers->onPlanet || !handlers->createChunk || !handlers->onJerry
+        || !handlers->onCharacteristic || !handlers->mergeChunk || !handlers->destroyChunk) {
+        return null_pointer;
+    }
+
+    ConfigBuffer buffer;
+    status state = openConfigBuffer(filename, &buffer);
+    if (state != success) {
+        return state;
+    }
+
+    Tokenizer tokenizer = { buffer.data, buffer.length, 0, 0, NULL, 0, 0 };
+    tokenizer.offsets = (size_t*)malloc(SCAN_WINDOW * sizeof(size_t));
+    if (!tokenizer.offsets) {
+        closeConfigBuffer(&buffer);
+        return memory_problem;
+    }
+
+    // the planets go first on this thread, so they are complete before any Jerry chunk looks them up
+    ConfigHandlers planetHandlers = { handlers->context, handlers->onPlanet, NULL, NULL };
+    state = parsePlanets(&tokenizer, numPlanets, &planetHandlers);
+    if (state == success) {
+        state = parseJerriesParallel(&tokenizer, handlers, threads > 0 ? threads : 1);
+    }
+
+    free(tokenizer.offsets);
+    closeConfigBuffer(&buffer);
+    return state;
+}
+
+
+ConfigIndex openConfigIndex(const char* filename, int numPlanets, ConfigHandlers* handlers) {
+    if (!filename || !handlers || !handlers->onPlanet || !handlers->onJerry || !handlers->onCharacteristic) {
+        return NULL;
+    }
+    ConfigIndex index = (ConfigIndex)calloc(1, sizeof(struct ConfigIndex_s));
+    if (!index) {
+        return NULL;
+    }
+    if (openConfigBuffer(filename, &index->buffer) != success) {
+        free(index);
+        return NULL;
+    }
+    index->handlers = *handlers;
+
+    Tokenizer tokenizer = { index->buffer.data, index->buffer.length, 0, 0, NULL, 0, 0 };
+    tokenizer.offsets = (size_t*)malloc(SCAN_WINDOW * sizeof(size_t));
+    status state = tokenizer.offsets ? parsePlanets(&tokenizer, numPlanets, handlers) : memory_problem;
+    if (state == success) {
+        state = indexJerries(index, &tokenizer);
+    }
+    if (state == success) {
+        state = buildPostings(index);
+    }
+    free(tokenizer.offsets);
+    if (state != success) {
+        closeConfigIndex(index);
+        return NULL;
+    }
+    // from here on the records are read in the order they are asked for
+    if (index->buffer.mapped) {
+        madvise(index->buffer.data, index->buffer.length, MADV_RANDOM);
+    }
+    return index;
+}
+
+
+void closeConfigIndex(ConfigIndex index) {
+    if (!index) {
+        return;
+    }
+    closeConfigBuffer(&index->buffer);
+    free(index->records);
+    free(index->idSlots);
+    free(index->names);
+    free(index->nameSlots);
+    free(index->found);
+    free(index->postings);
+    free(index);
+}
+
+
+int getConfigJerryCount(ConfigIndex index) {
+    return index ? index->count : 0;
+}
+
+
+int findConfigJerry(ConfigIndex index, const char* id) {
+    if (!index || !id || index->count == 0) {
+        return -1;
+    }
+    uint32_t found = index->idSlots[findIDSlot(index, id, strlen(id))];
+    return found ? (int)found - 1 : -1;
+}
+
+
+int findConfigCharacteristic(ConfigIndex index, const char* name, const uint32_t** records) {
+    if (!index || !name || !records || index->nameCount == 0) {
+        return 0;
+    }
+    uint32_t found = index->nameSlots[findNameSlot(index, name, strlen(name))];
+    if (!found) {
+        return 0;
+    }
+    IndexedName* entry = &index->names[found - 1];
+    *records = index->postings + entry->first;
+    return (int)entry->count;
+}
+
+
+status parseConfigJerry(ConfigIndex index, int record) {
+    if (!index) {
+        return null_pointer;
+    }
+    if (record < 0 || record >= index->count) {
+        return failure;
+    }
+    // the record is tokenized in a copy, so the mapping is never written and can be parsed again
+    size_t length = index->records[record + 1] - index->records[record];
+    size_t window = length < SCAN_WINDOW ? length : SCAN_WINDOW;
+    size_t* offsets = (size_t*)malloc(window * sizeof(size_t) + length);
+    if (!offsets) {
+        return memory_problem;
+    }
+    char* copy = (char*)(offsets + window);
+    memcpy(copy, index->buffer.data + index->records[record], length);
+
+    Tokenizer tokenizer = { copy, length, 0, 0, offsets, 0, 0 };
+    status state = parseJerryRecords(&tokenizer, index->handlers.context, index->handlers.onJerry,
+                                     index->handlers.onCharacteristic);
+    free(offsets);
+    return state;
+}
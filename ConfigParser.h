@@ -0,0 +1,161 @@
+#ifndef CONFIGPARSER_H
+#define CONFIGPARSER_H
+#include "Defs.h"
+#include <stdint.h>
+
+
+/**
+ * Welcome to the Configuration Parser module!
+ * This module reads a JerryBoree configuration file (a Planets section followed by a Jerries
+ * section, see README.md) and hands every record to callbacks supplied by the caller.
+ * The file is memory mapped and tokenized in place: the fields handed to the callbacks point
+ * straight into the mapping, so no line is ever copied and there is no limit on line length.
+ * The mapping is private, terminating the fields in place never changes the file itself.
+ * Line ends and field delimiters are located ahead of time, a window at a time, by the vectorized
+ * structural scanner (see StructuralScanner.h), and the records are built from those offsets.
+ * To use this module, users must provide callback functions for:
+ * - A planet record
+ * - A Jerry record
+ * - A physical characteristic record (belongs to the last Jerry record)
+ * The Jerries section can also be parsed on several threads (see parseConfigurationFileParallel),
+ * in which case the records are collected per chunk and merged back in file order.
+ * A file can also be opened as an index (see openConfigIndex): only the positions of the Jerry records
+ * are read up front, and a record is parsed the first time it is asked for.
+ */
+
+
+/**
+ * Callbacks and context for the parser.
+ * The strings passed to the callbacks are only valid during the call, they must be copied to be kept.
+ * A callback that does not return success stops the parsing, and its status is returned by the parser.
+ */
+typedef struct ConfigHandlers_t {
+    void* context; // passed back as the first argument of every callback
+    status (*onPlanet)(void* context, char* name, double x, double y, double z);
+    status (*onJerry)(void* context, char* id, char* dimension, char* planetName, int happiness);
+    status (*onCharacteristic)(void* context, char* name, double value);
+} ConfigHandlers;
+
+
+
+/**
+ * Parses a configuration file and calls the handlers for every record, in file order
+ * @param filename Path of the configuration file
+ * @param numPlanets The number of planet lines following the Planets header
+ * @param handlers The callbacks to call (all must be non-NULL)
+ * @return Operation status indicating success, failure if the file can't be read or is not properly formatted,
+ * memory problem, null pointer if received NULL in parameters, or the first non success status of a callback
+ */
+status parseConfigurationFile(const char* filename, int numPlanets, ConfigHandlers* handlers);
+
+
+
+/**
+ * Callbacks and context for the parallel parser.
+ * The planets are handed to onPlanet on the calling thread, before any worker starts.
+ * The Jerries section is then split into chunks at record boundaries (a Jerry line and its characteristic lines),
+ * and every chunk is parsed on a worker thread into its own chunk context, so the chunk callbacks
+ * never share state with each other. createChunk is called on the worker threads too and must be thread safe.
+ * Once all the chunks are parsed, they are merged on the calling thread one at a time in file order,
+ * so the merged result does not depend on how the chunks were scheduled.
+ * If a chunk failed, the records it parsed before the failure are still merged and its status is returned,
+ * exactly like the sequential parser stops at the first failing record.
+ */
+typedef struct ConfigParallelHandlers_t {
+    void* context; // passed back to onPlanet, createChunk and mergeChunk
+    status (*onPlanet)(void* context, char* name, double x, double y, double z);
+    void* (*createChunk)(void* context); // returns the context of a new chunk, or NULL on failure
+    status (*onJerry)(void* chunk, char* id, char* dimension, char* planetName, int happiness);
+    status (*onCharacteristic)(void* chunk, char* name, double value);
+    status (*mergeChunk)(void* context, void* chunk);
+    void (*destroyChunk)(void* chunk); // called for every chunk, merged or not
+} ConfigParallelHandlers;
+
+
+
+/**
+ * Parses a configuration file like parseConfigurationFile, with the Jerries section split between threads
+ * A small Jerries section is parsed as a single chunk on the calling thread
+ * @param filename Path of the configuration file
+ * @param numPlanets The number of planet lines following the Planets header
+ * @param handlers The callbacks to call (all must be non-NULL)
+ * @param threads The number of threads to parse on, including the calling thread
+ * @return Operation status indicating success, failure if the file can't be read or is not properly formatted,
+ * memory problem, null pointer if received NULL in parameters, or the first non success status of a callback in file order
+ */
+status parseConfigurationFileParallel(const char* filename, int numPlanets, ConfigParallelHandlers* handlers, int threads);
+
+
+
+/**
+ * A configuration file opened as an index over its Jerries section
+ */
+typedef struct ConfigIndex_s* ConfigIndex;
+
+
+
+/**
+ * Opens a configuration file, parses its planets and indexes its Jerries without parsing them
+ * The planets are handed to onPlanet right away. The Jerries section is read once to find where every Jerry
+ * record starts, keyed by its ID, and which records have every characteristic name, the other fields
+ * are left in the mapped file until the record is parsed by parseConfigJerry.
+ * The file stays mapped but is never written, so the pages of records that are not used stay in the page cache.
+ * @param filename Path of the configuration file
+ * @param numPlanets The number of planet lines following the Planets header
+ * @param handlers The callbacks to call (all must be non-NULL), copied into the index,
+ * onJerry and onCharacteristic are called later by parseConfigJerry
+ * @return The index, or NULL if the file can't be read, its planets or its record structure are not properly formatted,
+ * two Jerries have the same ID, a callback failed or memory ran out
+ */
+ConfigIndex openConfigIndex(const char* filename, int numPlanets, ConfigHandlers* handlers);
+
+
+
+/**
+ * Closes an index and unmaps its file
+ * @param index The index to close (may be NULL)
+ */
+void closeConfigIndex(ConfigIndex index);
+
+
+
+/**
+ * @param index The index
+ * @return The number of Jerry records in the file, 0 if index is NULL
+ */
+int getConfigJerryCount(ConfigIndex index);
+
+
+
+/**
+ * Finds the record of a Jerry by ID, without parsing it
+ * @param index The index
+ * @param id The ID to find
+ * @return The record number of the Jerry, or -1 if no record has the ID
+ */
+int findConfigJerry(ConfigIndex index, const char* id);
+
+
+
+/**
+ * Finds the records of the Jerries that have a physical characteristic, without parsing them
+ * @param index The index
+ * @param name The characteristic name
+ * @param records Set to the record numbers, in file order, valid until the index is closed
+ * @return The number of records, 0 if none has the characteristic
+ */
+int findConfigCharacteristic(ConfigIndex index, const char* name, const uint32_t** records);
+
+
+
+/**
+ * Parses one Jerry record and hands it to the onJerry and onCharacteristic callbacks of the index
+ * @param index The index
+ * @param record The record number
+ * @return Operation status indicating success, failure if the record is out of range or not properly formatted,
+ * memory problem, null pointer if index is NULL, or the first non success status of a callback
+ */
+status parseConfigJerry(ConfigIndex index, int record);
+
+
+#endif //CONFIGPARSER_H
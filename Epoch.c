@@ -0,0 +1,171 @@
+#include "Epoch.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define EPOCH_SLOTS 64 // threads beyond this share slots, which is still correct
+#define CACHE_LINE 64
+
+
+/* The pins of the threads that use one slot, counted apart for even and odd epochs, alone on its cache line */
+typedef struct EpochSlot_t {
+    _Alignas(CACHE_LINE) atomic_long readers[2];
+} EpochSlot;
+
+
+/* A block waiting for the readers of its epoch */
+typedef struct RetiredBlock_t {
+    void* memory;
+    void (*release)(void* memory);
+    long epoch; // the epoch it was retired in
+    struct RetiredBlock_t* next;
+} RetiredBlock;
+
+
+struct EpochDomain_s {
+    EpochSlot slots[EPOCH_SLOTS];
+    _Alignas(CACHE_LINE) atomic_long epoch;
+    pthread_mutex_t retiring; // held to retire, to move the epoch on and to take blocks to release
+    RetiredBlock* retired;    // newest first
+};
+
+
+// every thread gets the next slot the first time it pins
+static atomic_int nextSlot;
+static _Thread_local int threadSlot = -1;
+
+static EpochSlot* getThreadSlot(EpochDomain domain) {
+    if (threadSlot < 0) {
+        threadSlot = atomic_fetch_add(&nextSlot, 1) % EPOCH_SLOTS;
+    }
+    return &domain->slots[threadSlot];
+}
+
+
+// moves the epoch on unless a reader is still pinned at the one before, the caller holds the retiring mutex
+// the readers are only ever in the current epoch or the one before, which has the parity of the next one
+static bool advanceEpoch(EpochDomain domain) {
+    long epoch = atomic_load(&domain->epoch);
+    for (int i = 0; i < EPOCH_SLOTS; i++) {
+        if (atomic_load(&domain->slots[i].readers[(epoch + 1) & 1]) > 0) {
+            return false;
+        }
+    }
+    atomic_store(&domain->epoch, epoch + 1);
+    return true;
+}
+
+
+// releases a list of blocks
+static void releaseBlocks(RetiredBlock* block) {
+    while (block) {
+        RetiredBlock* next = block->next;
+        block->release(block->memory);
+        free(block);
+        block = next;
+    }
+}
+
+
+
+// Interface Functions:
+
+EpochDomain createEpochDomain() {
+    EpochDomain domain = (EpochDomain)aligned_alloc(CACHE_LINE, sizeof(struct EpochDomain_s));
+    if (!domain) {
+        return NULL;
+    }
+    for (int i = 0; i < EPOCH_SLOTS; i++) {
+        atomic_init(&domain->slots[i].readers[0], 0);
+        atomic_init(&domain->slots[i].readers[1], 0);
+    }
+    atomic_init(&domain->epoch, 0);
+    domain->retired = NULL;
+    if (pthread_mutex_init(&domain->retiring, NULL) != 0) {
+        free(domain);
+        return NULL;
+    }
+    return domain;
+}
+
+
+void destroyEpochDomain(EpochDomain domain) {
+    if (!domain) {
+        return;
+    }
+    releaseBlocks(domain->retired);
+    pthread_mutex_destroy(&domain->retiring);
+    free(domain);
+}
+
+
+long pinEpoch(EpochDomain domain) {
+    EpochSlot* slot = getThreadSlot(domain);
+    while (true) {
+        // announce the reader first, then make sure the epoch didn't move on meanwhile
+        long epoch = atomic_load(&domain->epoch);
+        atomic_fetch_add(&slot->readers[epoch & 1], 1);
+        if (atomic_load(&domain->epoch) == epoch) {
+            return epoch;
+        }
+        atomic_fetch_sub(&slot->readers[epoch & 1], 1);
+    }
+}
+
+
+void unpinEpoch(EpochDomain domain, long epoch) {
+    atomic_fetch_sub_explicit(&getThreadSlot(domain)->readers[epoch & 1], 1, memory_order_release);
+}
+
+
+void retireInEpoch(EpochDomain domain, void* memory, void (*release)(void* memory)) {
+    RetiredBlock* block = (RetiredBlock*)malloc(sizeof(RetiredBlock));
+    pthread_mutex_lock(&domain->retiring);
+    long epoch = atomic_load(&domain->epoch);
+    if (block) {
+        block->memory = memory;
+        block->release = release;
+        block->epoch = epoch;
+        block->next = domain->retired;
+        domain->retired = block;
+        pthread_mutex_unlock(&domain->retiring);
+        return;
+    }
+    // out of memory, wait here until the readers that may see the block are gone
+    while (atomic_load(&domain->epoch) < epoch + 2) {
+        if (!advanceEpoch(domain)) {
+            pthread_mutex_unlock(&domain->retiring);
+            sched_yield();
+            pthread_mutex_lock(&domain->retiring);
+        }
+    }
+    pthread_mutex_unlock(&domain->retiring);
+    release(memory);
+}
+
+
+void reclaimEpochs(EpochDomain domain) {
+    if (!domain) {
+        return;
+    }
+    pthread_mutex_lock(&domain->retiring);
+    if (!domain->retired) {
+        pthread_mutex_unlock(&domain->retiring);
+        return;
+    }
+    // with no reader left behind, the blocks retired just now are two epochs away
+    if (advanceEpoch(domain)) {
+        advanceEpoch(domain);
+    }
+    long epoch = atomic_load(&domain->epoch);
+
+    // the list is newest first, so the blocks old enough are all at its end
+    RetiredBlock** link = &domain->retired;
+    while (*link && (*link)->epoch + 2 > epoch) {
+        link = &(*link)->next;
+    }
+    RetiredBlock* released = *link;
+    *link = NULL;
+    pthread_mutex_unlock(&domain->retiring);
+    releaseBlocks(released);
+}
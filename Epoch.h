@@ -0,0 +1,72 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the Epoch module!
+ * This module frees shared memory only once no reader can still be looking at it, so readers need no lock.
+ * A reader pins the current epoch while it uses the shared memory and unpins it when done.
+ * A writer first makes a block unreachable for new readers, then retires it: the block is released once every
+ * reader that was pinned at that time is gone. The epoch moves on whenever no reader is left two epochs behind,
+ * so a block retired in an epoch is released two epochs later.
+ * Like the ReadWriteLock, every thread counts its pins on a cache line of its own, so pinning on many cores
+ * never writes to the same memory.
+ */
+
+
+/**
+ * The epochs of some shared memory and the blocks that wait to be released
+ */
+typedef struct EpochDomain_s* EpochDomain;
+
+
+
+/**
+ * Creates a domain with no pinned readers and nothing retired
+ * @return The domain, or NULL if memory ran out
+ */
+EpochDomain createEpochDomain();
+
+
+
+/**
+ * Releases every retired block and frees the domain, no reader may be pinned anymore
+ * @param domain The domain (may be NULL)
+ */
+void destroyEpochDomain(EpochDomain domain);
+
+
+
+/**
+ * Pins the current epoch, the shared memory read from now on stays valid until it is unpinned
+ * A thread may pin a domain many times, every pin is undone by its own unpin
+ * @param domain The domain
+ * @return The pinned epoch, to be passed to unpinEpoch
+ */
+long pinEpoch(EpochDomain domain);
+void unpinEpoch(EpochDomain domain, long epoch);
+
+
+
+/**
+ * Releases a block once the readers pinned now are gone, the block must not be reachable by new readers anymore
+ * If memory runs out the writer waits for those readers and releases the block itself, so a pinned thread must
+ * never retire a block
+ * @param domain The domain
+ * @param memory The block
+ * @param release Releases the block
+ */
+void retireInEpoch(EpochDomain domain, void* memory, void (*release)(void* memory));
+
+
+
+/**
+ * Moves the epoch on if the readers allow it and releases the blocks no reader can see anymore
+ * Writers call it after retiring, and idle threads call it so blocks don't wait for the next writer
+ * @param domain The domain
+ */
+void reclaimEpochs(EpochDomain domain);
+
+
+#endif //EPOCH_H
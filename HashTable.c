@@ -4,11 +4,25 @@
 #include "HashTable.h"
 #include "LinkedList.h"
 #include "KeyValuePair.h"
+#include <pthread.h>
+
+#define CACHE_LINE 64
+
+
+/* A part of the table with buckets of its own, alone on its cache line */
+typedef struct HashStripe_t {
+    _Alignas(CACHE_LINE) LinkedList* buckets; // LinkedList for chaining
+    int size; // number of buckets
+    int count; // number of stored pairs, the stripe grows once it exceeds the size
+    pthread_rwlock_t lock; // only set up when the table is concurrent
+} HashStripe;
+
 
 struct hashTable_s {
 
-    LinkedList* buckets; // LinkedList for chaining
-    int size; // size of the hash table
+    HashStripe* stripes; // a key always goes to the same stripe, a plain table has just one
+    int stripeCount;
+    bool concurrent; // the stripes have locks, a plain table never takes one
 
     // key functions
 
@@ -79,16 +93,41 @@ static KeyValuePair createEntry(hashTable table, Element key, Element value) {
 
 
 
-// internal function to get the bucket index for a key
-static int getBucketIndex(hashTable table, Element key) {
+// internal function to get the stripe of a key and the hash that picked it, NULL if the key has no hash
+static HashStripe* getStripe(hashTable table, Element key, int* hashVal) {
     if (!table || !key) {
-        return -1;
+        return NULL;
     }
-    int hashVal = table->transformFuncKey(key);
-    if (hashVal < 0) {
-        return -1;
+    *hashVal = table->transformFuncKey(key);
+    if (*hashVal < 0) {
+        return NULL;
+    }
+    return &table->stripes[*hashVal % table->stripeCount];
+}
+
+// internal function to get the bucket index of a hash in a stripe of a given size
+// the stripe was picked by the remainder, so the quotient is what spreads the keys of one stripe
+static int getBucketIndexForSize(hashTable table, int hashVal, int size) {
+    return hashVal / table->stripeCount % size;
+}
+
+
+// helper function to find the smallest prime number larger or equal to a given number
+static int nextPrime(int number) {
+    if (number <= 2) {
+        return 2;
+    }
+    int candidate = number % 2 == 0 ? number + 1 : number;
+    while (true) {
+        bool prime = true;
+        for (int i = 3; i * i <= candidate && prime; i += 2) {
+            prime = candidate % i != 0;
+        }
+        if (prime) {
+            return candidate;
+        }
+        candidate += 2;
     }
-    return hashVal % table->size;
 }
 
 
@@ -119,11 +158,93 @@ static LinkedList* initializeBuckets(int size, status* state) {
 
 
 
-hashTable createHashTable(CopyFunction copyKey, FreeFunction freeKey, PrintFunction printKey,
+// helper function to move every pair of a stripe to about twice as many buckets, keeping the chains short
+static status growHashTable(hashTable table, HashStripe* stripe) {
+    int newSize = nextPrime(stripe->size * 2 + 1);
+    status bucketState;
+    LinkedList* newBuckets = initializeBuckets(newSize, &bucketState);
+    if (bucketState != success) {
+        return bucketState;
+    }
+
+    for (int i = 0; i < stripe->size; i++) {
+        LinkedList bucket = stripe->buckets[i];
+        for (int j = 1; j < getLengthList(bucket) + 1; j++) {
+            KeyValuePair pair = getDataByIndex(bucket, j);
+            int hashVal;
+            if (!getStripe(table, getKeyReference(pair), &hashVal)
+                || appendNode(newBuckets[getBucketIndexForSize(table, hashVal, newSize)], pair) != success) {
+                // the pairs are still owned by the old buckets, only drop the new ones
+                for (int k = 0; k < newSize; k++) {
+                    destroyListShallow(newBuckets[k]);
+                }
+                free(newBuckets);
+                return memory_problem;
+            }
+        }
+    }
+
+    // the pairs now belong to the new buckets
+    for (int i = 0; i < stripe->size; i++) {
+        destroyListShallow(stripe->buckets[i]);
+    }
+    free(stripe->buckets);
+    stripe->buckets = newBuckets;
+    stripe->size = newSize;
+    return success;
+}
+
+
+// helper functions to take and release the lock of a stripe, they do nothing on a plain table
+static void readStripe(hashTable table, HashStripe* stripe) {
+    if (table->concurrent) {
+        pthread_rwlock_rdlock(&stripe->lock);
+    }
+}
+
+static void writeStripe(hashTable table, HashStripe* stripe) {
+    if (table->concurrent) {
+        pthread_rwlock_wrlock(&stripe->lock);
+    }
+}
+
+static void releaseStripe(hashTable table, HashStripe* stripe) {
+    if (table->concurrent) {
+        pthread_rwlock_unlock(&stripe->lock);
+    }
+}
+
+
+// helper function to find the pair of a key in its stripe, the caller holds the lock of the stripe
+static KeyValuePair findInStripe(hashTable table, HashStripe* stripe, int hashVal, Element key) {
+    return searchByKeyInList(stripe->buckets[getBucketIndexForSize(table, hashVal, stripe->size)], key);
+}
+
+
+// helper function to release the stripes of a table, including a partially built one
+static void destroyStripes(hashTable table) {
+    for (int i = 0; i < table->stripeCount; i++) {
+        HashStripe* stripe = &table->stripes[i];
+        if (stripe->buckets) {
+            for (int j = 0; j < stripe->size; j++) {
+                destroyList(stripe->buckets[j]);
+            }
+            free(stripe->buckets);
+        }
+        if (table->concurrent) {
+            pthread_rwlock_destroy(&stripe->lock);
+        }
+    }
+    free(table->stripes);
+}
+
+
+// helper function to create a table of a number of stripes, each of them with a lock if the table is concurrent
+static hashTable createStripedHashTable(CopyFunction copyKey, FreeFunction freeKey, PrintFunction printKey,
 CopyFunction copyValue, FreeFunction freeValue, PrintFunction printValue,
-EqualFunction equalKey, TransformIntoNumberFunction transformIntoNumber, int hashNumber) {
+EqualFunction equalKey, TransformIntoNumberFunction transformIntoNumber, int hashNumber, int stripes, bool concurrent) {
     if (!copyKey || !freeKey || !printKey || !copyValue || !freeValue || !printValue
-        || !equalKey || !transformIntoNumber || hashNumber <= 0) {
+        || !equalKey || !transformIntoNumber || hashNumber <= 0 || stripes <= 0) {
         return NULL;
         }
 
@@ -132,16 +253,37 @@ EqualFunction equalKey, TransformIntoNumberFunction transformIntoNumber, int has
         return NULL;
     }
 
-    status bucketState;
-    table->buckets = initializeBuckets(hashNumber, &bucketState);
-    if (bucketState != success) {
+    // zeroed, so a partially built table can be released by destroyStripes
+    table->stripes = (HashStripe*)aligned_alloc(CACHE_LINE, stripes * sizeof(HashStripe));
+    if (!table->stripes) {
         free(table);
         return NULL;
     }
-
-    // set table size
-
-    table->size = hashNumber;
+    memset(table->stripes, 0, stripes * sizeof(HashStripe));
+    table->concurrent = concurrent;
+
+    // the buckets are shared evenly between the stripes
+    int stripeSize = hashNumber / stripes > 0 ? hashNumber / stripes : 1;
+    for (int i = 0; i < stripes; i++) {
+        // the stripes counted so far have their lock, so a partially built table is released up to here
+        table->stripeCount = i;
+        if (concurrent && pthread_rwlock_init(&table->stripes[i].lock, NULL) != 0) {
+            destroyStripes(table);
+            free(table);
+            return NULL;
+        }
+        table->stripeCount = i + 1;
+        status bucketState;
+        table->stripes[i].buckets = initializeBuckets(stripeSize, &bucketState);
+        if (bucketState == success) {
+            table->stripes[i].size = stripeSize;
+        }
+        else {
+            destroyStripes(table);
+            free(table);
+            return NULL;
+        }
+    }
 
 
     // set key properties
@@ -165,38 +307,47 @@ EqualFunction equalKey, TransformIntoNumberFunction transformIntoNumber, int has
 
 
 
+hashTable createHashTable(CopyFunction copyKey, FreeFunction freeKey, PrintFunction printKey,
+CopyFunction copyValue, FreeFunction freeValue, PrintFunction printValue,
+EqualFunction equalKey, TransformIntoNumberFunction transformIntoNumber, int hashNumber) {
+    return createStripedHashTable(copyKey, freeKey, printKey, copyValue, freeValue, printValue,
+                                  equalKey, transformIntoNumber, hashNumber, 1, false);
+}
+
+
+hashTable createConcurrentHashTable(CopyFunction copyKey, FreeFunction freeKey, PrintFunction printKey,
+CopyFunction copyValue, FreeFunction freeValue, PrintFunction printValue,
+EqualFunction equalKey, TransformIntoNumberFunction transformIntoNumber, int hashNumber, int stripes) {
+    return createStripedHashTable(copyKey, freeKey, printKey, copyValue, freeValue, printValue,
+                                  equalKey, transformIntoNumber, hashNumber, stripes, true);
+}
+
+
+
 status destroyHashTable(hashTable table) {
     if (!table) {
         return null_pointer;
 
     }
 
-    for (int i = 0; i < table->size; i++) {
-        if (table->buckets[i]) {
-            destroyList(table->buckets[i]);
-        }
-    }
-
-    free(table->buckets);
+    destroyStripes(table);
     free(table);
     return success;
 }
 
 
 Element lookupInHashTable(hashTable table, Element key) {
-    if (!table || !key) {
-        return NULL;
-    }
-
-    int index = getBucketIndex(table, key);
-    if (index < 0) {
+    int hashVal;
+    HashStripe* stripe = getStripe(table, key, &hashVal);
+    if (!stripe) {
         return NULL;
     }
 
-    LinkedList bucket = table->buckets[index];
-
-    KeyValuePair foundPair = searchByKeyInList(bucket, key);
-    return foundPair ? getValue(foundPair) : NULL; // as the value is copied in the first place in getValue
+    readStripe(table, stripe);
+    KeyValuePair foundPair = findInStripe(table, stripe, hashVal, key);
+    Element value = foundPair ? getValue(foundPair) : NULL; // as the value is copied in the first place in getValue
+    releaseStripe(table, stripe);
+    return value;
 }
 
 status addToHashTable(hashTable table, Element key,Element value) {
@@ -204,25 +355,38 @@ status addToHashTable(hashTable table, Element key,Element value) {
         return null_pointer;
     }
 
-    if (lookupInHashTable(table, key) != NULL) {
+    int hashVal;
+    HashStripe* stripe = getStripe(table, key, &hashVal); // get the right stripe in the hash table
+    if (!stripe) {
         return failure;
     }
 
-    int index = getBucketIndex(table, key); // get the right index in the hash table
-    if (index < 0) {
-        return failure;
+    writeStripe(table, stripe);
+    status state = success;
+    if (findInStripe(table, stripe, hashVal, key) != NULL) {
+        state = failure;
     }
-    LinkedList bucket = table->buckets[index];
-    KeyValuePair pair = createEntry(table, key, value);
-    if (!pair) {
-        return memory_problem;
+    // grow before the chains get longer than one pair on average
+    else if (stripe->count >= stripe->size) {
+        state = growHashTable(table, stripe);
     }
 
-    status state = appendNode(bucket, pair); // add the node to the linked list
-
-    if (state != success) {
-        destroyKeyValuePair(pair);
+    KeyValuePair pair = NULL;
+    if (state == success) {
+        pair = createEntry(table, key, value);
+        state = pair ? success : memory_problem;
+    }
+    if (state == success) {
+        // add the node to the linked list
+        state = appendNode(stripe->buckets[getBucketIndexForSize(table, hashVal, stripe->size)], pair);
+        if (state != success) {
+            destroyKeyValuePair(pair);
+        }
+        else {
+            stripe->count++;
+        }
     }
+    releaseStripe(table, stripe);
     return state;
 
 }
@@ -233,31 +397,42 @@ status removeFromHashTable(hashTable table, Element key) {
         return null_pointer;
     }
 
-    int index = getBucketIndex(table, key);
-    if (index < 0) {
+    int hashVal;
+    HashStripe* stripe = getStripe(table, key, &hashVal);
+    if (!stripe) {
         return failure;
     }
 
-    LinkedList bucket = table->buckets[index];
-
     // pass the key directly to deleteNode in the LinkedList
 
-    return deleteNode(bucket, key);
+    writeStripe(table, stripe);
+    status state = deleteNode(stripe->buckets[getBucketIndexForSize(table, hashVal, stripe->size)], key);
+    if (state == success) {
+        stripe->count--;
+    }
+    releaseStripe(table, stripe);
+    return state;
 }
 
 status displayHashElements(hashTable table) {
     if (!table) {
         return null_pointer;
     }
-    for (int i = 0; i < table->size; i++) {
-        if (getLengthList(table->buckets[i]) > 0) {
-            status state = displayList(table->buckets[i]);
-            if (state != success) {
-                return state;
+    for (int i = 0; i < table->stripeCount; i++) {
+        HashStripe* stripe = &table->stripes[i];
+        readStripe(table, stripe);
+        status state = success;
+        for (int j = 0; j < stripe->size && state == success; j++) {
+            if (getLengthList(stripe->buckets[j]) > 0) {
+                state = displayList(stripe->buckets[j]);
             }
         }
+        releaseStripe(table, stripe);
+        if (state != success) {
+            return state;
+        }
 
     }
     return success;
 
-}
\ No newline at end of file
+}
@@ -6,6 +6,16 @@
 typedef struct hashTable_s *hashTable;
 
 hashTable createHashTable(CopyFunction copyKey, FreeFunction freeKey, PrintFunction printKey, CopyFunction copyValue, FreeFunction freeValue, PrintFunction printValue, EqualFunction equalKey, TransformIntoNumberFunction transformIntoNumber, int hashNumber);
+
+/**
+ * Creates a table that many threads may use at once
+ * The keys are split by hash between stripes, each with buckets of its own and a reader-writer lock:
+ * lookups never wait for each other, and adds and removes wait only for the users of their own stripe.
+ * A value found by one thread may be removed by another right after, keeping it alive is up to the caller.
+ * @param hashNumber The initial number of buckets, shared evenly between the stripes
+ * @param stripes The number of stripes
+ */
+hashTable createConcurrentHashTable(CopyFunction copyKey, FreeFunction freeKey, PrintFunction printKey, CopyFunction copyValue, FreeFunction freeValue, PrintFunction printValue, EqualFunction equalKey, TransformIntoNumberFunction transformIntoNumber, int hashNumber, int stripes);
 status destroyHashTable(hashTable);
 status addToHashTable(hashTable, Element key,Element value);
 Element lookupInHashTable(hashTable, Element key);
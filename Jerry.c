@@ -2,6 +2,30 @@
 // Created by itaym on 29/11/2024.
 //
 #include "Jerry.h"
+#define PLANET_TEXT_CAPACITY 64 // first buffer size for the cached text of a planet
+#define JERRY_TEXT_CAPACITY 256 // first buffer size for the cached text of a Jerry
+
+// keeps the text of a renderer in a cache, unless another thread filled the cache first
+// returns the text in the cache, NULL if memory ran out
+static RenderedText* publishRenderedText(_Atomic(RenderedText*)* cache, Renderer text, size_t head) {
+    size_t length;
+    char* data = takeRenderedText(text, &length);
+    RenderedText* rendered = data ? (RenderedText*)malloc(sizeof(RenderedText) + length) : NULL;
+    if (rendered) {
+        atomic_init(&rendered->references, 1); // the cache's
+        rendered->length = (int)length;
+        rendered->head = (int)head;
+        memcpy(rendered->text, data, length);
+    }
+    free(data);
+    RenderedText* published = NULL;
+    if (rendered && !atomic_compare_exchange_strong(cache, &published, rendered)) {
+        free(rendered);
+        return published;
+    }
+    return rendered;
+}
+
 
 // planet functions
 Planet* createPlanet(char* name, double x, double y, double z) {
@@ -22,6 +46,7 @@ Planet* createPlanet(char* name, double x, double y, double z) {
     planet->x = x;
     planet->y = y;
     planet->z = z;
+    atomic_init(&planet->rendered, NULL);
 
     return planet;
 }
@@ -33,17 +58,53 @@ status destroyPlanet(Planet* planet) {
     }
     free(planet->name);
     planet->name = NULL;
+    releaseRenderedText(atomic_exchange(&planet->rendered, NULL));
     free(planet);
     planet = NULL;
     return success;
 }
 
-status printPlanet(Planet* planet) {
+static status renderPlanetFields(Renderer renderer, Planet* planet) {
+    status state = renderString(renderer, "Planet : ");
+    if (state == success) state = renderString(renderer, planet->name);
+    if (state == success) state = renderText(renderer, " (", 2);
+    if (state == success) state = renderFixed(renderer, planet->x);
+    if (state == success) state = renderText(renderer, ",", 1);
+    if (state == success) state = renderFixed(renderer, planet->y);
+    if (state == success) state = renderText(renderer, ",", 1);
+    if (state == success) state = renderFixed(renderer, planet->z);
+    if (state == success) state = renderText(renderer, ") \n", 3);
+    return state;
+}
+
+status renderPlanet(Renderer renderer, Planet* planet) {
     if (planet == NULL) {
         return failure;
     }
-    printf("Planet : %s (%.2f,%.2f,%.2f) \n", planet->name, planet->x, planet->y, planet->z);
-    return success;
+    // the coordinates never change, so the line is formatted once
+    RenderedText* rendered = atomic_load_explicit(&planet->rendered, memory_order_acquire);
+    if (!rendered) {
+        Renderer text = createTextRenderer(PLANET_TEXT_CAPACITY);
+        if (text && renderPlanetFields(text, planet) == success) {
+            rendered = publishRenderedText(&planet->rendered, text, 0);
+        }
+        else {
+            destroyRenderer(text);
+        }
+    }
+    if (!rendered) { // out of memory, the line is formatted without the cache
+        return renderPlanetFields(renderer, planet);
+    }
+    return renderText(renderer, rendered->text, rendered->length);
+}
+
+status printPlanet(Planet* planet) {
+    Renderer renderer = getStandardRenderer();
+    status state = renderPlanet(renderer, planet);
+    if (state != success) {
+        return state;
+    }
+    return flushRenderer(renderer);
 }
 
 // origin functions
@@ -52,17 +113,16 @@ Origin* createOrigin(Planet* planet, char* dimension) {
     if (planet == NULL || dimension == NULL) {
         return NULL;
     }
-    Origin* origin = (Origin*)malloc(sizeof(Origin));
+    // one block for the object and its dimension, the dimension starts right after the structure
+    size_t dimension_length = strlen(dimension) + 1;
+    Origin* origin = (Origin*)malloc(sizeof(Origin) + dimension_length);
     if (origin == NULL) {
         return NULL;
     }
-    origin->dimension = (char*)malloc(strlen(dimension) + 1);
-    if (origin->dimension == NULL) {
-        free(origin);
-        return NULL;
-    }
-    strcpy(origin->dimension, dimension);
+    origin->dimension = (char*)(origin + 1);
+    memcpy(origin->dimension, dimension, dimension_length);
     origin->planet = planet;
+    origin->references = 1;
     return origin;
 }
 
@@ -73,32 +133,48 @@ status destroyOrigin(Origin* origin) {
         return failure;
     }
     // notice we don't free the planet here, it might be shared by other Jerries
-    free(origin->dimension);
     origin->dimension = NULL;
     free(origin);
     origin = NULL;
     return success;
 }
 
+
+Origin* retainOrigin(Origin* origin) {
+    if (origin == NULL) {
+        return NULL;
+    }
+    origin->references++;
+    return origin;
+}
+
+
+status releaseOrigin(Origin* origin) {
+    if (origin == NULL) {
+        return failure;
+    }
+    origin->references--;
+    if (origin->references > 0) { // still used by other Jerries
+        return success;
+    }
+    return destroyOrigin(origin);
+}
+
 // physical characteristics functions
 
 PhysicalCharacteristic* createPhysicalCharacteristic(char* name, double value) {
     if (name == NULL) {
         return NULL;
     }
-    // create the array that will store the object
-    PhysicalCharacteristic* characteristic = (PhysicalCharacteristic*)malloc(sizeof(PhysicalCharacteristic));
+    // one block for the object and its name, the name starts right after the structure
+    size_t name_length = strlen(name) + 1;
+    PhysicalCharacteristic* characteristic = (PhysicalCharacteristic*)malloc(sizeof(PhysicalCharacteristic) + name_length);
     if (characteristic == NULL) {
         return NULL;
     }
 
-    characteristic->name = (char*)malloc(strlen(name) + 1); // allocate memory for the name of the characteristic
-    if (characteristic->name == NULL) {
-        free(characteristic);
-        characteristic = NULL;
-        return NULL;
-    }
-    strcpy(characteristic->name, name);
+    characteristic->name = (char*)(characteristic + 1);
+    memcpy(characteristic->name, name, name_length);
 
     characteristic->value = value;
 
@@ -113,39 +189,64 @@ Jerry* createJerry(char* id, int happiness, Planet* planet, char* dimension) {
         return NULL;
     }
 
-    if (happiness < 0 || happiness > 100) {
+    Origin* origin = createOrigin(planet, dimension);
+    if (origin == NULL) {
         return NULL;
     }
 
+    // the Jerry takes its own reference, so we drop ours either way
+    Jerry* jerry = createJerryWithOrigin(id, happiness, origin);
+    releaseOrigin(origin);
+    return jerry;
+}
 
-    Origin* origin = createOrigin(planet, dimension);
-    if (origin == NULL) {
+
+Jerry* createJerryWithOrigin(char* id, int happiness, Origin* origin) {
+    if (id == NULL || origin == NULL) {
         return NULL;
     }
 
-
-    Jerry* jerry = (Jerry*)malloc(sizeof(Jerry));
-    if (jerry == NULL) {
-        destroyOrigin(origin);
+    if (happiness < 0 || happiness > 100) {
         return NULL;
     }
-    jerry->id = (char*)malloc(strlen(id) + 1);
-    if (jerry->id == NULL) {
-        destroyOrigin(origin);
-        free(jerry);
-        jerry = NULL;
+
+    // the block layout is [Jerry][id\0]
+    size_t id_length = strlen(id) + 1;
+    Jerry* jerry = (Jerry*)malloc(sizeof(Jerry) + id_length);
+    if (jerry == NULL) {
         return NULL;
     }
-    strcpy(jerry->id, id);
+
+    jerry->id = (char*)(jerry + 1);
+    memcpy(jerry->id, id, id_length);
 
     jerry->happiness = happiness;
-    jerry->origin = origin;
+    jerry->origin = retainOrigin(origin);
     jerry->characteristics = NULL;
     jerry->num_characteristics = 0;
+    atomic_init(&jerry->rendered, NULL);
     return jerry;
 }
 
 
+// drops the cached text of a Jerry after a change that shows in it
+static void forgetRenderedJerry(Jerry* jerry) {
+    releaseRenderedText(atomic_exchange(&jerry->rendered, NULL));
+}
+
+
+status setJerryOrigin(Jerry* jerry, Origin* origin) {
+    if (jerry == NULL || origin == NULL) {
+        return failure;
+    }
+    retainOrigin(origin);
+    releaseOrigin(jerry->origin);
+    jerry->origin = origin;
+    forgetRenderedJerry(jerry);
+    return success;
+}
+
+
 bool hasPhysicalCharacteristic(Jerry* jerry, char* characteristic_name) {
     if (jerry == NULL || characteristic_name == NULL) {
         return false;
@@ -162,10 +263,8 @@ status destroyPhysicalCharacteristic(PhysicalCharacteristic* characteristic) {
     if (characteristic == NULL) {
         return failure;
     }
-    if (characteristic->name != NULL) {
-        free(characteristic->name);
-        characteristic->name = NULL;
-    }
+    // the name is part of the same block
+    characteristic->name = NULL;
     free(characteristic);
     characteristic = NULL;
     return success;
@@ -191,6 +290,7 @@ status addPhysicalCharacteristic(Jerry* jerry, PhysicalCharacteristic* character
     jerry->characteristics = temp; // redirect the characteristics array pointer to the new array
     jerry->characteristics[jerry->num_characteristics] = characteristic; // add the new characteristic
     jerry->num_characteristics++; // update the new characteristics number
+    forgetRenderedJerry(jerry);
     return success;
 }
 
@@ -222,6 +322,7 @@ status deletePhysicalCharacteristic(Jerry* jerry, char* characteristic_name) {
         jerry->characteristics[i-1] = jerry->characteristics[i]; // update the pointers
     }
     jerry->num_characteristics--; // decrease the number of characteristics by 1
+    forgetRenderedJerry(jerry);
 
     // reallocate array to new size or free if empty
     if (jerry->num_characteristics > 0) { // then we need a pointer to the new sized array
@@ -251,32 +352,105 @@ PhysicalCharacteristic* getPhysicalCharacteristic(Jerry* jerry, char* name) {
     return NULL;
 }
 
-status printJerry(Jerry* jerry) {
+// the text before the happiness level
+static status renderJerryHead(Renderer renderer, Jerry* jerry) {
+    status state = renderString(renderer, "Jerry , ID - ");
+    if (state == success) state = renderString(renderer, jerry->id);
+    if (state == success) state = renderString(renderer, " : \nHappiness level : ");
+    return state;
+}
+
+// the text after the happiness level
+static status renderJerryTail(Renderer renderer, Jerry* jerry) {
+    status state = renderString(renderer, " \nOrigin : ");
+    if (state == success) state = renderString(renderer, jerry->origin->dimension);
+    if (state == success) state = renderText(renderer, " \n", 2);
+    if (state == success) state = renderPlanet(renderer, jerry->origin->planet);
+
+    if (state == success && jerry->num_characteristics > 0) {
+        state = renderString(renderer, "Jerry's physical Characteristics available : \n\t");
+        for (int i = 0; i < jerry->num_characteristics && state == success; i++) {
+            state = renderString(renderer, jerry->characteristics[i]->name);
+            if (state == success) state = renderText(renderer, " : ", 3);
+            if (state == success) state = renderFixed(renderer, jerry->characteristics[i]->value);
+            if (state == success && i < jerry->num_characteristics - 1) {
+                state = renderText(renderer, " , ", 3);
+            }
+        }
+        if (state == success) state = renderText(renderer, " \n", 2);
+    }
+    return state;
+}
+
+// renders the text around the happiness level once and keeps it, returns NULL if memory runs out
+static RenderedText* cacheRenderedJerry(Jerry* jerry) {
+    Renderer text = createTextRenderer(JERRY_TEXT_CAPACITY);
+    if (!text || renderJerryHead(text, jerry) != success) {
+        destroyRenderer(text);
+        return NULL;
+    }
+    size_t head = getRenderedLength(text);
+    if (renderJerryTail(text, jerry) != success) {
+        destroyRenderer(text);
+        return NULL;
+    }
+    return publishRenderedText(&jerry->rendered, text, head);
+}
+
+status renderJerry(Renderer renderer, Jerry* jerry) {
     if (jerry == NULL) {
         return failure;
     }
+    RenderedText* rendered = atomic_load_explicit(&jerry->rendered, memory_order_acquire);
+    if (!rendered) {
+        rendered = cacheRenderedJerry(jerry);
+    }
 
-    printf("Jerry , ID - %s : \n", jerry->id);
-    printf("Happiness level : %d \n", jerry->happiness);
-    printf("Origin : %s \n", jerry->origin->dimension);
-    printf("Planet : %s (%.2f,%.2f,%.2f) \n",
-           jerry->origin->planet->name,
-           jerry->origin->planet->x,
-           jerry->origin->planet->y,
-           jerry->origin->planet->z);
+    if (rendered) {
+        return renderJerryText(renderer, rendered, jerry->happiness);
+    }
+    // out of memory, the Jerry is rendered without the cache
+    status state = renderJerryHead(renderer, jerry);
+    if (state == success) state = renderInt(renderer, jerry->happiness);
+    if (state == success) state = renderJerryTail(renderer, jerry);
+    return state;
+}
 
-    if (jerry->num_characteristics > 0) {
-        printf("Jerry's physical Characteristics available : \n");
-        printf("\t");
-        for (int i = 0; i < jerry->num_characteristics; i++) {
-            printf("%s : %.2f", jerry->characteristics[i]->name, jerry->characteristics[i]->value);
-            if (i < jerry->num_characteristics - 1) {
-                printf(" , ");
-            }
-        }
-        printf(" \n");
+status renderJerryText(Renderer renderer, RenderedText* rendered, int happiness) {
+    status state = renderText(renderer, rendered->text, rendered->head);
+    if (state == success) state = renderInt(renderer, happiness);
+    if (state == success) state = renderText(renderer, rendered->text + rendered->head, rendered->length - rendered->head);
+    return state;
+}
+
+RenderedText* retainRenderedJerry(Jerry* jerry) {
+    if (jerry == NULL) {
+        return NULL;
     }
-    return success;
+    RenderedText* rendered = atomic_load_explicit(&jerry->rendered, memory_order_acquire);
+    if (!rendered) {
+        rendered = cacheRenderedJerry(jerry);
+    }
+    if (rendered) {
+        // the cache keeps its reference while the Jerry is only read, so the count never drops to zero here
+        atomic_fetch_add_explicit(&rendered->references, 1, memory_order_relaxed);
+    }
+    return rendered;
+}
+
+void releaseRenderedText(RenderedText* rendered) {
+    if (rendered && atomic_fetch_sub_explicit(&rendered->references, 1, memory_order_acq_rel) == 1) {
+        free(rendered);
+    }
+}
+
+status printJerry(Jerry* jerry) {
+    Renderer renderer = getStandardRenderer();
+    status state = renderJerry(renderer, jerry);
+    if (state != success) {
+        return state;
+    }
+    return flushRenderer(renderer);
 }
 
 
@@ -284,13 +458,11 @@ status destroyJerry(Jerry* jerry) {
     if (jerry == NULL) {
         return failure;
     }
-    if (jerry->id != NULL) {
-        free(jerry->id);
-        jerry->id = NULL;
-    }
-
+    // the ID lives inside the Jerry block, the origin is shared so we only drop our reference
+    jerry->id = NULL;
+    releaseRenderedText(atomic_exchange(&jerry->rendered, NULL));
     if (jerry->origin != NULL) {
-        destroyOrigin(jerry->origin);
+        releaseOrigin(jerry->origin);
         jerry->origin = NULL;
     }
     if (jerry->characteristics != NULL) {
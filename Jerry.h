@@ -5,6 +5,23 @@
 #ifndef JERRY_H
 #define JERRY_H
 #include "Defs.h"
+#include "Render.h"
+#include <stdatomic.h>
+
+
+
+/**
+ * Text rendered once and kept. It is published whole, so threads rendering at the same time each see
+ * either no text or all of it. The happiness level of a Jerry goes after its first head bytes.
+ * The text is reference counted: the cache holds one reference, and a listing may hold more, so a listing
+ * keeps the text it was built with after the Jerry changes or is gone.
+ */
+typedef struct RenderedText_t {
+    atomic_int references;
+    int length;
+    int head;
+    char text[];
+} RenderedText;
 
 
 
@@ -19,6 +36,7 @@ typedef struct Planet_t {
     double x;   // X coordinate in space
     double y;   // Y coordinate in space
     double z;   // Z coordinate in space
+    _Atomic(RenderedText*) rendered; // cached text of printPlanet, NULL until the planet is first rendered
 } Planet;
 
 
@@ -28,10 +46,12 @@ typedef struct Planet_t {
 /**
  * Represents the origin/home universe of a Jerry.
  * Contains information about both the dimension and planet the Jerry is from.
+ * An Origin is reference counted so all Jerries from the same (planet, dimension) pair can share it.
  */
 typedef struct Origin_t {
     Planet* planet;  // Pointer to the planet (shared among Jerries from same planet)
-    char* dimension; // Name of the dimension (dynamically allocated)
+    char* dimension; // Name of the dimension (stored inline after the structure)
+    int references;  // Number of holders of this origin, it is freed when it drops to 0
 } Origin;
 
 
@@ -42,9 +62,10 @@ typedef struct Origin_t {
 /**
  * Represents a physical characteristic of a Jerry.
  * Each characteristic has a name and a numeric value.
+ * The name is stored inline right after the structure, so a characteristic is a single allocation.
  */
 typedef struct PhysicalCharacteristic_t {
-    char* name;   // Name of the characteristic (dynamically allocated)
+    char* name;   // Name of the characteristic (stored inline after the structure)
     double value; // Numeric value of the characteristic
 } PhysicalCharacteristic;
 
@@ -57,13 +78,21 @@ typedef struct PhysicalCharacteristic_t {
  * Represents a Jerry from the multiverse.
  * Each Jerry has a unique ID, happiness level, origin information,
  * and a dynamic array of physical characteristics.
+ * A Jerry is allocated as a single block: the structure itself is followed by its ID string.
+ * The Origin is shared with every other Jerry from the same planet and dimension.
+ * Fields that are touched by every activity and characteristic scan are kept at the front,
+ * the print-only fields are kept at the back.
+ * The printed text is cached the first time the Jerry is rendered, in two parts around the happiness level,
+ * so activities never invalidate it. Adding or removing a characteristic or changing the origin drops it.
+ * Rendering only reads the Jerry, so many threads may render it at once, as long as none changes it meanwhile.
  */
 typedef struct Jerry_t {
-    char* id;       // Unique identifier (dynamically allocated)
     int happiness;  // Happiness level (0-100)
-    Origin* origin; // Pointer to Jerry's origin information
-    PhysicalCharacteristic** characteristics; // Dynamic array of pointers to physical characteristics
     int num_characteristics;  // Number of characteristics in the array
+    PhysicalCharacteristic** characteristics; // Dynamic array of pointers to physical characteristics
+    char* id;       // Unique identifier (stored inline after the structure)
+    Origin* origin; // Pointer to Jerry's shared origin information (one reference is held by the Jerry)
+    _Atomic(RenderedText*) rendered; // cached text of printJerry without the happiness level, NULL until rendered or after a change
 } Jerry;
 
 
@@ -102,13 +131,23 @@ status destroyPlanet(Planet* planet);
 status printPlanet(Planet* planet);
 
 
+/**
+ * Renders a Planet in the format of printPlanet, without writing it out.
+ * @param renderer - The renderer to append the text to.
+ * @param planet - Pointer to the Planet object to render.
+ * @return status - success if rendering is successful, failure if planet is NULL or the text can't be written out.
+ */
+status renderPlanet(Renderer renderer, Planet* planet);
+
+
 
 // origin functions
 
 
 /**
  * Creates a new Origin object associating a planet with a dimension.
- * Allocates memory for the Origin structure and its dimension string.
+ * Allocates one block holding the Origin structure and its dimension string.
+ * The new Origin starts with a single reference, owned by the caller.
  * @param planet - Pointer to the Planet object (will be referenced, not copied).
  * @param dimension - Name of the dimension (will be deep copied).
  * @return Origin* - Pointer to the created Origin object, or NULL if memory allocation fails
@@ -119,8 +158,8 @@ Origin* createOrigin(Planet* planet, char* dimension);
 
 
 /**
- * Deletes an Origin object.
- * Frees the memory associated with the Origin's dimension string and the Origin structure itself.
+ * Deletes an Origin object regardless of its reference count.
+ * Frees the Origin block, which also holds the dimension string.
  * @param origin - Pointer to the Origin object to delete.
  * @return status - success if deletion is successful, failure if origin is NULL.
  */
@@ -128,13 +167,31 @@ status destroyOrigin(Origin* origin);
 
 
 
+/**
+ * Takes an additional reference to a shared Origin.
+ * @param origin - Pointer to the Origin object.
+ * @return Origin* - The same origin, or NULL if origin is NULL.
+ */
+Origin* retainOrigin(Origin* origin);
+
+
+
+/**
+ * Drops one reference to a shared Origin and destroys it when no references are left.
+ * @param origin - Pointer to the Origin object.
+ * @return status - success if the reference was released, failure if origin is NULL.
+ */
+status releaseOrigin(Origin* origin);
+
+
+
 // physical characteristics functions
 
 
 
 /**
  * Creates a new PhysicalCharacteristic object with the specified name and value.
- * Allocates memory for the PhysicalCharacteristic structure and its name string.
+ * Allocates one block holding both the PhysicalCharacteristic structure and its name string.
  * @param name - Name of the characteristic (will be deep copied).
  * @param value - Numeric value of the characteristic.
  * @return PhysicalCharacteristic* - Pointer to the created PhysicalCharacteristic object,
@@ -145,7 +202,7 @@ PhysicalCharacteristic* createPhysicalCharacteristic(char* name, double value);
 
 /**
  * Deallocates all memory associated with a PhysicalCharacteristic object.
- * Frees both the name string and the PhysicalCharacteristic structure itself.
+ * The name string lives in the same block, so a single free releases both.
  * @param characteristic - Pointer to the PhysicalCharacteristic object to destroy
  * @return status - success if destruction is successful, failure if characteristic is NULL
  */
@@ -157,7 +214,9 @@ status destroyPhysicalCharacteristic(PhysicalCharacteristic* characteristic);
 
 
 /**
- * Creates a new Jerry object. and Allocates memory for the Jerry structure and initializes its fields.
+ * Creates a new Jerry object with a private Origin of its planet and dimension, shared with no other Jerry,
+ * and allocates one block holding the Jerry structure and its ID.
+ * To share an Origin, get it from the daycare's registry and call createJerryWithOrigin instead.
  * @param id - Unique ID for the Jerry.
  * @param happiness - Happiness level of the Jerry (0-100).
  * @param planet - - Pointer to the Planet where Jerry is from.
@@ -168,11 +227,35 @@ Jerry* createJerry(char* id, int happiness, Planet* planet, char* dimension);
 
 
 
+/**
+ * Creates a new Jerry object that shares an existing Origin.
+ * The Jerry takes its own reference to the origin, the caller keeps its reference.
+ * @param id - Unique ID for the Jerry.
+ * @param happiness - Happiness level of the Jerry (0-100).
+ * @param origin - Pointer to the shared Origin the Jerry is from.
+ * @return Jerry* - Pointer to the created Jerry object, or NULL if memory allocation fails.
+ */
+Jerry* createJerryWithOrigin(char* id, int happiness, Origin* origin);
+
+
+
+/**
+ * Moves a Jerry to another Origin, for example an equal Origin shared with more Jerries.
+ * The Jerry takes a reference to the new origin and releases the old one, its cached text is dropped.
+ * @param jerry - Pointer to the Jerry object.
+ * @param origin - Pointer to the new Origin.
+ * @return status - success if the origin is changed, failure if jerry or origin is NULL.
+ */
+status setJerryOrigin(Jerry* jerry, Origin* origin);
+
+
+
 
 /**
  * Deletes a Jerry object and all its associated data except the planet and origin as it may be associated
  * with another Jerry.
- * Frees the memory allocated for the Jerry's ID, Origin, characteristics array and Jerry itself.
+ * Frees the characteristics, the characteristics array and the Jerry block (which also holds the ID),
+ * and releases the Jerry's reference to its shared Origin.
  * Handles all dynamic memory within the Jerry structure.
  * @param jerry - Pointer to the Jerry object to delete.
  * @return status - success if deletion is successful, failure if jerry is NULL.
@@ -247,6 +330,42 @@ PhysicalCharacteristic* getPhysicalCharacteristic(Jerry* jerry, char* name);
 status printJerry(Jerry* jerry);
 
 
+/**
+ * Renders a Jerry in the format of printJerry, without writing it out.
+ * Used to print many Jerries at once, the renderer is flushed after the last one.
+ * @param renderer - The renderer to append the text to.
+ * @param jerry - Pointer to the Jerry object to render.
+ * @return status - success if rendering is successful, failure if jerry is NULL or the text can't be written out.
+ */
+status renderJerry(Renderer renderer, Jerry* jerry);
+
+
+/**
+ * Gets the cached text of a Jerry, rendering it first if needed, and holds a reference to it.
+ * Many threads may call it at once, as long as none changes the Jerry meanwhile.
+ * @param jerry - Pointer to the Jerry object.
+ * @return RenderedText* - the text, to be released with releaseRenderedText, or NULL if memory ran out.
+ */
+RenderedText* retainRenderedJerry(Jerry* jerry);
+
+
+/**
+ * Drops a reference to a rendered text, the last one frees it.
+ * @param rendered - The text (NULL is ignored).
+ */
+void releaseRenderedText(RenderedText* rendered);
+
+
+/**
+ * Renders a Jerry from its cached text, in the format of printJerry.
+ * @param renderer - The renderer to append the text to.
+ * @param rendered - The text of the Jerry.
+ * @param happiness - The happiness level of the Jerry when the text was taken.
+ * @return status - success if rendering is successful, failure if the text can't be written out.
+ */
+status renderJerryText(Renderer renderer, RenderedText* rendered, int happiness);
+
+
 
 
 #endif //JERRY_H
@@ -0,0 +1,268 @@
+#ifndef JERRYBOREE_H
+#define JERRYBOREE_H
+#include "Jerry.h"
+#include "LinkedList.h"
+#include "HashTable.h"
+#include "MultiValueHashTable.h"
+#include "KdTree.h"
+#include "Journal.h"
+#include "Checkpoint.h"
+#include "ReadWriteLock.h"
+#include "Shards.h"
+#include "Listing.h"
+
+
+/**
+ * Welcome to the JerryBoree module!
+ * This module is the daycare itself: its structures and the operations on them.
+ * It is implemented by JerryBoreeMain.c, next to the interactive menu and main, and this header declares what the
+ * other parts of the driver use, such as the batch commands (Batch).
+ * The operations tell Rick what they did like the menu does, and journal a change before making it.
+ * The caller of an operation holds the daycare's lock: alone for a change, at least shared for a read.
+ */
+
+
+/**
+ * Jerries of an opened source that are only built the first time they are used
+ */
+typedef struct LazyJerries_t LazyJerries;
+
+
+typedef struct JerryBoree_t {
+
+    hashTable jerriesByID; // fast Jerry lookup by ID, concurrent so the loading threads fill it together
+
+    MultiValueHashTable jerriesByCharacteristics; // group Jerries by characteristics
+
+    LinkedList jerries; // LinkedList maintaining insertion order
+
+    LinkedList planets; // store known planets, in insertion order for display
+
+    hashTable planetsByName; // fast planet lookup by name, the planets themselves are owned by the list
+
+    KdTree planetsBySpace; // planets by coordinates, for proximity queries
+
+    MultiValueHashTable jerriesByPlanet; // group Jerries by the name of their planet
+
+    MultiValueHashTable jerriesByDimension; // group Jerries by the name of their dimension
+
+    hashTable origins; // shared origins by (planet, dimension), each holds one reference
+
+    LazyJerries* lazy; // NULL unless the Jerries are loaded on first use
+
+    Journal journal; // NULL unless the changes are journaled
+
+    ReadWriteLock lock; // held shared by the batch commands that only read, alone by the ones that change the daycare
+
+    ListingVersions listings; // versions of the listing of the Jerries, read without the lock
+
+    ShardPool shards; // NULL unless the scans over many Jerries are split between threads by position
+
+} JerryBoree;
+
+
+/**
+ * Checkpoints of the daycare to its snapshot, each one holds the journaled changes made before it started
+ */
+typedef struct DaycareCheckpoint_t {
+    JerryBoree* daycare;
+    const char* filename;
+    Checkpoint running; // NULL when no checkpoint is being written
+    JournalMark mark;   // the end of the journal when the running checkpoint started
+} DaycareCheckpoint;
+
+
+
+// lookups
+
+
+/**
+ * Finds a Jerry by its ID, building it first if it was not used yet
+ * @param daycare The daycare
+ * @param id The ID
+ * @return The Jerry, or NULL if no Jerry in the daycare has the ID
+ */
+Jerry* lookupJerry(JerryBoree* daycare, char* id);
+
+
+
+/**
+ * Adds every Jerry with a characteristic to the characteristic's list, before the list is read or changed
+ * @param daycare The daycare
+ * @param name The name of the characteristic
+ * @return Operation status indicating success, or memory problem / failure if a Jerry could not be built
+ */
+status loadLazyCharacteristic(JerryBoree* daycare, char* name);
+
+
+
+/**
+ * Builds every Jerry that was not used yet, before anything that goes over all of the Jerries
+ * @param daycare The daycare
+ * @return Operation status indicating success, or memory problem / failure if a Jerry could not be built
+ */
+status loadAllLazyJerries(JerryBoree* daycare);
+
+
+
+/**
+ * Tells whether reading the daycare never changes it, that is whether every Jerry of a lazy daycare is built
+ * @param daycare The daycare
+ * @return true if the daycare may be read under the shared lock
+ */
+bool isDaycareLoaded(JerryBoree* daycare);
+
+
+
+// changes
+
+
+/**
+ * Takes in a Jerry whose details are known and shows it
+ * @param daycare The daycare
+ * @param id The ID, no Jerry in the daycare may have it
+ * @param planet The planet of the Jerry
+ * @param dimension The dimension of the Jerry
+ * @param happiness The happiness level (0-100)
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status intakeJerry(JerryBoree* daycare, char* id, Planet* planet, char* dimension, int happiness);
+
+
+
+/**
+ * Adds a characteristic the Jerry does not have yet, then shows the Jerries with the characteristic
+ * @param daycare The daycare
+ * @param jerry The Jerry
+ * @param pc_name The name of the characteristic
+ * @param value The value of the characteristic
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status addCharacteristicAndShow(JerryBoree* daycare, Jerry* jerry, char* pc_name, double value);
+
+
+
+/**
+ * Removes a characteristic the Jerry has, then shows the Jerry
+ * @param daycare The daycare
+ * @param jerry The Jerry
+ * @param pc_name The name of the characteristic
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status removeCharacteristicAndShow(JerryBoree* daycare, Jerry* jerry, char* pc_name);
+
+
+
+/**
+ * Takes a Jerry back and frees it
+ * @param daycare The daycare
+ * @param jerry The Jerry
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status deleteJerryFromStructures(JerryBoree* daycare, Jerry* jerry);
+
+
+
+/**
+ * Shows and takes back every Jerry from a dimension, or from a planet
+ * @param daycare The daycare
+ * @param dimension / planet_name The name of the dimension or of the planet
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status checkoutJerriesFromDimension(JerryBoree* daycare, char* dimension);
+status checkoutJerriesFromPlanet(JerryBoree* daycare, char* planet_name);
+
+
+
+/**
+ * Finds the Jerry of a list whose characteristic is the closest to a value, among the equally close the first one
+ * @param daycare The daycare
+ * @param jerries_with_pc The list of the characteristic
+ * @param pc_name The name of the characteristic
+ * @param target_value The value it is compared to
+ * @return The Jerry, or NULL if no Jerry of the list has the characteristic
+ */
+Jerry* findSimilarJerry(JerryBoree* daycare, LinkedList jerries_with_pc, char* pc_name, double target_value);
+
+
+
+/**
+ * Shows and takes back the Jerry found by findSimilarJerry, if there is one
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status takeSimilarJerry(JerryBoree* daycare, LinkedList jerries_with_pc, char* pc_name, double target_value);
+
+
+
+/**
+ * Shows and takes back the saddest Jerry, among the equally sad the first one
+ * @param daycare The daycare
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status removeSaddestJerry(JerryBoree* daycare);
+
+
+
+/**
+ * Lets every Jerry play an activity of the menu, then shows how every Jerry feels
+ * All of the Jerries must be built first
+ * @param daycare The daycare
+ * @param activity The activity, numbered like in the menu
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status playAndShow(JerryBoree* daycare, int activity);
+
+
+
+// output, rendered and flushed so it may run on many threads at once
+
+
+/**
+ * Shows every Jerry in the order they came
+ * @param daycare The daycare
+ * @return Operation status indicating success, or memory problem / failure
+ */
+status printAllJerries(JerryBoree* daycare);
+
+
+
+/**
+ * Pins an epoch and gets the current listing, building it under the read lock if a change dropped it
+ * The caller does not hold the lock, and passes the epoch to unpinListing once it is done with the listing
+ * @param daycare The daycare
+ * @param epoch Set to the pinned epoch
+ * @return The listing, or NULL with nothing pinned if the daycare can't be listed without changing it,
+ * or if memory ran out
+ */
+JerryListing* pinJerryListing(JerryBoree* daycare, long* epoch);
+
+
+
+/**
+ * Shows a message, a characteristic name as the head of its list, or that no Jerry has a characteristic
+ */
+status displayMessage(const char* message);
+status print_pc_name(Element pc_name);
+status displayUnknownCharacteristic(const char* name);
+
+
+
+// background checkpoints
+
+
+/**
+ * Starts writing a checkpoint in the background, unless one is already being written
+ * @param checkpoint The checkpoints of the daycare
+ */
+void startDaycareCheckpoint(DaycareCheckpoint* checkpoint);
+
+
+
+/**
+ * Reports the running checkpoint if it finished, and drops the journaled changes it holds
+ * @param checkpoint The checkpoints of the daycare
+ */
+void pollDaycareCheckpoint(DaycareCheckpoint* checkpoint);
+
+
+#endif //JERRYBOREE_H
@@ -1,13 +1,19 @@
 //
 // Created by itaym on 20/12/2024.
 //
-#include "Jerry.h"
+#include "JerryBoree.h"
 #include "KeyValuePair.h"
-#include "LinkedList.h"
-#include "HashTable.h"
-#include "MultiValueHashTable.h"
+#include "ConfigParser.h"
+#include "NumberParser.h"
+#include "Snapshot.h"
+#include "Scans.h"
+#include "Batch.h"
 #include <math.h>
+#include <unistd.h>
 #define MAX_LINE_LENGTH 301
+#define INITIAL_TABLE_SIZE 11 // starting size of the tables that grow while loading
+#define ID_TABLE_STRIPES 16 // stripes of the Jerry ID table, so the loading threads seldom share one
+#define DEFAULT_JOURNAL_SYNC 16 // journaled changes per flush to the disk
 
 
 
@@ -16,17 +22,20 @@
  * Main program for managing the JerryBoree daycare system.
  * Handles user interaction and coordinates between different modules.
  */
-typedef struct JerryBoree_t {
 
-    hashTable jerriesByID; // fast Jerry lookup by ID
 
-    MultiValueHashTable jerriesByCharacteristics; // group Jerries by characteristics
-
-    LinkedList jerries; // LinkedList maintaining insertion order
-
-    LinkedList planets; // store known planets
-
-} JerryBoree;
+/* Jerries of an opened source that are only built the first time they are used */
+struct LazyJerries_t {
+    void* source;
+    int (*findRecord)(void* source, char* id); // -1 if no record has the ID
+    int (*findRecordsWith)(void* source, char* name, const uint32_t** records); // records in source order
+    Jerry* (*loadRecord)(void* source, int record);
+    void (*closeSource)(void* source);
+    int count;
+    Jerry** records;        // the Jerry built from every record, NULL until it is used
+    bool allLoaded;
+    hashTable indexedNames; // characteristic names whose Jerries are all in jerriesByCharacteristics
+};
 
 
 
@@ -66,13 +75,21 @@ static bool isEqualJerryIDElement(Element elem1, Element elem2) {
     return strcmp((char*)elem1, (char*)elem2) == 0;
 }
 
+// wrapper for Jerry identity comparison, used by the lists that store Jerry pointers
+static bool isSameJerryElement(Element elem1, Element elem2) {
+    if (!elem1 || !elem2) {
+        return false;
+    }
+    return elem1 == elem2;
+}
+
 
-// wrapper for printing Jerry
+// wrapper for printing Jerry, only rendered, the list is written out once it is done (see displayRendered)
 static status printJerryElement(Element jerry) {
     if (!jerry) {
         return null_pointer;
     }
-    return printJerry((Jerry*)jerry);
+    return renderJerry(getStandardRenderer(), (Jerry*)jerry);
 }
 
 
@@ -80,24 +97,34 @@ static status printJerryElement(Element jerry) {
 
 
 
-// transformation function for the id and characteristics
+// transformation function for the id, characteristics and planet names
+// uses the djb2 string hash, a plain character sum puts similar names like "Planet12" and "Planet21" in one bucket
 static int transformStringHash(Element string) {
     if (!string) {
         return -1;
     }
-    char* str = (char*) string;
-    int sum = 0;
+    unsigned char* str = (unsigned char*) string;
+    unsigned int hash = 5381;
     while (*str != '\0') {
-        sum += *str;
+        hash = hash * 33 + *str;
         str++;
     }
-    return sum;
+    return (int)(hash & 0x7fffffff); // keep it non negative for the bucket index
 }
 
 
 
 
 
+// copy and free functions for elements that are only borrowed by a structure
+static Element copyBorrowed(Element element) {
+    return element;
+}
+
+static status freeBorrowed(Element element) {
+    return success;
+}
+
 // string copy, free, print and isEqual functions
 static Element copyString(Element str) {
     if (!str) {
@@ -108,10 +135,11 @@ static Element copyString(Element str) {
 }
 
 // helper function to print the Physical characteristic name properly
-static status print_pc_name(Element pc_name) {
+status print_pc_name(Element pc_name) {
     if (!pc_name) return failure;
-    printf("%s : \n", (char*)pc_name);  // add the " : " after the ID
-    return success;
+    status state = renderString(getStandardRenderer(), (char*)pc_name);
+    if (state != success) return state;
+    return renderText(getStandardRenderer(), " : \n", 4);  // add the " : " after the ID
 }
 
 // FreeFunction for strings
@@ -126,8 +154,7 @@ static status freeString(Element str) {
 // PrintFunction for strings
 static status printString(Element str) {
     if (!str) return null_pointer;
-    printf("%s", (char*)str);
-    return success;
+    return renderString(getStandardRenderer(), (char*)str);
 }
 
 // EqualFunction for strings
@@ -161,7 +188,12 @@ static status freePlanet(Element planet) {
 // PrintFunction for planets
 static status printPlanetPtr(Element planet) {
     if (!planet) return failure;
-    return printPlanet((Planet*)planet);
+    return renderPlanet(getStandardRenderer(), (Planet*)planet);
+}
+
+// not actually freeing the planet in the name index, the planets list owns it
+static status freePlanetPtr(Element planet) {
+    return success;
 }
 
 // EqualFunction for planets
@@ -172,6 +204,59 @@ static bool isEqualPlanet(Element elem1, Element elem2) {
     return strcmp(((Planet*)elem1)->name, ((char*)elem2)) == 0;
 }
 
+// origins copy, free, print, isEqual and transformation functions for the origins registry
+// the registry uses the Origin itself as the key, so lookups can be done with a stack probe
+static Element copyOriginShallow(Element origin) {
+    if (!origin) {
+        return NULL;
+    }
+    return origin;
+}
+
+// the key and the value are the same Origin, only the value holds the registry reference
+static status freeOriginKey(Element origin) {
+    return success;
+}
+
+// FreeFunction for origins, drops the registry reference
+static status releaseOriginElement(Element origin) {
+    if (!origin) {
+        return null_pointer;
+    }
+    return releaseOrigin((Origin*)origin);
+}
+
+// PrintFunction for origins
+static status printOriginElement(Element origin) {
+    if (!origin) return failure;
+    Renderer renderer = getStandardRenderer();
+    status state = renderString(renderer, "Origin : ");
+    if (state == success) state = renderString(renderer, ((Origin*)origin)->dimension);
+    if (state == success) state = renderText(renderer, " \n", 2);
+    if (state == success) state = renderPlanet(renderer, ((Origin*)origin)->planet);
+    return state;
+}
+
+// EqualFunction for origins, same planet and same dimension name
+static bool isEqualOrigin(Element elem1, Element elem2) {
+    if (!elem1 || !elem2) {
+        return false;
+    }
+    Origin* origin1 = (Origin*)elem1;
+    Origin* origin2 = (Origin*)elem2;
+    return origin1->planet == origin2->planet && strcmp(origin1->dimension, origin2->dimension) == 0;
+}
+
+// transformation function for origins
+static int transformOriginHash(Element origin) {
+    if (!origin) {
+        return -1;
+    }
+    unsigned int hash = (unsigned int)transformStringHash(((Origin*)origin)->planet->name) * 31u
+                      + (unsigned int)transformStringHash(((Origin*)origin)->dimension);
+    return (int)(hash & 0x7fffffff);
+}
+
 /* clear buffer function to help with user input */
 
 void clearBuffer() {
@@ -187,6 +272,18 @@ void clearBuffer() {
 
 
 
+// reads a real number from the user, returns false if the input doesn't start with one
+static bool readDecimal(double* value) {
+    char text[MAX_LINE_LENGTH];
+    if (scanf("%300s", text) != 1) {
+        return false;
+    }
+    clearBuffer();
+    return parseDecimal(text, NULL, value);
+}
+
+
+
 /** JerryBoree functions **/
 
 
@@ -225,9 +322,83 @@ int find_closest_prime(int number) {
 
 
 
-JerryBoree* initJerryBoree(int tableSize, int multiTableSize) {
+void destroyJerryBoree(JerryBoree** daycare) {
+    if (!daycare || !*daycare) {
+        return;
+    }
+    JerryBoree* DayCare = *daycare;
+
+    // flushes the changes that are still waiting for their group
+    closeJournal(DayCare->journal);
+
+    // the indexes only hold shared pointers, so they go before the structures that own the objects
+    if (DayCare->jerriesByDimension) {
+        destroyMultiValueHashTable(DayCare->jerriesByDimension);
+    }
+
+    if (DayCare->jerriesByPlanet) {
+        destroyMultiValueHashTable(DayCare->jerriesByPlanet);
+    }
+
+    if (DayCare->planetsBySpace) {
+        destroyKdTree(DayCare->planetsBySpace);
+    }
+
+    if (DayCare->jerries) {
+        destroyList(DayCare->jerries);
+    }
+
+    // after the Jerries are gone the registry holds the last reference to every origin
+    if (DayCare->origins) {
+        destroyHashTable(DayCare->origins);
+    }
+
+    if (DayCare->planetsByName) {
+        destroyHashTable(DayCare->planetsByName);
+    }
+
+    if (DayCare->planets) {
+        destroyList(DayCare->planets);
+    }
+
+    if (DayCare->jerriesByCharacteristics) {
+        destroyMultiValueHashTable(DayCare->jerriesByCharacteristics);
+    }
+
+    if (DayCare->jerriesByID) {
+        destroyHashTable(DayCare->jerriesByID);
+    }
+
+    // the source goes last, nothing refers to it once the Jerries are gone
+    if (DayCare->lazy) {
+        if (DayCare->lazy->indexedNames) {
+            destroyHashTable(DayCare->lazy->indexedNames);
+        }
+        free(DayCare->lazy->records);
+        DayCare->lazy->closeSource(DayCare->lazy->source);
+        free(DayCare->lazy);
+    }
+    destroyReadWriteLock(DayCare->lock);
+    destroyShardPool(DayCare->shards);
+    destroyListingVersions(DayCare->listings);
+    free(DayCare);
+    *daycare = NULL;
+}
+
+
+
+// creates an index that groups borrowed Jerries by a name, used by planet and by dimension
+static MultiValueHashTable createJerryGroupIndex(int tableSize) {
+    return createMultiValueHashTable(copyString, freeString, print_pc_name,
+                                     copyJerryShallow, freeJerryPtr, printJerryElement, isEqualString,
+                                     isSameJerryElement, transformStringHash, tableSize);
+}
+
+
+JerryBoree* initJerryBoree(int tableSize, int multiTableSize, int planetsTableSize) {
 
-    JerryBoree* DayCare = (JerryBoree*)malloc(sizeof(JerryBoree));
+    // zeroed, so a partially built daycare can be released by destroyJerryBoree
+    JerryBoree* DayCare = (JerryBoree*)calloc(1, sizeof(JerryBoree));
     if (!DayCare) {
         return NULL;
     }
@@ -235,11 +406,12 @@ JerryBoree* initJerryBoree(int tableSize, int multiTableSize) {
 
 
     // HashTable creation
-    DayCare->jerriesByID = createHashTable(copyString, freeString, printString,
-                                                    copyJerryShallow, freeJerryPtr, printJerryElement,
-                                           isEqualJerryIDElement, transformStringHash, tableSize);
+    DayCare->jerriesByID = createConcurrentHashTable(copyString, freeString, printString,
+                                                     copyJerryShallow, freeJerryPtr, printJerryElement,
+                                                     isEqualJerryIDElement, transformStringHash, tableSize,
+                                                     ID_TABLE_STRIPES);
     if (!DayCare->jerriesByID) {
-        free(DayCare);
+        destroyJerryBoree(&DayCare);
         return NULL;
     }
 
@@ -247,10 +419,9 @@ JerryBoree* initJerryBoree(int tableSize, int multiTableSize) {
     // MultiValueHashTable creation
     DayCare->jerriesByCharacteristics = createMultiValueHashTable(copyString, freeString, print_pc_name,
                                                                 copyJerryShallow, freeJerryPtr, printJerryElement, isEqualString,
-                                                                isEqualJerryIDElement, transformStringHash, multiTableSize);
+                                                                isSameJerryElement, transformStringHash, multiTableSize);
     if (!DayCare->jerriesByCharacteristics) {
-        destroyHashTable(DayCare->jerriesByID);
-        free(DayCare);
+        destroyJerryBoree(&DayCare);
         return NULL;
     }
 
@@ -258,53 +429,85 @@ JerryBoree* initJerryBoree(int tableSize, int multiTableSize) {
     // Planets LinkedList creation
     DayCare->planets = createLinkedList(copyPlanet, freePlanet, printPlanetPtr, isEqualPlanet);
     if (!DayCare->planets) {
-        destroyHashTable(DayCare->jerriesByID);
-        destroyMultiValueHashTable(DayCare->jerriesByCharacteristics);
-        free(DayCare);
+        destroyJerryBoree(&DayCare);
         return NULL;
     }
 
 
 
     // Jerries LinkedList creation
-    DayCare->jerries = createLinkedList(copyJerryShallow, destroyJerryElement, printJerryElement,isEqualJerryIDElement);
+    DayCare->jerries = createLinkedList(copyJerryShallow, destroyJerryElement, printJerryElement, isSameJerryElement);
     if (!DayCare->jerries) {
-        destroyHashTable(DayCare->jerriesByID);
-        destroyMultiValueHashTable(DayCare->jerriesByCharacteristics);
-        destroyList(DayCare->planets);
-        free(DayCare);
+        destroyJerryBoree(&DayCare);
         return NULL;
     }
 
-    return DayCare;
-}
-
+    // shared origins registry creation
+    DayCare->origins = createHashTable(copyOriginShallow, freeOriginKey, printOriginElement,
+                                       copyOriginShallow, releaseOriginElement, printOriginElement,
+                                       isEqualOrigin, transformOriginHash, planetsTableSize);
+    if (!DayCare->origins) {
+        destroyJerryBoree(&DayCare);
+        return NULL;
+    }
 
+    // planets by name HashTable creation
+    DayCare->planetsByName = createHashTable(copyString, freeString, printString,
+                                             copyPlanet, freePlanetPtr, printPlanetPtr,
+                                             isEqualString, transformStringHash, planetsTableSize);
+    if (!DayCare->planetsByName) {
+        destroyJerryBoree(&DayCare);
+        return NULL;
+    }
 
-void destroyJerryBoree(JerryBoree** daycare) {
-    if (!daycare) {
-        return;
+    // planets by coordinates k-d tree creation
+    DayCare->planetsBySpace = createKdTree(copyPlanet, freePlanetPtr);
+    if (!DayCare->planetsBySpace) {
+        destroyJerryBoree(&DayCare);
+        return NULL;
     }
-    JerryBoree* DayCare = *daycare;
 
+    // Jerries by planet name MultiValueHashTable creation
+    DayCare->jerriesByPlanet = createJerryGroupIndex(planetsTableSize);
+    if (!DayCare->jerriesByPlanet) {
+        destroyJerryBoree(&DayCare);
+        return NULL;
+    }
 
-    if (DayCare->jerries) {
-        destroyList(DayCare->jerries);
+    // Jerries by dimension name MultiValueHashTable creation
+    DayCare->jerriesByDimension = createJerryGroupIndex(planetsTableSize);
+    if (!DayCare->jerriesByDimension) {
+        destroyJerryBoree(&DayCare);
+        return NULL;
     }
 
-    if (DayCare->planets) {
-        destroyList(DayCare->planets);
+    // lock of the batch commands creation
+    DayCare->lock = createReadWriteLock();
+    if (!DayCare->lock) {
+        destroyJerryBoree(&DayCare);
+        return NULL;
     }
 
-    if (DayCare->jerriesByCharacteristics) {
-        destroyMultiValueHashTable(DayCare->jerriesByCharacteristics);
+    DayCare->listings = createListingVersions();
+    if (!DayCare->listings) {
+        destroyJerryBoree(&DayCare);
+        return NULL;
     }
 
-    if (DayCare->jerriesByID) {
-        destroyHashTable(DayCare->jerriesByID);
+    return DayCare;
+}
+
+
+// splits the scans over the Jerries of a daycare between threads, each scanning an even run of the positions
+status shardJerryBoree(JerryBoree* daycare, int shards) {
+    if (!daycare) {
+        return null_pointer;
     }
-    free(DayCare);
-    *daycare = NULL;
+    if (shards <= 0 || shards > MAX_SHARDS || daycare->shards) {
+        return failure;
+    }
+    daycare->shards = createShardPool(shards);
+    return daycare->shards ? success : memory_problem;
 }
 
 
@@ -313,225 +516,770 @@ void destroyJerryBoree(JerryBoree** daycare) {
 /** read from configuration file **/
 
 
-// counts the number of jerries and the number of unique physical characteristics names in the configuration file
-status countFileStats(FILE* fp, int* numJerries, int* numUniqueCharacteristics) {
-    if (!fp || !numJerries || !numUniqueCharacteristics) {
-        return null_pointer;
+// returns the shared origin for a (planet, dimension) pair in a registry, registering a new one if needed
+// the returned origin is owned by the registry, Jerries take their own reference to it
+static Origin* getSharedOrigin(hashTable origins, Planet* planet, char* dimension) {
+    if (!origins || !planet || !dimension) {
+        return NULL;
+    }
+    Origin probe = { planet, dimension, 0 };
+    Origin* origin = lookupInHashTable(origins, &probe);
+    if (origin) {
+        return origin;
     }
 
-    *numJerries = 0;
-    char line[MAX_LINE_LENGTH];
-    char seen[MAX_LINE_LENGTH][MAX_LINE_LENGTH];  // store unique characteristic names
-    int seenCount = 0;  // number of unique characteristics found so far
-
-    rewind(fp); // reset file pointer to start
-
-
-    // skip until Jerries section
-    while (fgets(line, sizeof(line), fp)) {
-        if (strstr(line, "Jerries")) break;
+    origin = createOrigin(planet, dimension);
+    if (!origin) {
+        return NULL;
+    }
+    if (addToHashTable(origins, origin, origin) != success) {
+        destroyOrigin(origin);
+        return NULL;
     }
+    return origin;
+}
 
-    // process each line in Jerries section
-    while (fgets(line, sizeof(line), fp)) {
-        line[strcspn(line, "\n")] = 0; // remove newline character
-        if (strlen(line) == 0) continue;
 
-        if (line[0] == '\t') {   // if line starts with tab = characteristic line
-            char charName[MAX_LINE_LENGTH];
-            if (sscanf(line + 1, "%[^:]", charName) == 1) { // extract characteristic's name
-                // check if characteristic is new
-                bool found = false;
-                for (int i = 0; i < seenCount && !found; i++) {
-                    found = (strcmp(seen[i], charName) == 0);
-                }
-                if (!found) strcpy(seen[seenCount++], charName); // if not seen before, add to the seen count
-            }
-        } else if (strchr(line, ',')) {  // if line contains "," so it's a Jerry line
-            (*numJerries)++;
-        }
+// creates a Jerry that shares the registered origin of its (planet, dimension) pair
+static Jerry* createDaycareJerry(JerryBoree* daycare, char* id, int happiness, Planet* planet, char* dimension) {
+    if (!daycare) {
+        return NULL;
     }
-
-    *numUniqueCharacteristics = seenCount; // store final count
-    rewind(fp);
-    return success;
+    Origin* origin = getSharedOrigin(daycare->origins, planet, dimension);
+    if (!origin) {
+        return NULL;
+    }
+    return createJerryWithOrigin(id, happiness, origin);
 }
 
 
-// add a given jerry to the Jerries LinkedList and the Jerry ID's HashTable
-status addJerryToStructs(JerryBoree* daycare, Jerry* new_jerry) {
+// adds a Jerry to the Jerries LinkedList and the group indexes, and to the Jerry ID's HashTable unless it is there already
+static status addJerryToIndexes(JerryBoree* daycare, Jerry* new_jerry, bool indexedByID) {
     if (!daycare) {
         return null_pointer;
     }
+    dropListing(daycare->listings);
     // add Jerry to the structures
     status jerry_insertion = appendNode(daycare->jerries, new_jerry);
     if (jerry_insertion != success) {
         destroyJerry(new_jerry); // clean if append fails
         return jerry_insertion;
     }
-    status hashtable_insertion = addToHashTable(daycare->jerriesByID, new_jerry->id, new_jerry);
+    status hashtable_insertion = indexedByID ? success : addToHashTable(daycare->jerriesByID, new_jerry->id, new_jerry);
     if (hashtable_insertion != success) {
         deleteNode(daycare->jerries, new_jerry);
-        return jerry_insertion;
+        return hashtable_insertion;
+    }
+    status planet_insertion = addToMultiValueHashTable(daycare->jerriesByPlanet, new_jerry->origin->planet->name, new_jerry);
+    if (planet_insertion != success) {
+        removeFromHashTable(daycare->jerriesByID, new_jerry->id);
+        deleteNode(daycare->jerries, new_jerry);
+        return planet_insertion;
+    }
+    status dimension_insertion = addToMultiValueHashTable(daycare->jerriesByDimension, new_jerry->origin->dimension, new_jerry);
+    if (dimension_insertion != success) {
+        removeFromMultiValueHashTable(daycare->jerriesByPlanet, new_jerry->origin->planet->name, new_jerry);
+        removeFromHashTable(daycare->jerriesByID, new_jerry->id);
+        deleteNode(daycare->jerries, new_jerry);
+        return dimension_insertion;
     }
     return success;
 }
 
 
-static status loadPlanets(JerryBoree* boree, FILE* fp, int numPlanets) {
-    char line[MAX_LINE_LENGTH];
+// add a given jerry to the Jerries LinkedList and the Jerry ID's HashTable
+status addJerryToStructs(JerryBoree* daycare, Jerry* new_jerry) {
+    return addJerryToIndexes(daycare, new_jerry, false);
+}
+
+
+/* Jerries of one configuration chunk, built on a worker thread and waiting to be merged in file order */
+typedef struct JerryChunk_t {
+    JerryBoree* daycare; // only read while the chunk is parsed, but for its concurrent Jerry ID table
+    hashTable origins;   // origins of this chunk, traded for the shared ones of the daycare when merged
+    Jerry** jerries;     // Jerries in file order
+    int count;
+    int capacity;
+    int merged;          // jerries[0..merged) already belong to the daycare
+} JerryChunk;
 
-    // skip "Planets" header
-    if (!fgets(line, sizeof(line), fp)) return failure;
 
-    // read each planet
-    for (int i = 0; i < numPlanets; i++) {
-        if (!fgets(line, sizeof(line), fp)) return failure;
+// adds a planet to the planets list and indexes, the daycare owns the planet even if this fails
+static status addPlanetToStructs(JerryBoree* boree, Planet* planet) {
+    // add to planets list - it will just store the pointer
+    if (appendNode(boree->planets, planet) != success) {
+        destroyPlanet(planet);
+        return failure;
+    }
 
-        // remove newline
-        line[strcspn(line, "\n")] = 0; // remove newline
+    // index it by name, a duplicate planet name is a configuration error
+    if (addToHashTable(boree->planetsByName, planet->name, planet) != success) {
+        return failure; // the list already owns the planet
+    }
 
-        char name[MAX_LINE_LENGTH];
-        float x, y, z;
+    // and by coordinates
+    if (insertToKdTree(boree->planetsBySpace, planet->x, planet->y, planet->z, planet) != success) {
+        return failure;
+    }
 
-        // parse planet line
-        if (sscanf(line, "%[^,],%f,%f,%f", name, &x, &y, &z) != 4)
-            return failure;
+    // not destroying planet here since we're keeping the original instance
+    return success;
+}
 
-        Planet* planet = createPlanet(name, x, y, z);
-        if (!planet) return failure;
 
-        // add to planets list - it will just store the pointer
-        if (appendNode(boree->planets, planet) != success) {
-            destroyPlanet(planet);
+// adds a Jerry that already has its characteristics to the structures and to the characteristic lookup
+static status addJerryWithCharacteristics(JerryBoree* daycare, Jerry* jerry, bool indexedByID) {
+    // a duplicate ID is rejected here, so the first Jerry keeps it
+    status result = addJerryToIndexes(daycare, jerry, indexedByID);
+    if (result != success) {
+        return result;
+    }
+
+    // add to characteristic lookup
+    for (int i = 0; i < jerry->num_characteristics; i++) {
+        result = addToMultiValueHashTable(daycare->jerriesByCharacteristics, jerry->characteristics[i]->name, jerry);
+        if (result != success) {
             return failure;
         }
-
-        // not destroying planet here since we're keeping the original instance
     }
-
     return success;
 }
-static status loadJerries(JerryBoree* daycare, FILE* fp) {
-    char line[MAX_LINE_LENGTH];
-    Jerry* currentJerry = NULL;  // keep track of last created Jerry for characteristics
 
-    // skip "Jerries" header
-    if (!fgets(line, sizeof(line), fp)) return failure;
 
-    while (fgets(line, sizeof(line), fp)) {
-        line[strcspn(line, "\n")] = 0;
-        if (strlen(line) == 0) continue;
+static status loadPlanet(void* context, char* name, double x, double y, double z) {
+    Planet* planet = createPlanet(name, x, y, z);
+    if (!planet) return failure;
+    return addPlanetToStructs((JerryBoree*)context, planet);
+}
 
-        // if line starts with tab, it's a characteristic for current Jerry
-        if (line[0] == '\t') {
-            if (!currentJerry) return failure;
 
-            char name[MAX_LINE_LENGTH];
-            double value;
+// called on a worker thread, so it only allocates objects that belong to the chunk
+static void* createJerryChunk(void* context) {
+    JerryChunk* chunk = (JerryChunk*)calloc(1, sizeof(JerryChunk));
+    if (!chunk) {
+        return NULL;
+    }
+    chunk->daycare = (JerryBoree*)context;
+    chunk->origins = createHashTable(copyOriginShallow, freeOriginKey, printOriginElement,
+                                     copyOriginShallow, releaseOriginElement, printOriginElement,
+                                     isEqualOrigin, transformOriginHash, INITIAL_TABLE_SIZE);
+    if (!chunk->origins) {
+        free(chunk);
+        return NULL;
+    }
+    return chunk;
+}
 
-            if (sscanf(line + 1, "%[^:]:%lf", name, &value) != 2)
-                return failure;
 
-            // add characteristic to Jerry
-            PhysicalCharacteristic* pc = createPhysicalCharacteristic(name, value);
-            if (!pc) return memory_problem;
-            status result = addPhysicalCharacteristic(currentJerry, pc);
-            if (result != success) {
-                destroyPhysicalCharacteristic(pc);
-                return failure;
-            }
+static void destroyJerryChunk(void* context) {
+    JerryChunk* chunk = (JerryChunk*)context;
+    if (!chunk) {
+        return;
+    }
+    // the Jerries that were not merged are still owned by the chunk
+    for (int i = chunk->merged; i < chunk->count; i++) {
+        destroyJerry(chunk->jerries[i]);
+    }
+    free(chunk->jerries);
+    destroyHashTable(chunk->origins);
+    free(chunk);
+}
 
-            // add to characteristic lookup
-            result = addToMultiValueHashTable(daycare->jerriesByCharacteristics, name, currentJerry);
-            if (result != success) {
-                return failure;
-            }
 
-        } else {
-            // this is a new Jerry line
-            char id[MAX_LINE_LENGTH], dimension[MAX_LINE_LENGTH], planetName[MAX_LINE_LENGTH];
-            int happiness;
-
-            if (sscanf(line, "%[^,],%[^,],%[^,],%d",
-                      id, dimension, planetName, &happiness) != 4)
-                return failure;
-
-            // find planet from linked list
-            Planet* planet = searchByKeyInList(daycare->planets, planetName);
-            if (!planet) return failure;
-            // create new Jerry
-            currentJerry = createJerry(id, happiness, planet, dimension);
-            if (!currentJerry) return failure;
-
-            status add_state = addJerryToStructs(daycare, currentJerry);
-            if (add_state != success) {
-                return add_state;
-            }
+static status loadJerry(void* context, char* id, char* dimension, char* planetName, int happiness) {
+    JerryChunk* chunk = (JerryChunk*)context;
+
+    // find planet by name, the planets are not changed anymore while the chunks are parsed
+    Planet* planet = lookupInHashTable(chunk->daycare->planetsByName, planetName);
+    if (!planet) return failure;
+    // create new Jerry
+    Origin* origin = getSharedOrigin(chunk->origins, planet, dimension);
+    if (!origin) return failure;
+    Jerry* jerry = createJerryWithOrigin(id, happiness, origin);
+    if (!jerry) return failure;
+
+    if (chunk->count == chunk->capacity) {
+        int capacity = chunk->capacity ? chunk->capacity * 2 : INITIAL_TABLE_SIZE;
+        Jerry** jerries = (Jerry**)realloc(chunk->jerries, capacity * sizeof(Jerry*));
+        if (!jerries) {
+            destroyJerry(jerry);
+            return memory_problem;
         }
+        chunk->jerries = jerries;
+        chunk->capacity = capacity;
     }
+    chunk->jerries[chunk->count++] = jerry;
 
+    // the chunks index their Jerries by ID side by side, so a duplicate ID fails the load before the merge
+    return addToHashTable(chunk->daycare->jerriesByID, jerry->id, jerry);
+}
+
+
+static status loadCharacteristic(void* context, char* name, double value) {
+    JerryChunk* chunk = (JerryChunk*)context;
+    if (chunk->count == 0) return failure;
+
+    // add characteristic to the last Jerry of the chunk
+    PhysicalCharacteristic* pc = createPhysicalCharacteristic(name, value);
+    if (!pc) return memory_problem;
+    status result = addPhysicalCharacteristic(chunk->jerries[chunk->count - 1], pc);
+    if (result != success) {
+        destroyPhysicalCharacteristic(pc);
+        return failure;
+    }
+    return success;
+}
+
+
+// adds the Jerries of a chunk to the daycare, in the order they were read
+static status mergeJerryChunk(void* context, void* chunkContext) {
+    JerryBoree* daycare = (JerryBoree*)context;
+    JerryChunk* chunk = (JerryChunk*)chunkContext;
+
+    while (chunk->merged < chunk->count) {
+        Jerry* jerry = chunk->jerries[chunk->merged++]; // from here on the daycare owns the Jerry
+
+        // trade the chunk's origin for the shared one of the daycare
+        Origin* origin = getSharedOrigin(daycare->origins, jerry->origin->planet, jerry->origin->dimension);
+        if (!origin) {
+            destroyJerry(jerry);
+            return failure;
+        }
+        setJerryOrigin(jerry, origin);
+
+        // the chunk already put it in the ID table
+        status result = addJerryWithCharacteristics(daycare, jerry, true);
+        if (result != success) {
+            return result;
+        }
+    }
     return success;
 }
 
+
+// parses the Jerries on every online processor, the result is the same as reading the file in order
 status loadConfigurationFile(JerryBoree* boree, const char* filename, int numPlanets) {
-    FILE* fp = fopen(filename, "r");
-    if (!fp) return failure;
+    ConfigParallelHandlers handlers = { boree, loadPlanet, createJerryChunk, loadJerry, loadCharacteristic,
+                                        mergeJerryChunk, destroyJerryChunk };
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
 
-    status result = loadPlanets(boree, fp, numPlanets);
-    if (result == success) {
-        result = loadJerries(boree, fp);
+    status result = parseConfigurationFileParallel(filename, numPlanets, &handlers, processors > 0 ? (int)processors : 1);
+    if (result != success) {
+        return result;
     }
 
-    fclose(fp);
-    return result;
+    // all planets are known now, so split the coordinates space evenly
+    return balanceKdTree(boree->planetsBySpace);
 }
 
 
 
-/** menu functions **/
+/** read from a snapshot file **/
 
 
-void printMenu() {
-    printf("Welcome Rick, what are your Jerry's needs today ? \n");
-    printf("1 : Take this Jerry away from me \n");
-    printf("2 : I think I remember something about my Jerry \n");
-    printf("3 : Oh wait. That can't be right \n");
-    printf("4 : I guess I will take back my Jerry now \n");
-    printf("5 : I can't find my Jerry. Just give me a similar one \n");
-    printf("6 : I lost a bet. Give me your saddest Jerry \n");
-    printf("7 : Show me what you got \n");
-    printf("8 : Let the Jerries play \n");
-    printf("9 : I had enough. Close this place \n");
+static status loadSnapshotPlanet(void* context, Planet* planet) {
+    return addPlanetToStructs((JerryBoree*)context, planet);
+}
+
 
+static Origin* getSnapshotOrigin(void* context, Planet* planet, char* dimension) {
+    return getSharedOrigin(((JerryBoree*)context)->origins, planet, dimension);
 }
 
-void printOption7Menu() {
-    printf("What information do you want to know ? \n");
-    printf("1 : All Jerries \n");
-    printf("2 : All Jerries by physical characteristics \n");
-    printf("3 : All known planets \n");
+
+static status loadSnapshotJerry(void* context, Jerry* jerry) {
+    return addJerryWithCharacteristics((JerryBoree*)context, jerry, false);
 }
 
-void printOption8Menu() {
-    printf("What activity do you want the Jerries to partake in ? \n");
-    printf("1 : Interact with fake Beth \n");
-    printf("2 : Play golf \n");
-    printf("3 : Adjust the picture settings on the TV \n");
+
+status loadSnapshotFile(JerryBoree* boree, const char* filename, int numPlanets) {
+    SnapshotCounts counts;
+    status result = readSnapshotCounts(filename, &counts);
+    if (result != success || counts.planets != numPlanets) {
+        return failure;
+    }
+    SnapshotHandlers handlers = { boree, loadSnapshotPlanet, getSnapshotOrigin, loadSnapshotJerry };
+    result = loadSnapshot(filename, &handlers);
+    if (result != success) {
+        return result;
+    }
+    return balanceKdTree(boree->planetsBySpace);
 }
 
 
+// adapters from the lazy source interface to a snapshot image
+static int findSnapshotRecord(void* source, char* id) {
+    return findSnapshotJerry((SnapshotImage)source, id);
+}
 
-/** Utilities functions **/
+static int findSnapshotRecordsWith(void* source, char* name, const uint32_t** records) {
+    return findSnapshotCharacteristic((SnapshotImage)source, name, records);
+}
 
-// removes Jerry from all structures and frees memory accordingly
-status deleteJerryFromStructures(JerryBoree* daycare, Jerry* jerry) {
-    if (!daycare || !jerry) return null_pointer;
+static Jerry* loadSnapshotRecord(void* source, int record) {
+    return buildSnapshotJerry((SnapshotImage)source, record);
+}
 
+static void closeSnapshotSource(void* source) {
+    closeSnapshotImage((SnapshotImage)source);
+}
 
-    // delete all jerries associate
-    int numChars = jerry->num_characteristics;
-    for (int i = 0; i < numChars; i++) {
+
+// makes a source the lazy Jerries of the daycare, the source is closed with the daycare even if this fails
+static status attachLazySource(JerryBoree* boree, LazyJerries* source) {
+    LazyJerries* lazy = (LazyJerries*)malloc(sizeof(LazyJerries));
+    if (!lazy) {
+        source->closeSource(source->source);
+        return memory_problem;
+    }
+    *lazy = *source;
+    boree->lazy = lazy; // released with the daycare from here on
+
+    lazy->records = (Jerry**)calloc(lazy->count + 1, sizeof(Jerry*));
+    lazy->allLoaded = false;
+    lazy->indexedNames = createHashTable(copyString, freeString, printString, copyBorrowed, freeBorrowed, printString,
+                                         isEqualString, transformStringHash, INITIAL_TABLE_SIZE);
+    if (!lazy->records || !lazy->indexedNames) {
+        return memory_problem;
+    }
+    return balanceKdTree(boree->planetsBySpace);
+}
+
+
+// opens a snapshot without loading its Jerries, they are built from the mapped records when first used
+status openLazySnapshotFile(JerryBoree* boree, const char* filename, int numPlanets) {
+    SnapshotCounts counts;
+    status result = readSnapshotCounts(filename, &counts);
+    if (result != success || counts.planets != numPlanets) {
+        return failure;
+    }
+    SnapshotHandlers handlers = { boree, loadSnapshotPlanet, getSnapshotOrigin, loadSnapshotJerry };
+    SnapshotImage image = openSnapshotImage(filename, &handlers);
+    if (!image) {
+        return failure;
+    }
+
+    LazyJerries source = { image, findSnapshotRecord, findSnapshotRecordsWith, loadSnapshotRecord, closeSnapshotSource,
+                           getSnapshotJerryCount(image), NULL, false, NULL };
+    return attachLazySource(boree, &source);
+}
+
+
+/* A configuration file opened as an index, and the Jerry being parsed from one of its records */
+typedef struct ConfigSource_t {
+    JerryBoree* daycare;
+    ConfigIndex index;
+    Jerry* jerry;
+} ConfigSource;
+
+
+static status loadIndexedPlanet(void* context, char* name, double x, double y, double z) {
+    return loadPlanet(((ConfigSource*)context)->daycare, name, x, y, z);
+}
+
+
+static status loadIndexedJerry(void* context, char* id, char* dimension, char* planetName, int happiness) {
+    ConfigSource* source = (ConfigSource*)context;
+    if (source->jerry) return failure; // a record holds a single Jerry
+
+    Planet* planet = lookupInHashTable(source->daycare->planetsByName, planetName);
+    if (!planet) return failure;
+    Origin* origin = getSharedOrigin(source->daycare->origins, planet, dimension);
+    if (!origin) return failure;
+    source->jerry = createJerryWithOrigin(id, happiness, origin);
+    return source->jerry ? success : memory_problem;
+}
+
+
+static status loadIndexedCharacteristic(void* context, char* name, double value) {
+    ConfigSource* source = (ConfigSource*)context;
+    if (!source->jerry) return failure;
+
+    PhysicalCharacteristic* pc = createPhysicalCharacteristic(name, value);
+    if (!pc) return memory_problem;
+    status result = addPhysicalCharacteristic(source->jerry, pc);
+    if (result != success) {
+        destroyPhysicalCharacteristic(pc);
+        return failure;
+    }
+    return success;
+}
+
+
+// adapters from the lazy source interface to a configuration index
+static int findConfigRecord(void* source, char* id) {
+    return findConfigJerry(((ConfigSource*)source)->index, id);
+}
+
+static int findConfigRecordsWith(void* source, char* name, const uint32_t** records) {
+    return findConfigCharacteristic(((ConfigSource*)source)->index, name, records);
+}
+
+static Jerry* loadConfigRecord(void* source, int record) {
+    ConfigSource* config = (ConfigSource*)source;
+    config->jerry = NULL;
+    status result = parseConfigJerry(config->index, record);
+    Jerry* jerry = config->jerry;
+    config->jerry = NULL;
+    if (result != success && jerry) {
+        destroyJerry(jerry);
+        jerry = NULL;
+    }
+    return jerry;
+}
+
+static void closeConfigSource(void* source) {
+    closeConfigIndex(((ConfigSource*)source)->index);
+    free(source);
+}
+
+
+// opens a configuration file without parsing its Jerries, each is parsed from the file when first used
+status openLazyConfigurationFile(JerryBoree* boree, const char* filename, int numPlanets) {
+    ConfigSource* config = (ConfigSource*)calloc(1, sizeof(ConfigSource));
+    if (!config) {
+        return memory_problem;
+    }
+    config->daycare = boree;
+    ConfigHandlers handlers = { config, loadIndexedPlanet, loadIndexedJerry, loadIndexedCharacteristic };
+    config->index = openConfigIndex(filename, numPlanets, &handlers);
+    if (!config->index) {
+        free(config);
+        return failure;
+    }
+
+    LazyJerries source = { config, findConfigRecord, findConfigRecordsWith, loadConfigRecord, closeConfigSource,
+                           getConfigJerryCount(config->index), NULL, false, NULL };
+    return attachLazySource(boree, &source);
+}
+
+
+
+/** Jerries loaded on first use **/
+
+
+// marks the record of a Jerry that was taken back, so it is never built again
+static Jerry checkedOutJerry;
+
+
+// returns the Jerry of a record, building it and adding it to the structures the first time
+// the Jerry is NULL if it was taken back, its characteristics are indexed by loadLazyCharacteristic
+static status loadLazyRecord(JerryBoree* daycare, int record, Jerry** jerry) {
+    LazyJerries* lazy = daycare->lazy;
+    if (record < 0 || record >= lazy->count) {
+        return failure;
+    }
+    if (!lazy->records[record]) {
+        Jerry* loaded = lazy->loadRecord(lazy->source, record);
+        if (!loaded) {
+            return memory_problem;
+        }
+        // the ID must lead back to its record, it is how a Jerry of the source is told apart from the ones taken in
+        if (lazy->findRecord(lazy->source, loaded->id) != record) {
+            destroyJerry(loaded);
+            return failure;
+        }
+        status state = addJerryToStructs(daycare, loaded);
+        if (state != success) {
+            return state;
+        }
+        lazy->records[record] = loaded;
+    }
+    *jerry = lazy->records[record] == &checkedOutJerry ? NULL : lazy->records[record];
+    return success;
+}
+
+
+// finds a Jerry that was not used yet, NULL if there is none with this ID
+static Jerry* findLazyJerry(JerryBoree* daycare, char* id) {
+    LazyJerries* lazy = daycare->lazy;
+    if (!lazy || lazy->allLoaded) {
+        return NULL;
+    }
+    Jerry* jerry = NULL;
+    int record = lazy->findRecord(lazy->source, id);
+    if (record < 0 || loadLazyRecord(daycare, record, &jerry) != success) {
+        return NULL;
+    }
+    return jerry;
+}
+
+
+// adds every Jerry of the source that has a characteristic to the characteristic lookup
+// called before the lookup of a name is read or changed, the Jerries keep the order of the source
+status loadLazyCharacteristic(JerryBoree* daycare, char* name) {
+    LazyJerries* lazy = daycare->lazy;
+    if (!lazy || lazy->allLoaded || lookupInHashTable(lazy->indexedNames, name)) {
+        return success;
+    }
+    const uint32_t* records = NULL;
+    int count = lazy->findRecordsWith(lazy->source, name, &records);
+    for (int i = 0; i < count; i++) {
+        Jerry* jerry;
+        status state = loadLazyRecord(daycare, (int)records[i], &jerry);
+        if (state != success) {
+            return state;
+        }
+        // skips the Jerries that were taken back or lost the characteristic since
+        if (jerry && hasPhysicalCharacteristic(jerry, name)) {
+            state = addToMultiValueHashTable(daycare->jerriesByCharacteristics, name, jerry);
+            if (state != success) {
+                return state;
+            }
+        }
+    }
+    return addToHashTable(lazy->indexedNames, name, lazy);
+}
+
+
+// adds a Jerry to a list and to the planet and dimension indexes
+static status addToJerryOrder(LinkedList jerries, MultiValueHashTable byPlanet, MultiValueHashTable byDimension, Jerry* jerry) {
+    status state = appendNode(jerries, jerry);
+    if (state == success) {
+        state = addToMultiValueHashTable(byPlanet, jerry->origin->planet->name, jerry);
+    }
+    if (state == success) {
+        state = addToMultiValueHashTable(byDimension, jerry->origin->dimension, jerry);
+    }
+    return state;
+}
+
+
+// adds the Jerries of the source to the lookups of the characteristics that were never looked up, in the source's order
+// the other names got theirs from loadLazyCharacteristic, and Jerries taken in since are in those already
+static status indexRemainingCharacteristics(JerryBoree* daycare) {
+    LazyJerries* lazy = daycare->lazy;
+    for (int i = 0; i < lazy->count; i++) {
+        Jerry* jerry = lazy->records[i];
+        if (jerry == &checkedOutJerry) {
+            continue;
+        }
+        for (int c = 0; c < jerry->num_characteristics; c++) {
+            char* name = jerry->characteristics[c]->name;
+            if (!lookupInHashTable(lazy->indexedNames, name)) {
+                status state = addToMultiValueHashTable(daycare->jerriesByCharacteristics, name, jerry);
+                if (state != success) {
+                    return state;
+                }
+            }
+        }
+    }
+    return success;
+}
+
+
+// builds every Jerry that was not used yet, called before anything that goes over all of the Jerries
+// every characteristic is indexed too, so once all are loaded reading the daycare never changes it
+// the Jerries are put back in the order of an eager load: the source's order, then the ones taken in since
+status loadAllLazyJerries(JerryBoree* daycare) {
+    LazyJerries* lazy = daycare->lazy;
+    if (!lazy || lazy->allLoaded) {
+        return success;
+    }
+    Jerry* jerry;
+    for (int i = 0; i < lazy->count; i++) {
+        status state = loadLazyRecord(daycare, i, &jerry);
+        if (state != success) {
+            return state;
+        }
+    }
+
+    int tableSize = find_closest_prime(getLengthList(daycare->planets) + 1);
+    LinkedList jerries = createLinkedList(copyJerryShallow, destroyJerryElement, printJerryElement, isSameJerryElement);
+    MultiValueHashTable byPlanet = createJerryGroupIndex(tableSize);
+    MultiValueHashTable byDimension = createJerryGroupIndex(tableSize);
+    status state = (jerries && byPlanet && byDimension) ? success : memory_problem;
+
+    for (int i = 0; i < lazy->count && state == success; i++) {
+        if (lazy->records[i] != &checkedOutJerry) {
+            state = addToJerryOrder(jerries, byPlanet, byDimension, lazy->records[i]);
+        }
+    }
+    if (state == success) {
+        state = indexRemainingCharacteristics(daycare);
+    }
+    // reading the list in order is linear, getDataByIndex continues from the last position
+    for (int i = 1; i < getLengthList(daycare->jerries) + 1 && state == success; i++) {
+        jerry = getDataByIndex(daycare->jerries, i);
+        int record = lazy->findRecord(lazy->source, jerry->id);
+        if (record < 0 || lazy->records[record] != jerry) {
+            state = addToJerryOrder(jerries, byPlanet, byDimension, jerry);
+        }
+    }
+
+    // the old structures only lose their nodes, the Jerries move to the new ones
+    LinkedList oldJerries = state == success ? daycare->jerries : jerries;
+    MultiValueHashTable oldByPlanet = state == success ? daycare->jerriesByPlanet : byPlanet;
+    MultiValueHashTable oldByDimension = state == success ? daycare->jerriesByDimension : byDimension;
+    if (state == success) {
+        daycare->jerries = jerries;
+        daycare->jerriesByPlanet = byPlanet;
+        daycare->jerriesByDimension = byDimension;
+        lazy->allLoaded = true;
+    }
+    if (oldJerries) destroyListShallow(oldJerries);
+    if (oldByPlanet) destroyMultiValueHashTable(oldByPlanet);
+    if (oldByDimension) destroyMultiValueHashTable(oldByDimension);
+    return state;
+}
+
+
+// a Jerry that is taken back must not be built again from its record
+static void forgetLazyJerry(JerryBoree* daycare, Jerry* jerry) {
+    LazyJerries* lazy = daycare->lazy;
+    if (!lazy) {
+        return;
+    }
+    int record = lazy->findRecord(lazy->source, jerry->id);
+    if (record >= 0 && lazy->records[record] == jerry) {
+        lazy->records[record] = &checkedOutJerry;
+    }
+}
+
+
+bool isDaycareLoaded(JerryBoree* daycare) {
+    return !daycare->lazy || daycare->lazy->allLoaded;
+}
+
+
+
+/** output **/
+
+
+// the element print functions only render their text, so a whole list is written out in a few large blocks
+static status displayRendered(LinkedList list) {
+    status displayed = displayList(list);
+    status written = flushRenderer(getStandardRenderer());
+    return displayed != success ? displayed : written;
+}
+
+static status displayRenderedByKey(MultiValueHashTable table, char* key) {
+    status displayed = displayMultiValueHashElementsByKey(table, key);
+    status written = flushRenderer(getStandardRenderer());
+    return displayed != success ? displayed : written;
+}
+
+// messages of the commands that may run on many threads at once are rendered too, never printed
+status displayMessage(const char* message) {
+    status displayed = renderString(getStandardRenderer(), message);
+    status written = flushRenderer(getStandardRenderer());
+    return displayed != success ? displayed : written;
+}
+
+status displayUnknownCharacteristic(const char* name) {
+    Renderer out = getStandardRenderer();
+    status state = renderString(out, "Rick we can not help you - we do not know any Jerry's ");
+    if (state == success) state = renderString(out, name);
+    if (state == success) state = renderString(out, " ! \n");
+    status written = flushRenderer(out);
+    return state != success ? state : written;
+}
+
+
+
+/** listing versions **/
+
+
+// pins an epoch and gets the current listing, building it under the read lock if a change dropped it
+// returns NULL with nothing pinned if the daycare can't be listed without changing it, or if memory ran out
+JerryListing* pinJerryListing(JerryBoree* daycare, long* epoch) {
+    JerryListing* listing = pinListing(daycare->listings, epoch);
+    if (listing) {
+        return listing;
+    }
+    lockRead(daycare->lock);
+    // a lazy daycare builds its Jerries while it lists them, which takes the write lock
+    if (isDaycareLoaded(daycare)) {
+        listing = publishListing(daycare->listings, daycare->jerries, epoch);
+    }
+    unlockRead(daycare->lock);
+    return listing;
+}
+
+
+
+/** parallel scans **/
+
+
+// shows a list of Jerries, rendered by the shards when it is long enough
+static status displayJerries(JerryBoree* daycare, LinkedList jerries) {
+    if (!isWorthSharding(daycare->shards, jerries)) {
+        return displayRendered(jerries);
+    }
+    return displayOnShards(daycare->shards, jerries);
+}
+
+
+// shows the Jerries with a characteristic after its name, like displayRenderedByKey
+static status displayJerriesWithCharacteristic(JerryBoree* daycare, char* pc_name) {
+    LinkedList jerries_with_pc = lookupInMultiValueHashTable(daycare->jerriesByCharacteristics, pc_name);
+    if (!isWorthSharding(daycare->shards, jerries_with_pc)) {
+        return displayRenderedByKey(daycare->jerriesByCharacteristics, pc_name);
+    }
+    status named = print_pc_name(pc_name);
+    return named == success ? displayJerries(daycare, jerries_with_pc) : named;
+}
+
+
+
+/** menu functions **/
+
+
+void printMenu() {
+    printf("Welcome Rick, what are your Jerry's needs today ? \n");
+    printf("1 : Take this Jerry away from me \n");
+    printf("2 : I think I remember something about my Jerry \n");
+    printf("3 : Oh wait. That can't be right \n");
+    printf("4 : I guess I will take back my Jerry now \n");
+    printf("5 : I can't find my Jerry. Just give me a similar one \n");
+    printf("6 : I lost a bet. Give me your saddest Jerry \n");
+    printf("7 : Show me what you got \n");
+    printf("8 : Let the Jerries play \n");
+    printf("9 : I had enough. Close this place \n");
+
+}
+
+void printOption7Menu() {
+    printf("What information do you want to know ? \n");
+    printf("1 : All Jerries \n");
+    printf("2 : All Jerries by physical characteristics \n");
+    printf("3 : All known planets \n");
+    printf("4 : All Jerries from planets near a location \n");
+    printf("5 : Nearest known planets to a location \n");
+}
+
+void printOption8Menu() {
+    printf("What activity do you want the Jerries to partake in ? \n");
+    printf("1 : Interact with fake Beth \n");
+    printf("2 : Play golf \n");
+    printf("3 : Adjust the picture settings on the TV \n");
+}
+
+
+
+/** Utilities functions **/
+
+// drops a reference the caller took to an origin, and takes the origin out of the registry
+// once the registry holds the only reference left, that is once no Jerry is from it anymore
+static void releaseDaycareOrigin(JerryBoree* daycare, Origin* origin) {
+    if (!daycare || !origin) {
+        return;
+    }
+    bool registered = lookupInHashTable(daycare->origins, origin) == origin;
+    releaseOrigin(origin);
+    if (registered && origin->references == 1) {
+        removeFromHashTable(daycare->origins, origin);
+    }
+}
+
+// removes Jerry from all structures and frees memory accordingly, without telling Rick
+static status unlinkJerry(JerryBoree* daycare, Jerry* jerry) {
+    dropListing(daycare->listings);
+
+
+    // delete all jerries associate
+    int numChars = jerry->num_characteristics;
+    for (int i = 0; i < numChars; i++) {
         PhysicalCharacteristic* pc = jerry->characteristics[i];
         if (pc) {
             removeFromMultiValueHashTable(daycare->jerriesByCharacteristics,
@@ -539,12 +1287,31 @@ status deleteJerryFromStructures(JerryBoree* daycare, Jerry* jerry) {
         }
     }
 
+    removeFromMultiValueHashTable(daycare->jerriesByPlanet, jerry->origin->planet->name, jerry);
+    removeFromMultiValueHashTable(daycare->jerriesByDimension, jerry->origin->dimension, jerry);
+
     // remove Jerry from id's hash table
     status jerries_id_state = removeFromHashTable(daycare->jerriesByID, jerry->id);
     if (jerries_id_state != success) {
         return jerries_id_state;
     }
+    forgetLazyJerry(daycare, jerry);
+
+    // keeps the origin alive past the Jerry, to see whether another Jerry is still from it
+    Origin* origin = retainOrigin(jerry->origin);
     status jerry_delete = deleteNode(daycare->jerries, jerry);
+    releaseDaycareOrigin(daycare, origin);
+    return jerry_delete;
+}
+
+// takes a Jerry back, the checkout is journaled before the Jerry is freed
+status deleteJerryFromStructures(JerryBoree* daycare, Jerry* jerry) {
+    if (!daycare || !jerry) return null_pointer;
+    status logged = daycare->journal ? journalCheckout(daycare->journal, jerry->id) : success;
+    if (logged != success) {
+        return logged;
+    }
+    status jerry_delete = unlinkJerry(daycare, jerry);
     if (jerry_delete != success) {
         return jerry_delete;
     }
@@ -553,7 +1320,153 @@ status deleteJerryFromStructures(JerryBoree* daycare, Jerry* jerry) {
     return success;
 }
 
-// finds Jerry through the Jerry's ID hashtable
+// Jerry group predicates, the first element is a Jerry and the second is the group's key
+static bool isJerryFromDimension(Element jerry, Element dimension) {
+    if (!jerry || !dimension) {
+        return false;
+    }
+    return strcmp(((Jerry*)jerry)->origin->dimension, (char*)dimension) == 0;
+}
+
+static bool isJerryFromPlanet(Element jerry, Element planet_name) {
+    if (!jerry || !planet_name) {
+        return false;
+    }
+    return strcmp(((Jerry*)jerry)->origin->planet->name, (char*)planet_name) == 0;
+}
+
+
+// adds an element to an ordered set made of a hash table for membership and a list for the order
+static status addToDistinct(hashTable seen, LinkedList order, Element element) {
+    if (lookupInHashTable(seen, element)) {
+        return success; // already collected
+    }
+    status state = addToHashTable(seen, element, element);
+    if (state != success) {
+        return state;
+    }
+    return appendNode(order, element);
+}
+
+
+// removes every Jerry of a group from all structures and frees them
+// every list is walked once per distinct key instead of once per Jerry
+static status deleteJerryGroupFromStructures(JerryBoree* daycare, LinkedList group, EqualFunction isInGroup, char* key) {
+    dropListing(daycare->listings);
+    int group_size = getLengthList(group);
+    int set_size = find_closest_prime(group_size);
+
+    // distinct characteristic names and origins of the group, the names are borrowed from the Jerries
+    hashTable seen_names = createHashTable(copyBorrowed, freeBorrowed, printString, copyBorrowed, freeBorrowed, printString,
+                                           isEqualString, transformStringHash, set_size);
+    LinkedList names = createLinkedList(copyBorrowed, freeBorrowed, printString, isEqualString);
+    hashTable seen_origins = createHashTable(copyBorrowed, freeBorrowed, printOriginElement, copyBorrowed, freeBorrowed,
+                                             printOriginElement, isEqualOrigin, transformOriginHash, set_size);
+    LinkedList origins = createLinkedList(copyBorrowed, freeBorrowed, printOriginElement, isEqualOrigin);
+
+    status state = (seen_names && names && seen_origins && origins) ? success : memory_problem;
+
+    // collects everything before changing any index, so a failure leaves the daycare as it was
+    for (int i = 1; i < group_size + 1 && state == success; i++) {
+        Jerry* jerry = getDataByIndex(group, i);
+        for (int j = 0; j < jerry->num_characteristics && state == success; j++) {
+            state = addToDistinct(seen_names, names, jerry->characteristics[j]->name);
+        }
+        if (state == success) {
+            state = addToDistinct(seen_origins, origins, jerry->origin);
+        }
+    }
+
+    if (state == success) {
+        // the group list belongs to an index that changes below, so it is walked first
+        for (int i = 1; i < group_size + 1; i++) {
+            Jerry* jerry = getDataByIndex(group, i);
+            removeFromHashTable(daycare->jerriesByID, jerry->id);
+            forgetLazyJerry(daycare, jerry);
+        }
+        for (int i = 1; i < getLengthList(names) + 1; i++) {
+            removeMatchingFromMultiValueHashTable(daycare->jerriesByCharacteristics, getDataByIndex(names, i), isInGroup, key);
+        }
+        for (int i = 1; i < getLengthList(origins) + 1; i++) {
+            Origin* origin = getDataByIndex(origins, i);
+            removeMatchingFromMultiValueHashTable(daycare->jerriesByPlanet, origin->planet->name, isInGroup, key);
+            removeMatchingFromMultiValueHashTable(daycare->jerriesByDimension, origin->dimension, isInGroup, key);
+        }
+
+        // frees the Jerries, the origins are kept alive past them
+        for (int i = 1; i < getLengthList(origins) + 1; i++) {
+            retainOrigin(getDataByIndex(origins, i));
+        }
+        state = deleteMatchingNodes(daycare->jerries, isInGroup, key);
+        for (int i = 1; i < getLengthList(origins) + 1; i++) {
+            releaseDaycareOrigin(daycare, getDataByIndex(origins, i));
+        }
+    }
+
+    destroyHashTable(seen_names);
+    destroyList(names);
+    destroyHashTable(seen_origins);
+    destroyList(origins);
+    return state;
+}
+
+
+// the Jerries from a planet or from a dimension, after all of them are loaded
+static status lookupJerryGroup(JerryBoree* daycare, bool byPlanet, char* key, LinkedList* group) {
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) {
+        return loaded;
+    }
+    *group = lookupInMultiValueHashTable(byPlanet ? daycare->jerriesByPlanet : daycare->jerriesByDimension, key);
+    return success;
+}
+
+// takes back every Jerry from a planet or from a dimension
+static status checkoutJerryGroup(JerryBoree* daycare, bool byPlanet, char* key) {
+    LinkedList group;
+    status found = lookupJerryGroup(daycare, byPlanet, key, &group);
+    if (found != success) {
+        return found;
+    }
+    if (!group || getLengthList(group) == 0) {
+        printf("Rick we can not help you - we do not know any Jerry from %s ! \n", key);
+        return success;
+    }
+    printf("Rick these are all the Jerries we found : \n");
+    displayRendered(group);
+
+    status logged = daycare->journal ? journalGroupCheckout(daycare->journal, byPlanet, key) : success;
+    if (logged != success) {
+        return logged;
+    }
+    status structures_removal = deleteJerryGroupFromStructures(daycare, group, byPlanet ? isJerryFromPlanet : isJerryFromDimension, key);
+    if (structures_removal != success) {
+        return structures_removal;
+    }
+    printf("Rick thank you for using our daycare service ! Your Jerries await ! \n");
+    return success;
+}
+
+// takes back every Jerry from a dimension
+status checkoutJerriesFromDimension(JerryBoree* daycare, char* dimension) {
+    if (!daycare || !dimension) return null_pointer;
+    return checkoutJerryGroup(daycare, false, dimension);
+}
+
+// takes back every Jerry from a planet
+status checkoutJerriesFromPlanet(JerryBoree* daycare, char* planet_name) {
+    if (!daycare || !planet_name) return null_pointer;
+    return checkoutJerryGroup(daycare, true, planet_name);
+}
+
+// finds Jerry through the Jerry's ID hashtable, then among the Jerries that were not used yet
+Jerry* lookupJerry(JerryBoree* daycare, char* id) {
+    Jerry* jerry = lookupInHashTable(daycare->jerriesByID, id);
+    if (!jerry) return findLazyJerry(daycare, id);
+    return jerry;
+}
+
+// asks Rick for a Jerry's ID and finds that Jerry
 Jerry* findJerryByID(JerryBoree* daycare, char* jerry_id) {
     if (!daycare || !jerry_id) return NULL;
     // get Jerry ID
@@ -563,10 +1476,7 @@ Jerry* findJerryByID(JerryBoree* daycare, char* jerry_id) {
     clearBuffer();
     strcpy(jerry_id, id);
 
-    // look up Jerry
-    Jerry* jerry = lookupInHashTable(daycare->jerriesByID, id);
-    if (!jerry) return NULL;
-    return jerry;
+    return lookupJerry(daycare, id);
 }
 
 // calculates the updated happiness level of a given Jerry and keeps it in bound
@@ -577,6 +1487,19 @@ static int adjustHappiness(int current_happiness, int change) {
     return newHappiness;
 }
 
+// takes in a Jerry whose details are known, the intake is journaled before the Jerry is added
+status intakeJerry(JerryBoree* daycare, char* id, Planet* planet, char* dimension, int happiness) {
+    status logged = daycare->journal ? journalIntake(daycare->journal, id, planet->name, dimension, happiness) : success;
+    if (logged != success) return logged;
+
+    Jerry* new_jerry = createDaycareJerry(daycare, id, happiness, planet, dimension);
+    if (!new_jerry) return memory_problem;
+    printJerry(new_jerry);
+
+    // add Jerry to the structures
+    return addJerryToStructs(daycare, new_jerry);
+}
+
 status addJerryToDayCare(JerryBoree* daycare) {
     if (!daycare) return null_pointer;
 
@@ -593,8 +1516,8 @@ status addJerryToDayCare(JerryBoree* daycare) {
     scanf("%s", planet_name);
     clearBuffer();
 
-    // search for planet in the planets LinkedList
-    Planet* planet= searchByKeyInList(daycare->planets, planet_name);
+    // search for planet in the planets index
+    Planet* planet = lookupInHashTable(daycare->planetsByName, planet_name);
     if (!planet) { // planet not found in planets
         printf("%s is not a known planet ! \n", planet_name);
         return success;
@@ -612,14 +1535,44 @@ status addJerryToDayCare(JerryBoree* daycare) {
     scanf("%d", &happiness);
     clearBuffer();
 
-    Jerry* new_jerry = createJerry(id, happiness, planet, dimension);
-    if (!new_jerry) return memory_problem;
-    printJerry(new_jerry);
+    return intakeJerry(daycare, id, planet, dimension, happiness);
+    }
 
-    // add Jerry to the structures
-    return addJerryToStructs(daycare, new_jerry);
+
+
+// adds a characteristic the Jerry doesn't have yet, to the Jerry and to the characteristic lookup
+static status addCharacteristicToJerry(JerryBoree* daycare, Jerry* jerry, char* pc_name, double value) {
+    // the Jerries that already have it come first in the lookup
+    status indexed = loadLazyCharacteristic(daycare, pc_name);
+    if (indexed != success) return indexed;
+
+    // create and add the characteristic
+    PhysicalCharacteristic* pc = createPhysicalCharacteristic(pc_name, value);
+    if (!pc) return memory_problem;
+
+    dropListing(daycare->listings);
+    status add_pc_to_jerry = addPhysicalCharacteristic(jerry, pc);
+    if (add_pc_to_jerry != success) {
+        destroyPhysicalCharacteristic(pc);  // clean up if add fails
+        return add_pc_to_jerry;
+    }
+    return addToMultiValueHashTable(daycare->jerriesByCharacteristics, pc_name, jerry);
+}
+
+
+// journals and adds a new characteristic, then shows every Jerry that has it
+status addCharacteristicAndShow(JerryBoree* daycare, Jerry* jerry, char* pc_name, double value) {
+    status logged = daycare->journal ? journalAddCharacteristic(daycare->journal, jerry->id, pc_name, value) : success;
+    if (logged != success) return logged;
+
+    status add_pc = addCharacteristicToJerry(daycare, jerry, pc_name, value);
+    if (add_pc != success) {
+        return add_pc;
     }
 
+    // display all Jerries with this characteristic
+    return displayJerriesWithCharacteristic(daycare, pc_name);
+}
 
 
 status addPhysCharToJerry(JerryBoree* daycare) {
@@ -650,29 +1603,45 @@ status addPhysCharToJerry(JerryBoree* daycare) {
     // get characteristic value
     double value;  // changed to double since physical characteristics are real numbers
     printf("What is the value of his %s ? \n", pc_name);
-    scanf("%lf", &value);
-    clearBuffer();
+    if (!readDecimal(&value)) {
+        printf("Rick this value is not known to the daycare ! \n");
+        return success;
+    }
 
-    // create and add the characteristic
-    PhysicalCharacteristic* pc = createPhysicalCharacteristic(pc_name, value);
-    if (!pc) return memory_problem;
+    return addCharacteristicAndShow(daycare, jerry, pc_name, value);
+}
 
-    status add_pc_to_jerry = addPhysicalCharacteristic(jerry, pc);
-    if (add_pc_to_jerry != success) {
-        destroyPhysicalCharacteristic(pc);  // clean up if add fails
-        return add_pc_to_jerry;
-    }
 
-    status add_to_mvht = addToMultiValueHashTable(daycare->jerriesByCharacteristics, pc_name, jerry);
-    if (add_to_mvht != success) {
-        return add_to_mvht;
-    }
 
-    // display all Jerries with this characteristic
-    return displayMultiValueHashElementsByKey(daycare->jerriesByCharacteristics, pc_name);
+// removes a characteristic the Jerry has, from the Jerry and from the characteristic lookup
+static status removeCharacteristicFromJerry(JerryBoree* daycare, Jerry* jerry, char* pc_name) {
+    status indexed = loadLazyCharacteristic(daycare, pc_name);
+    if (indexed != success) {
+        return indexed;
+    }
+    status delete_mvht = removeFromMultiValueHashTable(daycare->jerriesByCharacteristics, pc_name, jerry);
+    if (delete_mvht != success) {
+        return delete_mvht;
+    }
+    dropListing(daycare->listings);
+    return deletePhysicalCharacteristic(jerry, pc_name);
 }
 
 
+// journals and removes a characteristic the Jerry has, then shows the Jerry
+status removeCharacteristicAndShow(JerryBoree* daycare, Jerry* jerry, char* pc_name) {
+    status logged = daycare->journal ? journalRemoveCharacteristic(daycare->journal, jerry->id, pc_name) : success;
+    if (logged != success) {
+        return logged;
+    }
+    status delete_state = removeCharacteristicFromJerry(daycare, jerry, pc_name);
+    if (delete_state != success) {
+        return delete_state;
+    }
+    printJerry(jerry);
+    return success;
+}
+
 
 status deletePhysCharFromJerry(JerryBoree* daycare) {
     if (!daycare) return null_pointer;
@@ -693,16 +1662,7 @@ status deletePhysCharFromJerry(JerryBoree* daycare) {
         printf("The information about his %s not available to the daycare ! \n", pc_name);
         return success;
     }
-    status delete_mvht = removeFromMultiValueHashTable(daycare->jerriesByCharacteristics, pc_name, jerry);
-    if (delete_mvht != success) {
-        return delete_mvht;
-    }
-    status delete_state = deletePhysicalCharacteristic(jerry, pc_name);
-    if (delete_state != success) {
-        return delete_state;
-    }
-    printJerry(jerry);
-    return success;
+    return removeCharacteristicAndShow(daycare, jerry, pc_name);
 }
 
 
@@ -726,31 +1686,12 @@ status removeJerryFromDaycare(JerryBoree* daycare) {
 }
 
 
-status removeSimilarJerry(JerryBoree* daycare) {
-    if (!daycare) return null_pointer;
-
-
-    char pc_name[MAX_LINE_LENGTH];
-    printf("What do you remember about your Jerry ? \n");
-    scanf("%s", pc_name);
-    clearBuffer();
-
-
-    // the list contains all jerries with the requested physical characteristics
-    LinkedList jerries_with_pc = lookupInMultiValueHashTable(daycare->jerriesByCharacteristics, pc_name);
-
-
-    if (!jerries_with_pc) { // if characteristic not found
-        printf("Rick we can not help you - we do not know any Jerry's %s ! \n", pc_name);
-        return success;
+// takes back the Jerry whose characteristic value is the closest to the one Rick remembers
+// finds the Jerry whose characteristic is closest to a value, NULL if none has it
+Jerry* findSimilarJerry(JerryBoree* daycare, LinkedList jerries_with_pc, char* pc_name, double target_value) {
+    if (isWorthSharding(daycare->shards, jerries_with_pc)) {
+        return findSimilarOnShards(daycare->shards, jerries_with_pc, pc_name, target_value);
     }
-
-    double target_value;
-    printf("What do you remember about the value of his %s ? \n", pc_name);
-    scanf("%lf", &target_value);
-    clearBuffer();
-
-
     // we need to search in the list for the characteristic
     int list_length = getLengthList(jerries_with_pc);
     double smallest_diff = -1; //
@@ -770,29 +1711,67 @@ status removeSimilarJerry(JerryBoree* daycare) {
             closest_jerry = curr_jerry;
         }
     }
+    return closest_jerry;
+}
+
+status takeSimilarJerry(JerryBoree* daycare, LinkedList jerries_with_pc, char* pc_name, double target_value) {
+    Jerry* closest_jerry = findSimilarJerry(daycare, jerries_with_pc, pc_name, target_value);
+    if (closest_jerry) {
+        printf("Rick this is the most suitable Jerry we found : \n");
+        printJerry(closest_jerry);
+        status structures_removal = deleteJerryFromStructures(daycare, closest_jerry);
+        if (structures_removal != success) {
+            return structures_removal;
+        }
+    }
+    return success;
+}
+
+
+status removeSimilarJerry(JerryBoree* daycare) {
+    if (!daycare) return null_pointer;
+
+
+    char pc_name[MAX_LINE_LENGTH];
+    printf("What do you remember about your Jerry ? \n");
+    scanf("%s", pc_name);
+    clearBuffer();
+
+
+    status indexed = loadLazyCharacteristic(daycare, pc_name);
+    if (indexed != success) {
+        return indexed;
+    }
 
-    if (closest_jerry) {
-        printf("Rick this is the most suitable Jerry we found : \n");
-        printJerry(closest_jerry);
-        status structures_removal = deleteJerryFromStructures(daycare, closest_jerry);
-        if (structures_removal != success) {
-            return structures_removal;
-        }
+    // the list contains all jerries with the requested physical characteristics
+    LinkedList jerries_with_pc = lookupInMultiValueHashTable(daycare->jerriesByCharacteristics, pc_name);
+
+
+    if (!jerries_with_pc) { // if characteristic not found
+        printf("Rick we can not help you - we do not know any Jerry's %s ! \n", pc_name);
+        return success;
     }
-    return success;
+
+    double target_value;
+    printf("What do you remember about the value of his %s ? \n", pc_name);
+    if (!readDecimal(&target_value)) {
+        printf("Rick this value is not known to the daycare ! \n");
+        return success;
+    }
+
+    return takeSimilarJerry(daycare, jerries_with_pc, pc_name, target_value);
 }
 
 
-status removeSaddestJerry(JerryBoree* daycare) {
-    if (!daycare) return null_pointer;
-    if (getLengthList(daycare->jerries) == 0) { // no jerries in the daycare
-        printf("Rick we can not help you - we currently have no Jerries in the daycare ! \n");
-        return success;
+// finds the saddest Jerry, the first one among the equally sad, on the shards if the daycare has enough Jerries
+static Jerry* findSaddestJerry(JerryBoree* daycare) {
+    if (isWorthSharding(daycare->shards, daycare->jerries)) {
+        return findSaddestOnShards(daycare->shards, daycare->jerries);
     }
     LinkedList all_jerries = daycare->jerries;
     Jerry* saddest_jerry = getDataByIndex(all_jerries, 1);
     if (!saddest_jerry) {
-        return failure;
+        return NULL;
     }
 
 
@@ -807,6 +1786,22 @@ status removeSaddestJerry(JerryBoree* daycare) {
             saddest_level = curr_jerry->happiness;
         }
     }
+    return saddest_jerry;
+}
+
+
+status removeSaddestJerry(JerryBoree* daycare) {
+    if (!daycare) return null_pointer;
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) return loaded;
+    if (getLengthList(daycare->jerries) == 0) { // no jerries in the daycare
+        printf("Rick we can not help you - we currently have no Jerries in the daycare ! \n");
+        return success;
+    }
+    Jerry* saddest_jerry = findSaddestJerry(daycare);
+    if (!saddest_jerry) {
+        return failure;
+    }
     if (saddest_jerry) {
         printf("Rick this is the most suitable Jerry we found : \n");
         printJerry(saddest_jerry);
@@ -822,11 +1817,12 @@ status removeSaddestJerry(JerryBoree* daycare) {
 
 status printAllJerries(JerryBoree* daycare) {
     if (!daycare) return null_pointer;
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) return loaded;
     if (getLengthList(daycare->jerries) == 0) {
-        printf("Rick we can not help you - we currently have no Jerries in the daycare ! \n");
-        return success;
+        return displayMessage("Rick we can not help you - we currently have no Jerries in the daycare ! \n");
     }
-    return displayList(daycare->jerries);
+    return displayJerries(daycare, daycare->jerries);
 }
 
 status printJerriesByPhysicalCharacteristic(JerryBoree* daycare) {
@@ -836,13 +1832,94 @@ status printJerriesByPhysicalCharacteristic(JerryBoree* daycare) {
     scanf("%s", pc_name);
     clearBuffer();
 
+    status indexed = loadLazyCharacteristic(daycare, pc_name);
+    if (indexed != success) {
+        return indexed;
+    }
     LinkedList jerries_with_pc = lookupInMultiValueHashTable(daycare->jerriesByCharacteristics, pc_name);
     if (!jerries_with_pc || getLengthList(jerries_with_pc) == 0) {
         printf("Rick we can not help you - we do not know any Jerry's %s ! \n", pc_name);
         return success;
     }
-    return displayMultiValueHashElementsByKey(daycare->jerriesByCharacteristics, pc_name);
+    return displayJerriesWithCharacteristic(daycare, pc_name);
+
+}
+
+// reads a location in space from the user, returns false if the input is not three numbers
+static bool readLocation(double* x, double* y, double* z) {
+    printf("What are the coordinates of the location ? \n");
+    int read = scanf("%lf %lf %lf", x, y, z);
+    clearBuffer();
+    return read == 3;
+}
+
+status printJerriesNearLocation(JerryBoree* daycare) {
+    if (!daycare) return null_pointer;
+    double x, y, z, radius;
+    if (!readLocation(&x, &y, &z)) {
+        printf("Rick this location is not known to the daycare ! \n");
+        return success;
+    }
+    printf("How far from the location should we look ? \n");
+    int read = scanf("%lf", &radius);
+    clearBuffer();
+    if (read != 1 || radius < 0) {
+        printf("Rick this distance is not known to the daycare ! \n");
+        return success;
+    }
+
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) return loaded;
+
+    // the result list only borrows the planets
+    LinkedList near_planets = createLinkedList(copyPlanet, freePlanetPtr, printPlanetPtr, isEqualPlanet);
+    if (!near_planets) return memory_problem;
+    status state = searchKdTreeInRadius(daycare->planetsBySpace, x, y, z, radius, near_planets);
+    if (state != success) {
+        destroyList(near_planets);
+        return state;
+    }
+
+    if (getLengthList(near_planets) == 0) {
+        printf("Rick we can not help you - we do not know any planet near this location ! \n");
+    }
+    for (int i = 1; i < getLengthList(near_planets) + 1; i++) {
+        Planet* planet = getDataByIndex(near_planets, i);
+        printPlanet(planet);
+        LinkedList planet_jerries = lookupInMultiValueHashTable(daycare->jerriesByPlanet, planet->name);
+        if (planet_jerries) {
+            displayRendered(planet_jerries);
+        }
+    }
+    destroyList(near_planets);
+    return success;
+}
+
+status printNearestPlanets(JerryBoree* daycare) {
+    if (!daycare) return null_pointer;
+    double x, y, z;
+    int count;
+    if (!readLocation(&x, &y, &z)) {
+        printf("Rick this location is not known to the daycare ! \n");
+        return success;
+    }
+    printf("How many planets do you want to know about ? \n");
+    int read = scanf("%d", &count);
+    clearBuffer();
+    if (read != 1 || count <= 0) {
+        printf("Rick this number is not known to the daycare ! \n");
+        return success;
+    }
 
+    // the result list only borrows the planets
+    LinkedList nearest_planets = createLinkedList(copyPlanet, freePlanetPtr, printPlanetPtr, isEqualPlanet);
+    if (!nearest_planets) return memory_problem;
+    status state = searchKdTreeNearest(daycare->planetsBySpace, x, y, z, count, nearest_planets);
+    if (state == success) {
+        state = displayRendered(nearest_planets);
+    }
+    destroyList(nearest_planets);
+    return state;
 }
 
 status showInformation(JerryBoree* daycare) {
@@ -852,7 +1929,7 @@ status showInformation(JerryBoree* daycare) {
     scanf("%s", choice);
     clearBuffer();
 
-    if (strlen(choice) != 1 || choice[0] < '1' || choice[0] > '3') {
+    if (strlen(choice) != 1 || choice[0] < '1' || choice[0] > '5') {
         printf("Rick this option is not known to the daycare ! \n");
         return success;  // return to main menu
     }
@@ -867,7 +1944,15 @@ status showInformation(JerryBoree* daycare) {
         }
 
         case '3': { // all planets
-            return displayList(daycare->planets);
+            return displayRendered(daycare->planets);
+        }
+
+        case '4': { // Jerries from planets near a location
+            return printJerriesNearLocation(daycare);
+        }
+
+        case '5': { // nearest planets to a location
+            return printNearestPlanets(daycare);
         }
 
         default: {
@@ -876,55 +1961,101 @@ status showInformation(JerryBoree* daycare) {
     }
 }
 
-status JerriesPlayWithBeth(JerryBoree* daycare) {
-    if (!daycare) return null_pointer;
-    for (int i = 1; i < getLengthList(daycare->jerries) + 1; i++) {
-        Jerry* jerry = getDataByIndex(daycare->jerries, i);
-        if (!jerry) continue;
-        if (jerry->happiness >= 20) {
-            jerry->happiness = adjustHappiness(jerry->happiness, 15); // +15 if happiness >= 20
-
+// the happiness of a Jerry after one of the activities of the menu
+static int happinessAfterActivity(int happiness, int activity) {
+    switch (activity) {
+        case 1: { // play with fake beth
+            // +15 if happiness >= 20, -5 if happiness < 20
+            return adjustHappiness(happiness, happiness >= 20 ? 15 : -5);
         }
-        else {
-            jerry->happiness = adjustHappiness(jerry->happiness, -5);  // -5 if happiness < 20
+        case 2: { // play golf
+            // +10 if happiness >= 50, -10 if happiness < 50
+            return adjustHappiness(happiness, happiness >= 50 ? 10 : -10);
+        }
+        case 3: { // adjust tv settings
+            return adjustHappiness(happiness, 20);
+        }
+        default: {
+            return happiness;
         }
+    }
+}
 
+
+// lets every Jerry of a list play an activity
+static void playJerries(LinkedList jerries, int activity) {
+    for (int i = 1; i < getLengthList(jerries) + 1; i++) {
+        Jerry* jerry = getDataByIndex(jerries, i);
+        if (!jerry) continue;
+        jerry->happiness = happinessAfterActivity(jerry->happiness, activity);
     }
+}
+
+status JerriesPlayWithBeth(JerryBoree* daycare) {
+    if (!daycare) return null_pointer;
+    playJerries(daycare->jerries, 1);
     return success;
 }
 
 status JerriesPlayGolf (JerryBoree* daycare) {
     if (!daycare) return null_pointer;
-    for (int i = 1; i < getLengthList(daycare->jerries) + 1; i++) {
-        Jerry* jerry = getDataByIndex(daycare->jerries, i);
-        if (!jerry) continue;
-
-        if (jerry->happiness >= 50) { // +10 if happiness >= 50
-            jerry->happiness = adjustHappiness(jerry->happiness, 10);
-        }
-        else { // +10 if happiness >= 50
-            jerry->happiness = adjustHappiness(jerry->happiness, -10);
-        }
-    }
+    playJerries(daycare->jerries, 2);
     return success;
 }
 
 status JerriesAdjustTV(JerryBoree* daycare) {
     if (!daycare) return null_pointer;
-    for (int i = 1; i < getLengthList(daycare->jerries) + 1; i++) {
-        Jerry* jerry = getDataByIndex(daycare->jerries, i);
-        if (!jerry) continue;
+    playJerries(daycare->jerries, 3);
+    return success;
+
+}
+
 
-        jerry->happiness = adjustHappiness(jerry->happiness, 20);
+// lets every Jerry play one of the activities of the menu, every shard plays a run of them if the daycare has enough
+static void playActivity(JerryBoree* daycare, int activity) {
+    dropListing(daycare->listings);
+    if (isWorthSharding(daycare->shards, daycare->jerries)) {
+        playOnShards(daycare->shards, daycare->jerries, activity, happinessAfterActivity);
+        return;
     }
-    return success;
+    switch (activity) {
+        case 1: { // play with fake beth
+            JerriesPlayWithBeth(daycare);
+            break;
+        }
+        case 2: { // play golf
+            JerriesPlayGolf(daycare);
+            break;
+        }
+        case 3: { // adjust tv settings
+            JerriesAdjustTV(daycare);
+            break;
+        }
+
+        default: {
+            break;
+        }
+    }
+}
+
 
+// journals and plays an activity, then shows how every Jerry feels
+status playAndShow(JerryBoree* daycare, int activity) {
+    status logged = daycare->journal ? journalPlay(daycare->journal, activity) : success;
+    if (logged != success) return logged;
+    playActivity(daycare, activity);
+
+    // print activity completion and updated Jerry states
+    printf("The activity is now over ! \n");
+    return displayJerries(daycare, daycare->jerries);
 }
 
 
 status letJerriesPlay(JerryBoree* daycare) {
 
     if (!daycare) return null_pointer;
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) return loaded;
 
     // check if there are any Jerries
     if (getLengthList(daycare->jerries) == 0) {
@@ -943,66 +2074,278 @@ status letJerriesPlay(JerryBoree* daycare) {
         return success;  // return to main menu
     }
 
+    return playAndShow(daycare, choice[0] - '0');
+}
+
+/** replay the journal **/
+
+// every change was valid when it was journaled, one that no longer applies means
+// the journal is replayed over another configuration, and it is skipped
+
+
+static status replayIntake(void* context, char* id, char* planetName, char* dimension, int happiness) {
+    JerryBoree* daycare = (JerryBoree*)context;
+    Planet* planet = lookupInHashTable(daycare->planetsByName, planetName);
+    if (!planet || lookupJerry(daycare, id)) {
+        return success;
+    }
+    Jerry* jerry = createDaycareJerry(daycare, id, happiness, planet, dimension);
+    if (!jerry) return memory_problem;
+    return addJerryToStructs(daycare, jerry);
+}
+
 
-    switch (choice[0]) {
-        case '1': { // play with fake beth
-            JerriesPlayWithBeth(daycare);
-            break;
-        }
-        case '2': { // play golf
-            JerriesPlayGolf(daycare);
-            break;
-        }
-        case '3': { // adjust tv settings
-            JerriesAdjustTV(daycare);
-            break;
-        }
+static status replayCheckout(void* context, char* id) {
+    JerryBoree* daycare = (JerryBoree*)context;
+    Jerry* jerry = lookupJerry(daycare, id);
+    return jerry ? unlinkJerry(daycare, jerry) : success;
+}
 
-        default: {
-            return success;
-        }
+
+static status replayAddCharacteristic(void* context, char* id, char* name, double value) {
+    JerryBoree* daycare = (JerryBoree*)context;
+    Jerry* jerry = lookupJerry(daycare, id);
+    if (!jerry || hasPhysicalCharacteristic(jerry, name)) {
+        return success;
     }
+    return addCharacteristicToJerry(daycare, jerry, name, value);
+}
 
-    // print activity completion and updated Jerry states
-    printf("The activity is now over ! \n");
-    return displayList(daycare->jerries);
+
+static status replayRemoveCharacteristic(void* context, char* id, char* name) {
+    JerryBoree* daycare = (JerryBoree*)context;
+    Jerry* jerry = lookupJerry(daycare, id);
+    if (!jerry || !hasPhysicalCharacteristic(jerry, name)) {
+        return success;
+    }
+    return removeCharacteristicFromJerry(daycare, jerry, name);
+}
+
+
+static status replayGroupCheckout(void* context, bool byPlanet, char* key) {
+    JerryBoree* daycare = (JerryBoree*)context;
+    LinkedList group;
+    status found = lookupJerryGroup(daycare, byPlanet, key, &group);
+    if (found != success || !group || getLengthList(group) == 0) {
+        return found;
+    }
+    return deleteJerryGroupFromStructures(daycare, group, byPlanet ? isJerryFromPlanet : isJerryFromDimension, key);
+}
+
+
+static status replayPlay(void* context, int activity) {
+    JerryBoree* daycare = (JerryBoree*)context;
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) return loaded;
+    playActivity(daycare, activity);
+    return success;
+}
+
+
+// replays the changes journaled by earlier runs, then journals the changes of this one
+status openDaycareJournal(JerryBoree* daycare, const char* filename, int syncEvery) {
+    JournalHandlers handlers = { daycare, replayIntake, replayCheckout, replayAddCharacteristic,
+                                 replayRemoveCharacteristic, replayGroupCheckout, replayPlay };
+    return openJournal(filename, syncEvery, &handlers, &daycare->journal, NULL);
+}
+
+
+
+/** background checkpoints **/
+
+
+// runs in the checkpoint's child process, on its own copy of the daycare
+static status writeDaycareCheckpoint(void* context, size_t* bytesWritten) {
+    DaycareCheckpoint* checkpoint = (DaycareCheckpoint*)context;
+    JerryBoree* daycare = checkpoint->daycare;
+    status loaded = loadAllLazyJerries(daycare);
+    if (loaded != success) {
+        return loaded;
+    }
+    return saveSnapshot(checkpoint->filename, daycare->planets, daycare->jerries, bytesWritten);
+}
+
+
+// starts writing a checkpoint in the background, unless one is already being written
+void startDaycareCheckpoint(DaycareCheckpoint* checkpoint) {
+    if (checkpoint->running || markJournal(checkpoint->daycare->journal, &checkpoint->mark) != success) {
+        return;
+    }
+    checkpoint->running = startCheckpoint(writeDaycareCheckpoint, checkpoint);
+    if (!checkpoint->running) {
+        printf("Failed to start checkpoint '%s'.\n", checkpoint->filename);
+    }
+}
+
+
+// reports a finished checkpoint, and drops the journaled changes it holds
+static void finishDaycareCheckpoint(DaycareCheckpoint* checkpoint, CheckpointReport* report) {
+    checkpoint->running = NULL;
+    if (report->result != success) {
+        printf("Failed to save checkpoint '%s'.\n", checkpoint->filename);
+        return;
+    }
+    printf("Checkpoint saved to '%s' in %.3f seconds (%zu bytes).\n", checkpoint->filename, report->seconds,
+           report->bytesWritten);
+    if (truncateJournal(checkpoint->daycare->journal, &checkpoint->mark) != success) {
+        printf("Failed to truncate journal after checkpoint '%s'.\n", checkpoint->filename);
+    }
+}
+
+
+void pollDaycareCheckpoint(DaycareCheckpoint* checkpoint) {
+    CheckpointReport report;
+    if (checkpoint->running && pollCheckpoint(checkpoint->running, &report)) {
+        finishDaycareCheckpoint(checkpoint, &report);
+    }
 }
 
+
+static void waitDaycareCheckpoint(DaycareCheckpoint* checkpoint) {
+    CheckpointReport report;
+    if (checkpoint->running) {
+        waitCheckpoint(checkpoint->running, &report);
+        finishDaycareCheckpoint(checkpoint, &report);
+    }
+}
+
+
+// waits for the running checkpoint, saves the daycare to its snapshot and drops the journaled changes it holds
+static status closeDaycare(DaycareCheckpoint* checkpoint, const char* journalFile) {
+    JerryBoree* daycare = checkpoint->daycare;
+    // a checkpoint still being written would race the last save for the snapshot
+    waitDaycareCheckpoint(checkpoint);
+    if (!checkpoint->filename) {
+        return success;
+    }
+    JournalMark mark;
+    status result = daycare->journal ? markJournal(daycare->journal, &mark) : success;
+    if (result == success) {
+        result = loadAllLazyJerries(daycare);
+    }
+    if (result == success && saveSnapshot(checkpoint->filename, daycare->planets, daycare->jerries, NULL) != success) {
+        printf("Failed to save snapshot '%s'.\n", checkpoint->filename);
+    }
+    // the snapshot holds every journaled change now
+    else if (result == success && daycare->journal && truncateJournal(daycare->journal, &mark) != success) {
+        printf("Failed to truncate journal '%s'.\n", journalFile);
+    }
+    return result;
+}
+
+
+
 int main(int argc, char *argv[]) {
 
-    if (argc != 3) {
-        printf("Usage: %s <number_of_planets> <configuration_file>\n", argv[0]);
+    // the daycare state is saved to this snapshot when the daycare closes
+    const char* snapshotFile = NULL;
+    // the Jerries of a snapshot or a configuration file are not loaded up front, each is built when first used
+    bool lazy = false;
+    // the changes are journaled here, and flushed to the disk once every journalSync changes
+    const char* journalFile = NULL;
+    int journalSync = DEFAULT_JOURNAL_SYNC;
+    // the snapshot is saved in the background once the journal holds this many changes
+    int checkpointEvery = 0;
+    // the commands are read from this file ("-" for the standard input) instead of the menu
+    const char* batchFile = NULL;
+    // the commands of many clients are read from this socket instead of the menu
+    const char* socketPath = NULL;
+    // threads of the server that run the commands that only read
+    int workers = 0;
+    // threads the Jerries are split between, for the commands that go over all of them
+    int shards = 0;
+    bool validArguments = argc >= 3;
+    for (int i = 3; i < argc && validArguments; i++) {
+        if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshotFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--lazy") == 0) {
+            lazy = true;
+        }
+        else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journalFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--journal-sync") == 0 && i + 1 < argc) {
+            journalSync = atoi(argv[++i]);
+            validArguments = journalSync > 0;
+        }
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            checkpointEvery = atoi(argv[++i]);
+            validArguments = checkpointEvery > 0;
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+            validArguments = workers > 0;
+        }
+        else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shards = atoi(argv[++i]);
+            validArguments = shards > 0 && shards <= MAX_SHARDS;
+        }
+        else {
+            validArguments = false;
+        }
+    }
+    // a checkpoint goes to the snapshot and truncates the journal
+    if (checkpointEvery > 0 && (!snapshotFile || !journalFile)) {
+        validArguments = false;
+    }
+    if ((batchFile && socketPath) || (workers > 0 && !socketPath)) {
+        validArguments = false;
+    }
+    if (!validArguments) {
+        printf("Usage: %s <number_of_planets> <configuration_file> [--snapshot <snapshot_file>] [--lazy]"
+               " [--journal <journal_file> [--journal-sync <changes>]]"
+               " [--checkpoint-every <changes> (with --snapshot and --journal)] [--batch <command_file> | --serve <socket_path> [--workers <threads>]]"
+               " [--shards <threads>]\n", argv[0]);
         return 1;
     }
 
     int numberOfPlanets = atoi(argv[1]);
     const char* configFile = argv[2];
 
-    FILE* fp = fopen(argv[2], "r");
-    if (!fp) return 1;
-    int numJerries = 0;
-    int numUniquePcs = 0;
-    countFileStats(fp, &numJerries, &numUniquePcs);
-    fclose(fp);
-
-
-    // make sure minimum size of 2 for hash tables
-    int jerriesTableSize = find_closest_prime(numJerries ? numJerries : 2);
-    int characteristicsTableSize = find_closest_prime(numUniquePcs ? numUniquePcs : 2);
 
+    // the tables grow while a configuration file is loaded, so only the planets count is known up front
+    // a snapshot knows all of its counts, so its tables are created at their final size,
+    // unless it is opened lazily and the tables only grow with the Jerries that are used
+    SnapshotCounts counts;
+    bool fromSnapshot = readSnapshotCounts(configFile, &counts) == success;
+    bool presized = fromSnapshot && !lazy;
+    int jerriesTableSize = find_closest_prime(presized ? counts.jerries + 1 : INITIAL_TABLE_SIZE);
+    int characteristicsTableSize = find_closest_prime(presized ? counts.characteristicNames + 1 : INITIAL_TABLE_SIZE);
+    int planetsTableSize = find_closest_prime(numberOfPlanets > 0 ? numberOfPlanets : 2);
 
 
     // initialize JerryBoree
-    JerryBoree* daycare = initJerryBoree(jerriesTableSize, characteristicsTableSize);
+    JerryBoree* daycare = initJerryBoree(jerriesTableSize, characteristicsTableSize, planetsTableSize);
     if (!daycare) {
         printf("A memory problem has been detected in the program \n");
         return 1;
     }
+    // the scans over many Jerries run on the shards from the first command on
+    if (shards > 0 && shardJerryBoree(daycare, shards) != success) {
+        printf("A memory problem has been detected in the program \n");
+        destroyJerryBoree(&daycare);
+        return 1;
+    }
 
 
     // load configuration file
 
-    status result = loadConfigurationFile(daycare, configFile, numberOfPlanets);
+    status result;
+    if (fromSnapshot) {
+        result = lazy ? openLazySnapshotFile(daycare, configFile, numberOfPlanets)
+                      : loadSnapshotFile(daycare, configFile, numberOfPlanets);
+    }
+    else {
+        result = lazy ? openLazyConfigurationFile(daycare, configFile, numberOfPlanets)
+                      : loadConfigurationFile(daycare, configFile, numberOfPlanets);
+    }
     if (result != success) {
         printf("A memory problem has been detected in the program\n"
        "Failed to load configuration file '%s'.\n"
@@ -1013,12 +2356,61 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // replay the changes made since the configuration was saved
+    if (journalFile && openDaycareJournal(daycare, journalFile, journalSync) != success) {
+        printf("Failed to replay journal '%s'.\n", journalFile);
+        destroyJerryBoree(&daycare);
+        return 1;
+    }
+
+    DaycareCheckpoint checkpoint = { daycare, snapshotFile, NULL, { 0, 0 } };
+
+    // batch mode, the daycare closes at the end of the commands
+    if (batchFile) {
+        FILE* commands = strcmp(batchFile, "-") == 0 ? stdin : fopen(batchFile, "r");
+        if (!commands) {
+            printf("Failed to open command file '%s'.\n", batchFile);
+            destroyJerryBoree(&daycare);
+            return 1;
+        }
+        result = runBatch(&checkpoint, commands, checkpointEvery);
+        if (commands != stdin) {
+            fclose(commands);
+        }
+        if (result == success) {
+            result = closeDaycare(&checkpoint, journalFile);
+        }
+        if (result != success) {
+            printf("A memory problem has been detected in the program \n");
+        }
+        destroyJerryBoree(&daycare);
+        return result == success ? 0 : 1;
+    }
+
+    // server mode, the daycare closes when the server is stopped
+    if (socketPath) {
+        result = runDaycareServer(&checkpoint, socketPath, checkpointEvery, workers);
+        if (result == success) {
+            printf("The daycare is now clean and close ! \n");
+            result = closeDaycare(&checkpoint, journalFile);
+        }
+        else if (result == failure) {
+            printf("Failed to serve at '%s'.\n", socketPath);
+        }
+        else {
+            printf("A memory problem has been detected in the program \n");
+        }
+        destroyJerryBoree(&daycare);
+        return result == success ? 0 : 1;
+    }
+
     // main menu loop
 
     bool running = true;
 
 
     while (running) {
+        pollDaycareCheckpoint(&checkpoint);
         printMenu();
         char choice[MAX_LINE_LENGTH];
         scanf("%s", choice);
@@ -1075,6 +2467,7 @@ int main(int argc, char *argv[]) {
             case '9': {
                 printf("The daycare is now clean and close ! \n");
                 running = false;
+                result = closeDaycare(&checkpoint, journalFile);
                 break;
             }
 
@@ -1090,6 +2483,10 @@ int main(int argc, char *argv[]) {
             destroyJerryBoree(&daycare);
             return 1;
         }
+
+        if (running && checkpointEvery > 0 && getJournalRecords(daycare->journal) >= checkpointEvery) {
+            startDaycareCheckpoint(&checkpoint);
+        }
     }
 
     // clean up and exit
@@ -0,0 +1,512 @@
+#include "Journal.h"
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define JOURNAL_MAGIC "JBJRNL\r\n" // 8 bytes, the line end catches files mangled by a text mode transfer
+#define JOURNAL_MAGIC_LENGTH 8
+#define JOURNAL_VERSION 1
+#define INITIAL_RECORD_SIZE 256
+#define MAX_STRING_LENGTH UINT16_MAX
+
+
+/*
+ * File layout, in the byte order of the machine that wrote it:
+ * [header][record][record]...
+ * record: [body length (u32)][body][checksum of the body (u32)]
+ * body: [type (u8)][fields], a string is its length (u16), its characters and a '\0',
+ * an int is an int32, a value is a double and a flag is a u8
+ */
+typedef struct JournalHeader_t {
+    char magic[JOURNAL_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t unused;
+} JournalHeader;
+
+typedef enum {
+    RECORD_INTAKE = 1,               // id, planet name, dimension, happiness
+    RECORD_CHECKOUT,                 // id
+    RECORD_ADD_CHARACTERISTIC,       // id, name, value
+    RECORD_REMOVE_CHARACTERISTIC,    // id, name
+    RECORD_GROUP_CHECKOUT,           // by planet flag, key
+    RECORD_PLAY                      // activity
+} RecordType;
+
+
+struct Journal_s {
+    int fd;
+    char* filename;
+    int records;    // complete records in the file
+    int syncEvery;
+    int unsynced;   // records written since the last flush
+    char* record;   // the record being built
+    size_t length;
+    size_t capacity;
+};
+
+
+/* Read position in a record body */
+typedef struct RecordReader_t {
+    char* data;
+    size_t length;
+    size_t position;
+} RecordReader;
+
+
+
+// Record helper functions:
+
+static uint32_t getChecksum(const char* data, size_t length) {
+    // FNV-1a, enough to tell a torn record from a complete one
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static status appendToRecord(Journal journal, const void* data, size_t length) {
+    if (journal->length + length > journal->capacity) {
+        size_t capacity = journal->capacity * 2;
+        while (capacity < journal->length + length) {
+            capacity *= 2;
+        }
+        char* grown = (char*)realloc(journal->record, capacity);
+        if (!grown) {
+            return memory_problem;
+        }
+        journal->record = grown;
+        journal->capacity = capacity;
+    }
+    memcpy(journal->record + journal->length, data, length);
+    journal->length += length;
+    return success;
+}
+
+// starts a record, its length is filled in by finishRecord
+static status beginRecord(Journal journal, RecordType type) {
+    uint32_t length = 0;
+    uint8_t code = (uint8_t)type;
+    journal->length = 0;
+    status state = appendToRecord(journal, &length, sizeof(length));
+    return state == success ? appendToRecord(journal, &code, sizeof(code)) : state;
+}
+
+static status appendString(Journal journal, const char* string) {
+    size_t length = strlen(string);
+    if (length > MAX_STRING_LENGTH) {
+        return failure;
+    }
+    uint16_t stored = (uint16_t)length;
+    status state = appendToRecord(journal, &stored, sizeof(stored));
+    return state == success ? appendToRecord(journal, string, length + 1) : state;
+}
+
+static bool writeAll(int fd, const void* data, size_t length) {
+    const char* current = (const char*)data;
+    while (length > 0) {
+        ssize_t written = write(fd, current, length);
+        if (written <= 0) {
+            return false;
+        }
+        current += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// writes the record in one write, and flushes the group once it is full
+static status finishRecord(Journal journal) {
+    uint32_t length = (uint32_t)(journal->length - sizeof(uint32_t));
+    memcpy(journal->record, &length, sizeof(length));
+    uint32_t checksum = getChecksum(journal->record + sizeof(uint32_t), length);
+    status state = appendToRecord(journal, &checksum, sizeof(checksum));
+    if (state != success) {
+        return state;
+    }
+    if (!writeAll(journal->fd, journal->record, journal->length)) {
+        return failure;
+    }
+    journal->records++;
+    journal->unsynced++;
+    if (journal->unsynced >= journal->syncEvery) {
+        return syncJournal(journal);
+    }
+    return success;
+}
+
+
+
+// Replay helper functions:
+
+static bool readFixed(RecordReader* reader, void* value, size_t length) {
+    if (reader->length - reader->position < length) {
+        return false;
+    }
+    memcpy(value, reader->data + reader->position, length);
+    reader->position += length;
+    return true;
+}
+
+// the string is read in place, it is stored with its '\0'
+static bool readString(RecordReader* reader, char** string) {
+    uint16_t length;
+    if (!readFixed(reader, &length, sizeof(length)) || reader->length - reader->position < (size_t)length + 1
+        || reader->data[reader->position + length] != '\0') {
+        return false;
+    }
+    *string = reader->data + reader->position;
+    reader->position += (size_t)length + 1;
+    return true;
+}
+
+static bool readInt(RecordReader* reader, int* value) {
+    int32_t stored;
+    if (!readFixed(reader, &stored, sizeof(stored))) {
+        return false;
+    }
+    *value = (int)stored;
+    return true;
+}
+
+// decodes one record body and hands it to its callback, failure if the body is malformed
+static status replayRecord(RecordReader* reader, JournalHandlers* handlers) {
+    uint8_t type, flag;
+    char* id, * name, * dimension;
+    int number;
+    double value;
+    if (!readFixed(reader, &type, sizeof(type))) {
+        return failure;
+    }
+    // every field must be there and the body must end right after them
+    switch (type) {
+        case RECORD_INTAKE:
+            if (readString(reader, &id) && readString(reader, &name) && readString(reader, &dimension)
+                && readInt(reader, &number) && reader->position == reader->length) {
+                return handlers->onIntake(handlers->context, id, name, dimension, number);
+            }
+            return failure;
+        case RECORD_CHECKOUT:
+            if (readString(reader, &id) && reader->position == reader->length) {
+                return handlers->onCheckout(handlers->context, id);
+            }
+            return failure;
+        case RECORD_ADD_CHARACTERISTIC:
+            if (readString(reader, &id) && readString(reader, &name) && readFixed(reader, &value, sizeof(value))
+                && reader->position == reader->length) {
+                return handlers->onAddCharacteristic(handlers->context, id, name, value);
+            }
+            return failure;
+        case RECORD_REMOVE_CHARACTERISTIC:
+            if (readString(reader, &id) && readString(reader, &name) && reader->position == reader->length) {
+                return handlers->onRemoveCharacteristic(handlers->context, id, name);
+            }
+            return failure;
+        case RECORD_GROUP_CHECKOUT:
+            if (readFixed(reader, &flag, sizeof(flag)) && readString(reader, &name) && reader->position == reader->length) {
+                return handlers->onGroupCheckout(handlers->context, flag != 0, name);
+            }
+            return failure;
+        case RECORD_PLAY:
+            if (readInt(reader, &number) && reader->position == reader->length) {
+                return handlers->onPlay(handlers->context, number);
+            }
+            return failure;
+        default:
+            return failure;
+    }
+}
+
+static status readJournalFile(int fd, char** data, size_t* length) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        return failure;
+    }
+    *length = (size_t)info.st_size;
+    *data = (char*)malloc(*length + 1);
+    if (!*data) {
+        return memory_problem;
+    }
+    size_t done = 0;
+    while (done < *length) {
+        ssize_t got = pread(fd, *data + done, *length - done, (off_t)done);
+        if (got <= 0) {
+            free(*data);
+            return failure;
+        }
+        done += (size_t)got;
+    }
+    return success;
+}
+
+// replays the complete records of a journal, and cuts off a record that was only partly written
+static status replayJournal(int fd, JournalHandlers* handlers, int* replayed) {
+    char* data;
+    size_t length;
+    status state = readJournalFile(fd, &data, &length);
+    if (state != success) {
+        return state;
+    }
+
+    if (length == 0) { // a new journal
+        JournalHeader header = { JOURNAL_MAGIC, JOURNAL_VERSION, 0 };
+        free(data);
+        return writeAll(fd, &header, sizeof(header)) && fsync(fd) == 0 ? success : failure;
+    }
+    JournalHeader* header = (JournalHeader*)data;
+    if (length < sizeof(JournalHeader) || memcmp(header->magic, JOURNAL_MAGIC, JOURNAL_MAGIC_LENGTH) != 0
+        || header->version != JOURNAL_VERSION) {
+        free(data);
+        return failure; // not a journal, better not to write over it
+    }
+
+    size_t position = sizeof(JournalHeader);
+    while (state == success && length - position >= 2 * sizeof(uint32_t)) {
+        uint32_t bodyLength, checksum;
+        memcpy(&bodyLength, data + position, sizeof(bodyLength));
+        if (bodyLength > length - position - 2 * sizeof(uint32_t)) {
+            break; // torn
+        }
+        char* body = data + position + sizeof(uint32_t);
+        memcpy(&checksum, body + bodyLength, sizeof(checksum));
+        if (checksum != getChecksum(body, bodyLength)) {
+            break; // torn
+        }
+        RecordReader reader = { body, bodyLength, 0 };
+        state = replayRecord(&reader, handlers);
+        if (state == success) {
+            position += bodyLength + 2 * sizeof(uint32_t);
+            (*replayed)++;
+        }
+    }
+    free(data);
+    if (state != success) {
+        return state;
+    }
+    // new records go right after the last complete one
+    if (position < length && (ftruncate(fd, (off_t)position) != 0 || fsync(fd) != 0)) {
+        return failure;
+    }
+    return success;
+}
+
+
+
+// Interface Functions:
+
+status openJournal(const char* filename, int syncEvery, JournalHandlers* handlers, Journal* journal, int* replayed) {
+    if (!filename || !handlers || !journal || !handlers->onIntake || !handlers->onCheckout || !handlers->onAddCharacteristic
+        || !handlers->onRemoveCharacteristic || !handlers->onGroupCheckout || !handlers->onPlay) {
+        return null_pointer;
+    }
+    int count = 0;
+    int fd = open(filename, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return failure;
+    }
+    status state = replayJournal(fd, handlers, &count);
+    if (replayed) {
+        *replayed = count;
+    }
+    if (state != success) {
+        close(fd);
+        return state;
+    }
+
+    Journal opened = (Journal)malloc(sizeof(struct Journal_s));
+    char* record = (char*)malloc(INITIAL_RECORD_SIZE);
+    char* name = (char*)malloc(strlen(filename) + 1);
+    if (!opened || !record || !name) {
+        free(opened);
+        free(record);
+        free(name);
+        close(fd);
+        return memory_problem;
+    }
+    opened->fd = fd;
+    opened->filename = strcpy(name, filename);
+    opened->records = count;
+    opened->syncEvery = syncEvery > 0 ? syncEvery : 1;
+    opened->unsynced = 0;
+    opened->record = record;
+    opened->length = 0;
+    opened->capacity = INITIAL_RECORD_SIZE;
+    *journal = opened;
+    return success;
+}
+
+
+status closeJournal(Journal journal) {
+    if (!journal) {
+        return success;
+    }
+    status state = syncJournal(journal);
+    if (close(journal->fd) != 0) {
+        state = failure;
+    }
+    free(journal->record);
+    free(journal->filename);
+    free(journal);
+    return state;
+}
+
+
+status syncJournal(Journal journal) {
+    if (!journal) {
+        return null_pointer;
+    }
+    if (journal->unsynced == 0) {
+        return success;
+    }
+    if (fdatasync(journal->fd) != 0) {
+        return failure;
+    }
+    journal->unsynced = 0;
+    return success;
+}
+
+
+int getJournalRecords(Journal journal) {
+    return journal ? journal->records : 0;
+}
+
+
+status markJournal(Journal journal, JournalMark* mark) {
+    if (!journal || !mark) {
+        return null_pointer;
+    }
+    off_t end = lseek(journal->fd, 0, SEEK_END);
+    if (end < 0) {
+        return failure;
+    }
+    mark->position = (size_t)end;
+    mark->records = journal->records;
+    return success;
+}
+
+
+status truncateJournal(Journal journal, JournalMark* mark) {
+    if (!journal || !mark) {
+        return null_pointer;
+    }
+    off_t end = lseek(journal->fd, 0, SEEK_END);
+    if (end < 0 || mark->position < sizeof(JournalHeader) || mark->position > (size_t)end) {
+        return failure;
+    }
+    // the records after the mark, behind a new header
+    size_t rest = (size_t)end - mark->position;
+    JournalHeader header = { JOURNAL_MAGIC, JOURNAL_VERSION, 0 };
+    char* data = (char*)malloc(sizeof(header) + rest);
+    if (!data) {
+        return memory_problem;
+    }
+    memcpy(data, &header, sizeof(header));
+    size_t done = 0;
+    while (done < rest) {
+        ssize_t got = pread(journal->fd, data + sizeof(header) + done, rest - done, (off_t)(mark->position + done));
+        if (got <= 0) {
+            free(data);
+            return failure;
+        }
+        done += (size_t)got;
+    }
+
+    size_t length = strlen(journal->filename);
+    char* temporary = (char*)malloc(length + sizeof(".tmp"));
+    if (!temporary) {
+        free(data);
+        return memory_problem;
+    }
+    memcpy(temporary, journal->filename, length);
+    memcpy(temporary + length, ".tmp", sizeof(".tmp"));
+
+    int fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    bool written = fd >= 0 && writeAll(fd, data, sizeof(header) + rest) && fsync(fd) == 0;
+    free(data);
+    if (!written || rename(temporary, journal->filename) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        unlink(temporary);
+        free(temporary);
+        return failure;
+    }
+    free(temporary);
+    // new records go to the new file
+    close(journal->fd);
+    journal->fd = fd;
+    journal->records -= mark->records;
+    journal->unsynced = 0;
+    return success;
+}
+
+
+status journalIntake(Journal journal, char* id, char* planetName, char* dimension, int happiness) {
+    if (!journal || !id || !planetName || !dimension) {
+        return null_pointer;
+    }
+    int32_t stored = (int32_t)happiness;
+    status state = beginRecord(journal, RECORD_INTAKE);
+    if (state == success) state = appendString(journal, id);
+    if (state == success) state = appendString(journal, planetName);
+    if (state == success) state = appendString(journal, dimension);
+    if (state == success) state = appendToRecord(journal, &stored, sizeof(stored));
+    return state == success ? finishRecord(journal) : state;
+}
+
+
+status journalCheckout(Journal journal, char* id) {
+    if (!journal || !id) {
+        return null_pointer;
+    }
+    status state = beginRecord(journal, RECORD_CHECKOUT);
+    if (state == success) state = appendString(journal, id);
+    return state == success ? finishRecord(journal) : state;
+}
+
+
+status journalAddCharacteristic(Journal journal, char* id, char* name, double value) {
+    if (!journal || !id || !name) {
+        return null_pointer;
+    }
+    status state = beginRecord(journal, RECORD_ADD_CHARACTERISTIC);
+    if (state == success) state = appendString(journal, id);
+    if (state == success) state = appendString(journal, name);
+    if (state == success) state = appendToRecord(journal, &value, sizeof(value));
+    return state == success ? finishRecord(journal) : state;
+}
+
+
+status journalRemoveCharacteristic(Journal journal, char* id, char* name) {
+    if (!journal || !id || !name) {
+        return null_pointer;
+    }
+    status state = beginRecord(journal, RECORD_REMOVE_CHARACTERISTIC);
+    if (state == success) state = appendString(journal, id);
+    if (state == success) state = appendString(journal, name);
+    return state == success ? finishRecord(journal) : state;
+}
+
+
+status journalGroupCheckout(Journal journal, bool byPlanet, char* key) {
+    if (!journal || !key) {
+        return null_pointer;
+    }
+    uint8_t flag = byPlanet ? 1 : 0;
+    status state = beginRecord(journal, RECORD_GROUP_CHECKOUT);
+    if (state == success) state = appendToRecord(journal, &flag, sizeof(flag));
+    if (state == success) state = appendString(journal, key);
+    return state == success ? finishRecord(journal) : state;
+}
+
+
+status journalPlay(Journal journal, int activity) {
+    if (!journal) {
+        return null_pointer;
+    }
+    int32_t stored = (int32_t)activity;
+    status state = beginRecord(journal, RECORD_PLAY);
+    if (state == success) state = appendToRecord(journal, &stored, sizeof(stored));
+    return state == success ? finishRecord(journal) : state;
+}
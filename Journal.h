@@ -0,0 +1,136 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the Journal module!
+ * This module keeps an append only binary log of the changes made to a daycare after it was loaded,
+ * so they can be replayed over the same configuration or snapshot when the program starts again.
+ * Every change is one record: its length, its type, its fields and a checksum. A record is written
+ * to the file as soon as it is added, so a change is never lost if the process dies, and the file is
+ * flushed to the disk once every few records (group commit), so the changes survive a crash of the
+ * machine without paying for a flush per change.
+ * A record that was only partly written when the machine crashed fails its checksum, the replay stops
+ * there and the journal continues from the last complete record.
+ * Once the state is saved elsewhere (a checkpoint), the records it already holds can be dropped from the
+ * front of the journal, the records added since stay.
+ * To replay a journal, users must provide callback functions for:
+ * - A Jerry taken in
+ * - A Jerry taken back
+ * - A physical characteristic added to or removed from a Jerry
+ * - All the Jerries of a planet or a dimension taken back
+ * - An activity played by all the Jerries
+ */
+
+
+/**
+ * A journal open for appending
+ */
+typedef struct Journal_s* Journal;
+
+
+/**
+ * A point in a journal, the records before it can be dropped later
+ */
+typedef struct JournalMark_t {
+    size_t position; // byte offset of the first record after the mark
+    int records;     // number of records before the mark
+} JournalMark;
+
+
+/**
+ * Callbacks and context for replaying a journal.
+ * The strings passed to the callbacks are only valid during the call, they must be copied to be kept.
+ * A callback that does not return success stops the replay, and its status is returned by openJournal.
+ */
+typedef struct JournalHandlers_t {
+    void* context; // passed back as the first argument of every callback
+    status (*onIntake)(void* context, char* id, char* planetName, char* dimension, int happiness);
+    status (*onCheckout)(void* context, char* id);
+    status (*onAddCharacteristic)(void* context, char* id, char* name, double value);
+    status (*onRemoveCharacteristic)(void* context, char* id, char* name);
+    status (*onGroupCheckout)(void* context, bool byPlanet, char* key);
+    status (*onPlay)(void* context, int activity);
+} JournalHandlers;
+
+
+
+/**
+ * Opens a journal, replays the records it already holds and prepares it for appending
+ * A missing journal is created empty
+ * @param filename Path of the journal
+ * @param syncEvery Number of records written between two flushes to the disk (1 flushes every record)
+ * @param handlers The callbacks to replay the records with (all must be non-NULL)
+ * @param journal Set to the open journal
+ * @param replayed Set to the number of records replayed (may be NULL)
+ * @return Operation status indicating success, failure if the file can't be opened or is not a journal,
+ * memory problem, null pointer if received NULL in parameters, or the first non success status of a callback
+ */
+status openJournal(const char* filename, int syncEvery, JournalHandlers* handlers, Journal* journal, int* replayed);
+
+
+
+/**
+ * Flushes the journal to the disk and closes it
+ * @param journal The journal to close (may be NULL)
+ * @return Operation status indicating success, failure if the journal could not be flushed
+ */
+status closeJournal(Journal journal);
+
+
+
+/**
+ * Flushes the records written since the last flush to the disk
+ * @param journal The journal
+ * @return Operation status indicating success, failure if the flush failed, null pointer if journal is NULL
+ */
+status syncJournal(Journal journal);
+
+
+
+/**
+ * @param journal The journal
+ * @return The number of records in the journal, replayed ones included, 0 if journal is NULL
+ */
+int getJournalRecords(Journal journal);
+
+
+
+/**
+ * Marks the end of the journal, the records written so far are before the mark
+ * @param journal The journal
+ * @param mark Filled with the mark
+ * @return Operation status indicating success, failure if the journal can't be read, null pointer if received NULL
+ */
+status markJournal(Journal journal, JournalMark* mark);
+
+
+
+/**
+ * Drops the records before a mark, the records written after it stay in the journal
+ * The rest of the journal is written to a temporary file that is flushed and renamed over the journal,
+ * so a crash leaves either the old journal or the new one
+ * @param journal The journal
+ * @param mark A mark of this journal, taken since it was last truncated
+ * @return Operation status indicating success, failure if the journal can't be rewritten (it is left as it was),
+ * memory problem, null pointer if received NULL in parameters
+ */
+status truncateJournal(Journal journal, JournalMark* mark);
+
+
+
+/**
+ * Records a change, the record is written right away and flushed with its group
+ * Every function returns success, failure if the record could not be written,
+ * memory problem, or null pointer if received NULL in parameters
+ */
+status journalIntake(Journal journal, char* id, char* planetName, char* dimension, int happiness);
+status journalCheckout(Journal journal, char* id);
+status journalAddCharacteristic(Journal journal, char* id, char* name, double value);
+status journalRemoveCharacteristic(Journal journal, char* id, char* name);
+status journalGroupCheckout(Journal journal, bool byPlanet, char* key);
+status journalPlay(Journal journal, int activity);
+
+
+#endif //JOURNAL_H
@@ -0,0 +1,364 @@
+#include "KdTree.h"
+
+#define KD_DIMENSIONS 3
+
+
+/* Internal node structure */
+typedef struct KdNode_s {
+    double point[KD_DIMENSIONS];
+    Element data;
+    int axis; // the coordinate this node splits on
+    struct KdNode_s* left;  // points with a smaller coordinate on the axis
+    struct KdNode_s* right; // points with a greater or equal coordinate on the axis
+} KdNode;
+
+
+/* Main tree structure */
+struct KdTree_s {
+    KdNode* root;
+    int size;
+
+    CopyFunction copyFunc;
+    FreeFunction freeFunc;
+};
+
+
+/* Bounded max heap used by the nearest neighbours search, the farthest candidate is on top */
+typedef struct Candidates_s {
+    KdNode** nodes;
+    double* distances; // squared distances
+    int count;
+    int capacity;
+} Candidates;
+
+
+
+// Node helper functions:
+
+static KdNode* createKdNode(double x, double y, double z, Element data) {
+    KdNode* node = (KdNode*)malloc(sizeof(KdNode));
+    if (!node) {
+        return NULL;
+    }
+    node->point[0] = x;
+    node->point[1] = y;
+    node->point[2] = z;
+    node->data = data;
+    node->axis = 0;
+    node->left = node->right = NULL;
+    return node;
+}
+
+static void destroyKdNodes(KdNode* node, FreeFunction freeFunc) {
+    if (!node) {
+        return;
+    }
+    destroyKdNodes(node->left, freeFunc);
+    destroyKdNodes(node->right, freeFunc);
+    freeFunc(node->data);
+    free(node);
+}
+
+static double squaredDistance(KdNode* node, double point[KD_DIMENSIONS]) {
+    double sum = 0;
+    for (int i = 0; i < KD_DIMENSIONS; i++) {
+        double diff = node->point[i] - point[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+
+// comparators for the median split, one for each axis
+static int compareByX(const void* a, const void* b) {
+    double diff = (*(KdNode**)a)->point[0] - (*(KdNode**)b)->point[0];
+    return (diff > 0) - (diff < 0);
+}
+
+static int compareByY(const void* a, const void* b) {
+    double diff = (*(KdNode**)a)->point[1] - (*(KdNode**)b)->point[1];
+    return (diff > 0) - (diff < 0);
+}
+
+static int compareByZ(const void* a, const void* b) {
+    double diff = (*(KdNode**)a)->point[2] - (*(KdNode**)b)->point[2];
+    return (diff > 0) - (diff < 0);
+}
+
+
+// collects the nodes of a subtree into an array, detaching them from each other
+static void collectKdNodes(KdNode* node, KdNode** nodes, int* count) {
+    if (!node) {
+        return;
+    }
+    collectKdNodes(node->left, nodes, count);
+    collectKdNodes(node->right, nodes, count);
+    node->left = node->right = NULL;
+    nodes[(*count)++] = node;
+}
+
+
+// builds a balanced subtree from nodes[start, end)
+static KdNode* buildBalanced(KdNode** nodes, int start, int end, int depth) {
+    if (start >= end) {
+        return NULL;
+    }
+    static int (*const comparators[KD_DIMENSIONS])(const void*, const void*) = { compareByX, compareByY, compareByZ };
+    int axis = depth % KD_DIMENSIONS;
+    qsort(nodes + start, end - start, sizeof(KdNode*), comparators[axis]);
+
+    int median = start + (end - start) / 2;
+    // equal coordinates must go to the right subtree, so move the median to the first of its equals
+    while (median > start && nodes[median - 1]->point[axis] == nodes[median]->point[axis]) {
+        median--;
+    }
+
+    KdNode* node = nodes[median];
+    node->axis = axis;
+    node->left = buildBalanced(nodes, start, median, depth + 1);
+    node->right = buildBalanced(nodes, median + 1, end, depth + 1);
+    return node;
+}
+
+
+
+// Candidates helper functions:
+
+static void swapCandidates(Candidates* heap, int i, int j) {
+    KdNode* node = heap->nodes[i];
+    double distance = heap->distances[i];
+    heap->nodes[i] = heap->nodes[j];
+    heap->distances[i] = heap->distances[j];
+    heap->nodes[j] = node;
+    heap->distances[j] = distance;
+}
+
+static void siftDown(Candidates* heap, int index) {
+    while (true) {
+        int largest = index;
+        int left = 2 * index + 1;
+        int right = 2 * index + 2;
+        if (left < heap->count && heap->distances[left] > heap->distances[largest]) largest = left;
+        if (right < heap->count && heap->distances[right] > heap->distances[largest]) largest = right;
+        if (largest == index) {
+            return;
+        }
+        swapCandidates(heap, index, largest);
+        index = largest;
+    }
+}
+
+static void offerCandidate(Candidates* heap, KdNode* node, double distance) {
+    if (heap->count < heap->capacity) { // still room, sift the new candidate up
+        int index = heap->count++;
+        heap->nodes[index] = node;
+        heap->distances[index] = distance;
+        while (index > 0 && heap->distances[(index - 1) / 2] < heap->distances[index]) {
+            swapCandidates(heap, index, (index - 1) / 2);
+            index = (index - 1) / 2;
+        }
+    }
+    else if (distance < heap->distances[0]) { // closer than the farthest candidate, replace it
+        heap->nodes[0] = node;
+        heap->distances[0] = distance;
+        siftDown(heap, 0);
+    }
+}
+
+
+
+// Search helper functions:
+
+static status searchRadius(KdNode* node, double point[KD_DIMENSIONS], double squaredRadius, LinkedList result) {
+    if (!node) {
+        return success;
+    }
+    if (squaredDistance(node, point) <= squaredRadius) {
+        status state = appendNode(result, node->data);
+        if (state != success) {
+            return state;
+        }
+    }
+
+    double diff = point[node->axis] - node->point[node->axis];
+    KdNode* near = diff < 0 ? node->left : node->right;
+    KdNode* far = diff < 0 ? node->right : node->left;
+
+    status state = searchRadius(near, point, squaredRadius, result);
+    if (state != success) {
+        return state;
+    }
+    // the far side can only hold matches if the splitting plane is within the radius
+    if (diff * diff <= squaredRadius) {
+        return searchRadius(far, point, squaredRadius, result);
+    }
+    return success;
+}
+
+static void searchNearest(KdNode* node, double point[KD_DIMENSIONS], Candidates* heap) {
+    if (!node) {
+        return;
+    }
+    offerCandidate(heap, node, squaredDistance(node, point));
+
+    double diff = point[node->axis] - node->point[node->axis];
+    KdNode* near = diff < 0 ? node->left : node->right;
+    KdNode* far = diff < 0 ? node->right : node->left;
+
+    searchNearest(near, point, heap);
+    // the far side can only hold a closer element if the splitting plane is closer than the farthest candidate
+    if (heap->count < heap->capacity || diff * diff < heap->distances[0]) {
+        searchNearest(far, point, heap);
+    }
+}
+
+
+
+// Interface Functions:
+
+KdTree createKdTree(CopyFunction copyFunction, FreeFunction freeFunction) {
+    if (!copyFunction || !freeFunction) {
+        return NULL;
+    }
+    KdTree tree = (KdTree)malloc(sizeof(struct KdTree_s));
+    if (!tree) {
+        return NULL;
+    }
+    tree->root = NULL;
+    tree->size = 0;
+    tree->copyFunc = copyFunction;
+    tree->freeFunc = freeFunction;
+    return tree;
+}
+
+
+status destroyKdTree(KdTree tree) {
+    if (!tree) {
+        return null_pointer;
+    }
+    destroyKdNodes(tree->root, tree->freeFunc);
+    free(tree);
+    return success;
+}
+
+
+status insertToKdTree(KdTree tree, double x, double y, double z, Element element) {
+    if (!tree || !element) {
+        return null_pointer;
+    }
+    Element data = tree->copyFunc(element);
+    if (!data) {
+        return memory_problem;
+    }
+    KdNode* newNode = createKdNode(x, y, z, data);
+    if (!newNode) {
+        tree->freeFunc(data);
+        return memory_problem;
+    }
+
+    if (!tree->root) { // tree is empty
+        tree->root = newNode;
+        tree->size++;
+        return success;
+    }
+
+    // walk down to the leaf the point belongs under
+    KdNode* current = tree->root;
+    while (true) {
+        KdNode** next = newNode->point[current->axis] < current->point[current->axis] ? &current->left : &current->right;
+        if (!*next) {
+            newNode->axis = (current->axis + 1) % KD_DIMENSIONS;
+            *next = newNode;
+            break;
+        }
+        current = *next;
+    }
+    tree->size++;
+    return success;
+}
+
+
+status balanceKdTree(KdTree tree) {
+    if (!tree) {
+        return null_pointer;
+    }
+    if (tree->size < 2) {
+        return success;
+    }
+    KdNode** nodes = (KdNode**)malloc(tree->size * sizeof(KdNode*));
+    if (!nodes) {
+        return memory_problem;
+    }
+    int count = 0;
+    collectKdNodes(tree->root, nodes, &count);
+    tree->root = buildBalanced(nodes, 0, count, 0);
+    free(nodes);
+    return success;
+}
+
+
+status searchKdTreeInRadius(KdTree tree, double x, double y, double z, double radius, LinkedList result) {
+    if (!tree || !result) {
+        return null_pointer;
+    }
+    if (radius < 0) {
+        return failure;
+    }
+    double point[KD_DIMENSIONS] = { x, y, z };
+    return searchRadius(tree->root, point, radius * radius, result);
+}
+
+
+status searchKdTreeNearest(KdTree tree, double x, double y, double z, int k, LinkedList result) {
+    if (!tree || !result) {
+        return null_pointer;
+    }
+    if (k <= 0) {
+        return failure;
+    }
+    if (k > tree->size) {
+        k = tree->size;
+    }
+    if (k == 0) { // empty tree
+        return success;
+    }
+
+    Candidates heap;
+    heap.nodes = (KdNode**)malloc(k * sizeof(KdNode*));
+    heap.distances = (double*)malloc(k * sizeof(double));
+    if (!heap.nodes || !heap.distances) {
+        free(heap.nodes);
+        free(heap.distances);
+        return memory_problem;
+    }
+    heap.count = 0;
+    heap.capacity = k;
+
+    double point[KD_DIMENSIONS] = { x, y, z };
+    searchNearest(tree->root, point, &heap);
+
+    // pop the farthest candidate into the back of the array until it is sorted from nearest to farthest
+    int found = heap.count;
+    while (heap.count > 1) {
+        swapCandidates(&heap, 0, heap.count - 1);
+        heap.count--;
+        siftDown(&heap, 0);
+    }
+
+    status state = success;
+    for (int i = 0; i < found && state == success; i++) {
+        state = appendNode(result, heap.nodes[i]->data);
+    }
+
+    free(heap.nodes);
+    free(heap.distances);
+    return state;
+}
+
+
+int getKdTreeSize(KdTree tree) {
+    if (!tree) {
+        return 0;
+    }
+    return tree->size;
+}
@@ -0,0 +1,106 @@
+#ifndef KDTREE_H
+#define KDTREE_H
+#include "LinkedList.h"
+
+
+/**
+ * Welcome to the K-D Tree module!
+ * This module provides a generic 3 dimensional k-d tree Abstract Data Type (ADT) that indexes
+ * elements of any type by a point in space, and answers proximity queries (all elements within
+ * a radius of a point, and the k elements nearest to a point) without scanning every element.
+ * To use this ADT, users must provide callback functions for:
+ * - Copying elements
+ * - Freeing elements
+ * Query results are appended to a LinkedList supplied by the caller, so the list's own
+ * callbacks decide how the results are stored.
+ */
+
+
+typedef struct KdTree_s* KdTree;
+
+
+// Function declarations
+
+
+/**
+ * Creates a new empty k-d tree
+ * @param copyFunction Function to copy elements on insertion (must be non-NULL)
+ * @param freeFunction Function to free elements when the tree is destroyed (must be non-NULL)
+ * @return Handle to the new tree, or NULL if creation failed
+ */
+KdTree createKdTree(CopyFunction copyFunction, FreeFunction freeFunction);
+
+
+
+/**
+ * Destroys a k-d tree and frees all associated resources
+ * @param tree The tree to destroy
+ * @return Operation status indicating success or null pointer if received NULL in parameters
+ */
+status destroyKdTree(KdTree tree);
+
+
+
+/**
+ * Inserts an element at the given point.
+ * Insertion keeps the tree valid but not balanced, see balanceKdTree for bulk loads.
+ * @param tree The tree to insert into
+ * @param x X coordinate of the element
+ * @param y Y coordinate of the element
+ * @param z Z coordinate of the element
+ * @param element The element to insert
+ * @return Operation status indicating success, null pointer if received NULL in parameters or memory problem
+ */
+status insertToKdTree(KdTree tree, double x, double y, double z, Element element);
+
+
+
+/**
+ * Rebuilds the tree so every split is on the median point, giving O(log n) depth.
+ * Intended to be called once after a bulk load.
+ * @param tree The tree to balance
+ * @return Operation status indicating success, null pointer if received NULL in parameters or memory problem
+ */
+status balanceKdTree(KdTree tree);
+
+
+
+/**
+ * Appends every element within a distance of a point to a list, in no particular order
+ * @param tree The tree to search
+ * @param x X coordinate of the point
+ * @param y Y coordinate of the point
+ * @param z Z coordinate of the point
+ * @param radius The maximal (inclusive) distance from the point (must be non negative)
+ * @param result The list the found elements are appended to
+ * @return Operation status indicating success, failure if radius is negative, null pointer if received NULL
+ * in parameters or memory problem
+ */
+status searchKdTreeInRadius(KdTree tree, double x, double y, double z, double radius, LinkedList result);
+
+
+
+/**
+ * Appends the k elements nearest to a point to a list, from the nearest to the farthest
+ * @param tree The tree to search
+ * @param x X coordinate of the point
+ * @param y Y coordinate of the point
+ * @param z Z coordinate of the point
+ * @param k The maximal number of elements to return (must be positive)
+ * @param result The list the found elements are appended to
+ * @return Operation status indicating success, failure if k is not positive, null pointer if received NULL
+ * in parameters or memory problem
+ */
+status searchKdTreeNearest(KdTree tree, double x, double y, double z, int k, LinkedList result);
+
+
+
+/**
+ * Returns the current number of elements in the tree
+ * @param tree The tree to check
+ * @return Number of elements, 0 if tree is NULL
+ */
+int getKdTreeSize(KdTree tree);
+
+
+#endif //KDTREE_H
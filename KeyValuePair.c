@@ -121,6 +121,13 @@ Element getKey(KeyValuePair pair) {
     return NULL;
 }
 
+Element getKeyReference(KeyValuePair pair) {
+    if (!pair) {
+        return NULL;
+    }
+    return pair->key;
+}
+
 bool isEqualKey(KeyValuePair pair, Element key) {
     if (!pair || !key) {
         return false;
@@ -104,6 +104,15 @@ Element getKey(KeyValuePair pair);
 
 
 
+/**
+ * Retrieves the key from the key-value pair without copying it
+ * @param pair The key-value pair
+ * @return The key element itself, still owned by the pair, or NULL if pair is NULL
+ */
+Element getKeyReference(KeyValuePair pair);
+
+
+
 /**
  * Checks if a given key is equal to the key in the key-value pair
  * @param pair The key-value pair
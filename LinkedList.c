@@ -3,6 +3,7 @@
 //
 
 #include "LinkedList.h"
+#include <stdatomic.h>
 
 
 
@@ -24,9 +25,10 @@ struct LinkedList_s {
     Node* tail;
     int size;
 
-    // cache for last access, will help iterate more efficiently
-    Node* lastNode;    // last accessed node
-    int lastIndex;     // lact accessed node's index
+    // changed by every removal, so a cursor from before it starts over, and never the version of another list
+    unsigned long version;
+    unsigned long previousVersion; // the version before the last removal, 0 if its cursors may all be on a freed node
+    int removedIndex;              // position of the node the last removal freed
 
     CopyFunction copyFunc;
     FreeFunction freeFunc;
@@ -35,6 +37,75 @@ struct LinkedList_s {
 };
 
 
+
+/* the positions of the readers: every reader keeps its own, so readers sharing a list never write to it */
+
+static atomic_ulong listVersions; // the versions of every list come from here, so a new list never reuses one
+
+// the last position of the calling thread, for the accesses by position that don't bring a cursor of their own
+// and as a place to start from for a new cursor, so the next page of a list continues where the thread left it
+static _Thread_local ListCursor threadCursor;
+
+// the next version of a list, called when it is created and by every removal
+// removedIndex is the position of the one node a removal freed, or 0 when the nodes of any cursor may be gone
+static void changeVersion(LinkedList list, int removedIndex) {
+    list->previousVersion = removedIndex > 0 ? list->version : 0;
+    list->removedIndex = removedIndex;
+    list->version = atomic_fetch_add_explicit(&listVersions, 1, memory_order_relaxed) + 1;
+}
+
+// brings a cursor up to the version of the list, false if it is not on a node of this list that is still there
+// a cursor from just before the last removal keeps its node unless it was the removed one, a node after it moved up
+static bool updateCursor(ListCursor* cursor, LinkedList list) {
+    if (cursor->list != list || !cursor->node) {
+        return false;
+    }
+    if (cursor->version == list->version) {
+        return true;
+    }
+    if (cursor->version != list->previousVersion || cursor->index == list->removedIndex) {
+        return false;
+    }
+    if (cursor->index > list->removedIndex) {
+        cursor->index--;
+    }
+    cursor->version = list->version;
+    return true;
+}
+
+// whether a cursor is on a node of this version of the list that is not after a position
+static bool isBefore(ListCursor* cursor, LinkedList list, int index) {
+    return updateCursor(cursor, list) && cursor->index <= index;
+}
+
+// puts a cursor and the calling thread's last position on a node
+static void placeCursor(ListCursor* cursor, LinkedList list, Node* node, int index) {
+    cursor->list = list;
+    cursor->version = list->version;
+    cursor->node = node;
+    cursor->index = index;
+    threadCursor = *cursor;
+}
+
+// finds the node at a position, starting from the nearest of the cursor and the thread's last position before it
+// the cursor is left on the node, so the next access after it walks only the nodes in between
+static Node* seekNode(LinkedList list, ListCursor* cursor, int index) {
+    ListCursor* from = isBefore(cursor, list, index) ? cursor : NULL;
+    if (isBefore(&threadCursor, list, index) && (!from || threadCursor.index > from->index)) {
+        from = &threadCursor;
+    }
+    Node* current = from ? (Node*)from->node : list->head;
+    int position = from ? from->index : 1;
+    while (position < index) {
+        current = current->next;
+        position++;
+    }
+    placeCursor(cursor, list, current, index);
+    return current;
+}
+
+
+
 // Node helper functions:
 
 /* Helper function to create a new node */
@@ -79,9 +150,8 @@ LinkedList createLinkedList(CopyFunction copyFunction, FreeFunction freeFunction
     list->size = 0;
     list->head = list->tail = NULL;
 
-    // initialize position
-    list->lastNode = NULL;
-    list->lastIndex = 0;
+    // no cursor was taken in this version yet
+    changeVersion(list, 0);
 
     return list;
 }
@@ -106,6 +176,21 @@ status destroyList(LinkedList list) {
 }
 
 
+status destroyListShallow(LinkedList list) {
+    if (!list) return null_pointer;
+
+    Node* current = list->head;
+    while (current) {
+        Node* next = current->next;
+        free(current);
+        current = next;
+    }
+
+    free(list);
+    return success;
+}
+
+
 status appendNode(LinkedList list, Element element) {
 
     if (!list || !element) {
@@ -129,9 +214,7 @@ status appendNode(LinkedList list, Element element) {
     list->tail->next = NULL;
     list->size++;
 
-    // reset position since list structure changed
-    list->lastNode = NULL;
-    list->lastIndex = 0;
+    // the cursors stay, the nodes before the new one keep their positions
 
     return success;
 }
@@ -147,11 +230,13 @@ status deleteNode(LinkedList list, Element element) {
 
     Node* current = list->head;
     Node* prev = NULL;
+    int position = 1;
 
     // find the node to delete
     while (current && !list->equalFunc(current->data, element)) {
         prev = current;
         current = current->next;
+        position++;
     }
 
     if (!current) {  // element not found
@@ -181,14 +266,55 @@ status deleteNode(LinkedList list, Element element) {
     free(current);
     list->size--;
 
-    // reset position since list structure changed
-    list->lastNode = NULL;
-    list->lastIndex = 0;
+    // the cursors of the readers on the freed node start over, the ones after it move up by one
+    changeVersion(list, position);
 
 
     return success;
 }
 
+status deleteMatchingNodes(LinkedList list, EqualFunction matchFunction, Element key) {
+    if (!list || !matchFunction || !key) {
+        return null_pointer;
+    }
+
+    Node* current = list->head;
+    Node* prev = NULL;
+    int removed = 0;
+
+    while (current) {
+        Node* next = current->next;
+        if (!matchFunction(current->data, key)) { // keep this node
+            prev = current;
+            current = next;
+            continue;
+        }
+
+        // unlink the node, prev stays the last kept node
+        if (prev) {
+            prev->next = next;
+        } else {
+            list->head = next;
+        }
+        if (current == list->tail) {
+            list->tail = prev;
+        }
+
+        list->freeFunc(current->data);
+        free(current);
+        list->size--;
+        removed++;
+        current = next;
+    }
+
+    // the cursors of the readers may be on a freed node or after one
+    if (removed > 0) {
+        changeVersion(list, 0);
+    }
+
+    return removed > 0 ? success : failure;
+}
+
 status displayList(LinkedList list) {
     if (!list) {
         return null_pointer;
@@ -209,33 +335,50 @@ status displayList(LinkedList list) {
 
 
 
-Element getDataByIndex(LinkedList list, int index) {
-    if (!list || index < 1 || index > list->size) {
-        return NULL;
+status displayListRange(LinkedList list, ListCursor* cursor, int first, int count) {
+    if (!list) {
+        return null_pointer;
+    }
+    if (first < 1 || first > list->size || count < 0) {
+        return failure;
+    }
+    if (!cursor) {
+        cursor = &threadCursor;
     }
 
-    Node* current;
+    // start from the cursor when the run is after it, like getDataByIndex
+    Node* current = seekNode(list, cursor, first);
+    int index = first;
 
-    // if we have a position and requested index is after it, we can start from the current position instead
-    if (list->lastNode && list->lastIndex <= index) {
-        current = list->lastNode;
-        int i = list->lastIndex;
-        while (i < index) {
-            current = current->next;
-            i++;
+    // print the run, the cursor is left on its last element so the next run continues from there
+    Node* last = current;
+    for (int printed = 0; printed < count && current; printed++) {
+        status result = list->printFunc(current->data);
+        if (result != success) {
+            return result;
         }
+        last = current;
+        current = current->next;
+        index++;
     }
+    placeCursor(cursor, list, last, index - 1);
 
-    else {
-        current = list->head;
-        for (int i = 1; i < index; i++) {
-            current = current->next;
-        }
+    return success;
+}
+
+
+Element getDataByIndex(LinkedList list, int index) {
+    return getDataByCursor(list, &threadCursor, index);
+}
+
+
+Element getDataByCursor(LinkedList list, ListCursor* cursor, int index) {
+    if (!list || !cursor || index < 1 || index > list->size) {
+        return NULL;
     }
 
-    // update cache for next time
-    list->lastNode = current;
-    list->lastIndex = index;
+    // if the cursor is on an earlier position, we can start from there instead of the head
+    Node* current = seekNode(list, cursor, index);
 
     return list->copyFunc(current->data);
 }
@@ -17,6 +17,8 @@
 * - Freeing elements
 * - Printing elements
 * - Comparing elements for equality
+* Many threads may read a list at once (display, search, access by position) as long as none changes it meanwhile.
+* Every reader keeps its position in a cursor of its own, so the readers of a list never write to it.
 */
 
 
@@ -25,6 +27,21 @@
 typedef struct LinkedList_s* LinkedList;
 
 
+/**
+ * A reader's position in a list, the next access after it starts from there instead of the head
+ * A new cursor starts from the last position the calling thread reached in the list, when it is before the access
+ * Zero it before its first use, its fields are only used by the list functions
+ * A removal from the list sends the cursors on the removed element back to the head and moves the ones after it up
+ * by one, a removal of many elements sends every cursor back
+ */
+typedef struct ListCursor_t {
+    LinkedList list;
+    void* node;
+    int index;
+    unsigned long version;
+} ListCursor;
+
+
 
 
 // Functions:
@@ -56,6 +73,18 @@ status destroyList(LinkedList list);
 
 
 
+/**
+ * Destroys a list without freeing its elements, for when the elements were handed over to another structure
+ * @param list The list to destroy
+ * @return Operation status indicating success or null pointer if received NULL in parameters
+ */
+status destroyListShallow(LinkedList list);
+
+
+
+
+
+
 /**
  * Adds an element to the end of the list
  * @param list The list to add to
@@ -82,6 +111,21 @@ status deleteNode(LinkedList list, Element element);
 
 
 
+/**
+ * Removes every element matching a key from the list, in a single pass
+ * @param list The list to remove from
+ * @param matchFunction Function deciding whether an element (first argument) matches the key (second argument)
+ * @param key The key passed to the match function
+ * @return Operation status indicating success if at least one element was removed, failure if none matched,
+ * or null pointer if received NULL in parameters
+ */
+status deleteMatchingNodes(LinkedList list, EqualFunction matchFunction, Element key);
+
+
+
+
+
+
 /**
  * Prints all elements in the list using the provided print function
  * @param list The list to display
@@ -93,8 +137,26 @@ status displayList(LinkedList list);
 
 
 
+/**
+ * Prints a run of consecutive elements using the provided print function
+ * Starts from the position of the cursor when it is not after the run, and leaves the cursor on the last element
+ * printed, so printing a list one page after the other walks it only once
+ * @param list The list to display
+ * @param cursor The reader's position, NULL for the one of the calling thread
+ * @param first Position of the first element to print (1-based indexing)
+ * @param count Number of elements to print, fewer are printed if the list ends first
+ * @return Operation status indicating success, failure if first is not a position in the list or printing failed,
+ * or null pointer if received NULL in parameters
+ */
+status displayListRange(LinkedList list, ListCursor* cursor, int first, int count);
+
+
+
+
+
 /**
  * Retrieves an element at a specific position
+ * Starts from the position of the last access of the calling thread when it is not after the element
  * @param list The list to access
  * @param index The position (1-based indexing - starting to count from 1)
  * @return The element at the specified position, or NULL if invalid index
@@ -103,6 +165,17 @@ Element getDataByIndex(LinkedList list, int index);
 
 
 
+/**
+ * Retrieves an element at a specific position, starting from a reader's cursor and leaving it on the element
+ * @param list The list to access
+ * @param cursor The reader's position
+ * @param index The position (1-based indexing - starting to count from 1)
+ * @return The element at the specified position, or NULL if invalid index or received NULL in parameters
+ */
+Element getDataByCursor(LinkedList list, ListCursor* cursor, int index);
+
+
+
 
 
 
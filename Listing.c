@@ -0,0 +1,146 @@
+#include "Listing.h"
+#include "Jerry.h"
+#include "Epoch.h"
+#include <stdatomic.h>
+
+
+/* A Jerry of a listing, as it was when the listing was built */
+typedef struct ListedJerry_t {
+    RenderedText* text; // one reference is held by the listing
+    int happiness;
+} ListedJerry;
+
+
+struct JerryListing_t {
+    int count;
+    ListedJerry jerries[];
+};
+
+
+struct ListingVersions_s {
+    _Atomic(JerryListing*) current; // built by the first reader after a change, NULL until then
+    EpochDomain epochs; // pinned by the readers of a version, an old version is freed once its readers are done
+};
+
+
+// frees a version and drops its references to the texts of the Jerries, called once no reader has it
+static void destroyJerryListing(void* memory) {
+    JerryListing* listing = (JerryListing*)memory;
+    if (!listing) {
+        return;
+    }
+    for (int i = 0; i < listing->count; i++) {
+        releaseRenderedText(listing->jerries[i].text);
+    }
+    free(listing);
+}
+
+
+// takes the text and happiness of every Jerry, NULL if memory ran out
+static JerryListing* buildJerryListing(LinkedList jerries) {
+    int count = getLengthList(jerries);
+    JerryListing* listing = (JerryListing*)malloc(sizeof(JerryListing) + count * sizeof(ListedJerry));
+    if (!listing) {
+        return NULL;
+    }
+    listing->count = 0;
+    for (int i = 1; i <= count; i++) {
+        Jerry* jerry = getDataByIndex(jerries, i);
+        RenderedText* text = retainRenderedJerry(jerry);
+        if (!text) {
+            destroyJerryListing(listing);
+            return NULL;
+        }
+        listing->jerries[listing->count].text = text;
+        listing->jerries[listing->count].happiness = jerry->happiness;
+        listing->count++;
+    }
+    return listing;
+}
+
+
+ListingVersions createListingVersions() {
+    ListingVersions versions = (ListingVersions)malloc(sizeof(struct ListingVersions_s));
+    if (!versions) {
+        return NULL;
+    }
+    atomic_init(&versions->current, NULL);
+    versions->epochs = createEpochDomain();
+    if (!versions->epochs) {
+        free(versions);
+        return NULL;
+    }
+    return versions;
+}
+
+
+void destroyListingVersions(ListingVersions versions) {
+    if (!versions) {
+        return;
+    }
+    destroyJerryListing(atomic_load(&versions->current));
+    destroyEpochDomain(versions->epochs);
+    free(versions);
+}
+
+
+JerryListing* pinListing(ListingVersions versions, long* epoch) {
+    *epoch = pinEpoch(versions->epochs);
+    JerryListing* listing = atomic_load(&versions->current);
+    if (!listing) {
+        // nothing stays pinned while the caller waits for the lock, so a writer that retires a version never waits for it
+        unpinEpoch(versions->epochs, *epoch);
+    }
+    return listing;
+}
+
+
+JerryListing* publishListing(ListingVersions versions, LinkedList jerries, long* epoch) {
+    JerryListing* listing = NULL;
+    JerryListing* built = buildJerryListing(jerries);
+    // published under the caller's lock, so a writer can't drop the version before it is out
+    if (built && !atomic_compare_exchange_strong(&versions->current, &listing, built)) {
+        destroyJerryListing(built); // another reader published first, its version is the same
+    }
+    else {
+        listing = built;
+    }
+    // the lock keeps the version current until it is pinned
+    if (listing) {
+        *epoch = pinEpoch(versions->epochs);
+    }
+    return listing;
+}
+
+
+void unpinListing(ListingVersions versions, long epoch) {
+    unpinEpoch(versions->epochs, epoch);
+}
+
+
+void dropListing(ListingVersions versions) {
+    if (!atomic_load(&versions->current)) {
+        return; // no reader listed the Jerries since the last change
+    }
+    retireInEpoch(versions->epochs, atomic_exchange(&versions->current, NULL), destroyJerryListing);
+    reclaimEpochs(versions->epochs);
+}
+
+
+void reclaimListings(ListingVersions versions) {
+    reclaimEpochs(versions->epochs);
+}
+
+
+status displayJerryListing(JerryListing* listing) {
+    Renderer out = getStandardRenderer();
+    status state = success;
+    if (listing->count == 0) {
+        state = renderString(out, "Rick we can not help you - we currently have no Jerries in the daycare ! \n");
+    }
+    for (int i = 0; i < listing->count && state == success; i++) {
+        state = renderJerryText(out, listing->jerries[i].text, listing->jerries[i].happiness);
+    }
+    status written = flushRenderer(out);
+    return state != success ? state : written;
+}
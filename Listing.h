@@ -0,0 +1,102 @@
+#ifndef LISTING_H
+#define LISTING_H
+#include "LinkedList.h"
+
+
+/**
+ * Welcome to the Listing module!
+ * This module keeps versions of the listing of a list of Jerries: the cached text and the happiness of every Jerry,
+ * taken at once. A version never changes, so it is read without the lock that guards the Jerries.
+ * The current version is built by the first reader after a change and shared by the readers that follow.
+ * A reader pins an epoch (Epoch) while it reads a version. A change drops the current version, which is freed once
+ * every reader that pinned an epoch before the drop is done.
+ * A version holds a reference to the text of every Jerry, so it keeps the texts after their Jerries change or leave.
+ */
+
+
+/**
+ * A version of the listing
+ */
+typedef struct JerryListing_t JerryListing;
+
+
+/**
+ * The current version of a listing and the old ones that are still read
+ */
+typedef struct ListingVersions_s* ListingVersions;
+
+
+
+/**
+ * Creates the versions of a listing, with no current version
+ * @return The versions, or NULL if memory ran out
+ */
+ListingVersions createListingVersions();
+
+
+
+/**
+ * Frees every version, no reader may be pinned anymore
+ * @param versions The versions (may be NULL)
+ */
+void destroyListingVersions(ListingVersions versions);
+
+
+
+/**
+ * Pins an epoch and gets the current version
+ * @param versions The versions
+ * @param epoch Set to the pinned epoch, to be passed to unpinListing
+ * @return The current version, or NULL with nothing pinned if a change dropped it
+ */
+JerryListing* pinListing(ListingVersions versions, long* epoch);
+
+
+
+/**
+ * Builds a version from the Jerries and makes it the current one, unless another reader did first, then pins it
+ * The caller holds the lock of the Jerries at least for reading, so no change can drop the version before it is pinned
+ * @param versions The versions
+ * @param jerries The Jerries, in the order they are listed
+ * @param epoch Set to the pinned epoch, to be passed to unpinListing
+ * @return The current version, or NULL with nothing pinned if memory ran out
+ */
+JerryListing* publishListing(ListingVersions versions, LinkedList jerries, long* epoch);
+
+
+
+/**
+ * Unpins the epoch of a version, the version may not be read anymore
+ * @param versions The versions
+ * @param epoch The epoch set by pinListing or publishListing
+ */
+void unpinListing(ListingVersions versions, long epoch);
+
+
+
+/**
+ * Drops the current version, called by every change to the Jerries, their happiness or their characteristics
+ * The caller holds the lock of the Jerries alone, the readers that have the version keep reading it until they are done
+ * @param versions The versions
+ */
+void dropListing(ListingVersions versions);
+
+
+
+/**
+ * Frees the old versions whose readers are done, idle threads call it so they don't wait for the next change
+ * @param versions The versions
+ */
+void reclaimListings(ListingVersions versions);
+
+
+
+/**
+ * Prints a version like the full listing of the Jerries, to the standard renderer
+ * @param listing The version
+ * @return Operation status indicating success, or memory problem / failure if the output could not be written
+ */
+status displayJerryListing(JerryListing* listing);
+
+
+#endif //LISTING_H
@@ -136,6 +136,27 @@ status removeFromMultiValueHashTable(MultiValueHashTable mvht, Element key, Elem
     return success;
 }
 
+status removeMatchingFromMultiValueHashTable(MultiValueHashTable mvht, Element key, EqualFunction matchFunction, Element filter) {
+    if (!mvht || !key || !matchFunction || !filter) return null_pointer;
+
+    LinkedList valueList = lookupInMultiValueHashTable(mvht, key);
+    if (!valueList) {
+        return failure;
+    }
+
+    status removeStatus = deleteMatchingNodes(valueList, matchFunction, filter);
+    if (removeStatus != success) {
+        return removeStatus;
+    }
+
+    // if the list is empty, remove the key from the hash table
+    if (getLengthList(valueList) == 0) {
+        return removeFromHashTable(mvht->table, key);
+    }
+
+    return success;
+}
+
 status displayMultiValueHashElementsByKey(MultiValueHashTable mvht, Element key) {
     if (!mvht || !key) return null_pointer;
 
@@ -37,7 +37,7 @@ typedef struct MultiValueHashTable_s* MultiValueHashTable;
  * @param equalKey Function to compare keys for equality (must be non-NULL)
  * @param equalValue Function to compare values for equality (must be non-NULL)
  * @param transformIntoNumber Function to transform keys into integer hash values (must be non-NULL)
- * @param hashNumber The size of the underlying hash table (must be positive)
+ * @param hashNumber The initial size of the underlying hash table (must be positive), it grows as keys are added
  * @return pointer to the new multi-value hash table, or NULL if creation failed
  */
 MultiValueHashTable createMultiValueHashTable(CopyFunction copyKey, FreeFunction freeKey, PrintFunction printKey,
@@ -90,6 +90,19 @@ LinkedList lookupInMultiValueHashTable(MultiValueHashTable mvht, Element key);
 status removeFromMultiValueHashTable(MultiValueHashTable mvht, Element key, Element value);
 
 
+/**
+ * Removes every value matching a key's filter from the values associated with that key, in a single pass
+ * over the key's values. The key itself is removed once it has no values left.
+ * @param mvht The multi-value hash table
+ * @param key The key
+ * @param matchFunction Function deciding whether a value (first argument) matches the filter (second argument)
+ * @param filter The filter passed to the match function
+ * @return Operation status indicating success, failure (if key not found or no value matched), or null pointer
+ * if received NULL in parameters
+ */
+status removeMatchingFromMultiValueHashTable(MultiValueHashTable mvht, Element key, EqualFunction matchFunction, Element filter);
+
+
 /**
  * Displays all values associated with a key in the multi-value hash table
  * @param mvht The multi-value hash table
@@ -0,0 +1,124 @@
+#include "NumberParser.h"
+
+#define MAX_FAST_DIGITS 19 // significant digits that always fit in 64 bits
+#define MAX_EXACT_MANTISSA (1ULL << 53) // every integer up to here is a double
+#define MAX_EXACT_POWER 22 // every power of ten up to here is a double
+
+
+// the powers of ten that are exactly representable as doubles
+static const double exactPowersOfTen[MAX_EXACT_POWER + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// falls back to strtod for everything the fast path can't form exactly
+static bool parseWithStrtod(const char* text, char** end, double* value) {
+    char* parsedEnd;
+    *value = strtod(text, &parsedEnd);
+    if (end) {
+        *end = parsedEnd;
+    }
+    return parsedEnd != text;
+}
+
+
+bool parseDecimal(const char* text, char** end, double* value) {
+    if (!text || !value) {
+        return false;
+    }
+    const char* current = text;
+    while (*current == ' ' || *current == '\t' || *current == '\n' || *current == '\r' || *current == '\f' || *current == '\v') {
+        current++;
+    }
+
+    bool negative = false;
+    if (*current == '+' || *current == '-') {
+        negative = *current == '-';
+        current++;
+    }
+    // hexadecimal, inf and nan are left to strtod
+    if (!isDigit(*current) && !(*current == '.' && isDigit(current[1]))) {
+        return parseWithStrtod(text, end, value);
+    }
+    if (current[0] == '0' && (current[1] == 'x' || current[1] == 'X')) {
+        return parseWithStrtod(text, end, value);
+    }
+
+    // collect the significant digits into an integer mantissa and a decimal exponent
+    unsigned long long mantissa = 0;
+    int digits = 0;       // significant digits collected, leading zeros don't count
+    int exponent = 0;     // value = mantissa * 10^exponent
+    bool truncated = false;
+
+    while (isDigit(*current)) {
+        if (digits < MAX_FAST_DIGITS) {
+            mantissa = mantissa * 10 + (unsigned long long)(*current - '0');
+            if (mantissa != 0) digits++;
+        }
+        else {
+            truncated = true;
+        }
+        current++;
+    }
+    if (*current == '.') {
+        current++;
+        while (isDigit(*current)) {
+            if (digits < MAX_FAST_DIGITS) {
+                mantissa = mantissa * 10 + (unsigned long long)(*current - '0');
+                if (mantissa != 0) digits++;
+                exponent--;
+            }
+            else {
+                truncated = true;
+            }
+            current++;
+        }
+    }
+
+    // optional exponent part, only taken if it has digits
+    if (*current == 'e' || *current == 'E') {
+        const char* exponentStart = current;
+        current++;
+        bool negativeExponent = false;
+        if (*current == '+' || *current == '-') {
+            negativeExponent = *current == '-';
+            current++;
+        }
+        if (isDigit(*current)) {
+            int explicitExponent = 0;
+            while (isDigit(*current)) {
+                if (explicitExponent < 100000) {
+                    explicitExponent = explicitExponent * 10 + (*current - '0');
+                }
+                current++;
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+        else {
+            current = exponentStart;
+        }
+    }
+
+    if (truncated || mantissa > MAX_EXACT_MANTISSA || exponent < -MAX_EXACT_POWER || exponent > MAX_EXACT_POWER) {
+        return parseWithStrtod(text, end, value);
+    }
+
+    // both operands are exact, so the single operation rounds correctly
+    double result = (double)mantissa;
+    if (exponent < 0) {
+        result /= exactPowersOfTen[-exponent];
+    }
+    else {
+        result *= exactPowersOfTen[exponent];
+    }
+    *value = negative ? -result : result;
+    if (end) {
+        *end = (char*)current;
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef NUMBERPARSER_H
+#define NUMBERPARSER_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the Number Parser module!
+ * This module converts decimal text to double, with the same correctly rounded result as strtod.
+ * Plain decimals with at most 19 significant digits whose value can be formed exactly
+ * (a mantissa below 2^53 and a power of ten below 10^23) are converted with a single exact
+ * multiplication or division, which is how the configuration's characteristic values and planet
+ * coordinates look. Anything else (long mantissas, huge exponents, hexadecimal, inf, nan)
+ * is handed to strtod, so the result is always identical.
+ */
+
+
+/**
+ * Parses a decimal number at the start of a text
+ * @param text The text to parse, leading blanks are skipped like strtod does
+ * @param end Set to the first character after the number, or to text if no number was found (may be NULL)
+ * @param value Set to the parsed value
+ * @return true if a number was parsed, false otherwise
+ */
+bool parseDecimal(const char* text, char** end, double* value);
+
+
+#endif //NUMBERPARSER_H
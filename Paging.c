@@ -0,0 +1,53 @@
+#include "Paging.h"
+#include "Render.h"
+
+#define CURSOR_SEPARATOR ':'
+
+
+int resumePosition(LinkedList list, ListCursor* reader, const char* cursor, char* (*keyOf)(Element)) {
+    if (!cursor) {
+        return 1;
+    }
+    char* end;
+    long next = strtol(cursor, &end, 10);
+    if (end == cursor || *end != CURSOR_SEPARATOR || next < 2 || next > 2147483647L) {
+        return -1;
+    }
+    const char* key = end + 1;
+    int length = getLengthList(list);
+
+    // the last item returned is still in its place, the page continues right after it
+    Element last = getDataByCursor(list, reader, (int)next - 1);
+    if (last && strcmp(keyOf(last), key) == 0) {
+        return (int)next;
+    }
+    // items before it were taken back, look for it again
+    for (int i = 1; i <= length; i++) {
+        if (strcmp(keyOf(getDataByCursor(list, reader, i)), key) == 0) {
+            return i + 1;
+        }
+    }
+    // it was taken back itself, the items after it moved up by one
+    return (int)next - 1 <= length ? (int)next - 1 : length + 1;
+}
+
+
+status displayPage(LinkedList list, ListCursor* reader, int first, int limit, char* (*keyOf)(Element)) {
+    int left = getLengthList(list) - first + 1;
+    int count = limit < left ? limit : left;
+    status state = count > 0 ? displayListRange(list, reader, first, count) : success;
+
+    Renderer out = getStandardRenderer();
+    if (state == success && count < left) {
+        state = renderString(out, "Next page : ");
+        if (state == success) state = renderInt(out, first + count);
+        if (state == success) state = renderText(out, ":", 1);
+        if (state == success) state = renderString(out, keyOf(getDataByCursor(list, reader, first + count - 1)));
+        if (state == success) state = renderText(out, " \n", 2);
+    }
+    else if (state == success) {
+        state = renderString(out, "End of the list \n");
+    }
+    status written = flushRenderer(out);
+    return state != success ? state : written;
+}
@@ -0,0 +1,41 @@
+#ifndef PAGING_H
+#define PAGING_H
+#include "LinkedList.h"
+
+
+/**
+ * Welcome to the Paging module!
+ * This module prints a list one page at a time. Every page but the last ends with a cursor to the next one,
+ * "<position>:<key>", the position of the next item and the key of the last item printed.
+ * The key finds the place again when items before it were taken out of the list since the page was printed.
+ * A page walks the list with a ListCursor of its own, so the pages read at once never share a position.
+ * The user gives the key of an item, which must not hold the separator ':' to be found again.
+ */
+
+
+/**
+ * Finds the position a page resumes from
+ * @param list The list
+ * @param reader The page's position in the list
+ * @param cursor The cursor printed at the end of the page before, or NULL for the first page
+ * @param keyOf Gives the key of an item of the list
+ * @return The position, 1 without a cursor, or -1 if the text is not a cursor
+ */
+int resumePosition(LinkedList list, ListCursor* reader, const char* cursor, char* (*keyOf)(Element));
+
+
+
+/**
+ * Prints up to limit items from a position, followed by the cursor of the next page or the end of the list
+ * The output goes to the standard renderer and is flushed
+ * @param list The list
+ * @param reader The page's position in the list
+ * @param first The position of the first item of the page
+ * @param limit The most items the page prints
+ * @param keyOf Gives the key of an item of the list
+ * @return Operation status indicating success, or memory problem / failure if the output could not be written
+ */
+status displayPage(LinkedList list, ListCursor* reader, int first, int limit, char* (*keyOf)(Element));
+
+
+#endif //PAGING_H
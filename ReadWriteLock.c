@@ -0,0 +1,112 @@
+#include "ReadWriteLock.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define READER_SLOTS 64 // threads beyond this share slots, which is still correct
+#define CACHE_LINE 64
+
+
+/* The readers of the threads that use one slot, alone on its cache line */
+typedef struct ReaderSlot_t {
+    _Alignas(CACHE_LINE) atomic_long readers;
+} ReaderSlot;
+
+
+struct ReadWriteLock_s {
+    ReaderSlot slots[READER_SLOTS];
+    _Alignas(CACHE_LINE) atomic_bool writing; // set by the writer holding or waiting for the lock
+    pthread_mutex_t writers;                  // held by that writer, readers wait on it
+};
+
+
+// every thread gets the next slot the first time it reads
+static atomic_int nextSlot;
+static _Thread_local int threadSlot = -1;
+
+static ReaderSlot* getThreadSlot(ReadWriteLock lock) {
+    if (threadSlot < 0) {
+        threadSlot = atomic_fetch_add(&nextSlot, 1) % READER_SLOTS;
+    }
+    return &lock->slots[threadSlot];
+}
+
+
+
+// Interface Functions:
+
+ReadWriteLock createReadWriteLock() {
+    ReadWriteLock lock = (ReadWriteLock)aligned_alloc(CACHE_LINE, sizeof(struct ReadWriteLock_s));
+    if (!lock) {
+        return NULL;
+    }
+    for (int i = 0; i < READER_SLOTS; i++) {
+        atomic_init(&lock->slots[i].readers, 0);
+    }
+    atomic_init(&lock->writing, false);
+    if (pthread_mutex_init(&lock->writers, NULL) != 0) {
+        free(lock);
+        return NULL;
+    }
+    return lock;
+}
+
+
+void destroyReadWriteLock(ReadWriteLock lock) {
+    if (!lock) {
+        return;
+    }
+    pthread_mutex_destroy(&lock->writers);
+    free(lock);
+}
+
+
+void lockRead(ReadWriteLock lock) {
+    if (!lock) {
+        return;
+    }
+    ReaderSlot* slot = getThreadSlot(lock);
+    while (true) {
+        // announce the reader first, a writer raising its flag at the same time then sees it
+        atomic_fetch_add(&slot->readers, 1);
+        if (!atomic_load(&lock->writing)) {
+            return;
+        }
+        // step back and sleep until the writer is done
+        atomic_fetch_sub(&slot->readers, 1);
+        pthread_mutex_lock(&lock->writers);
+        pthread_mutex_unlock(&lock->writers);
+    }
+}
+
+
+void unlockRead(ReadWriteLock lock) {
+    if (!lock) {
+        return;
+    }
+    atomic_fetch_sub_explicit(&getThreadSlot(lock)->readers, 1, memory_order_release);
+}
+
+
+void lockWrite(ReadWriteLock lock) {
+    if (!lock) {
+        return;
+    }
+    pthread_mutex_lock(&lock->writers);
+    atomic_store(&lock->writing, true);
+    // the readers that got in before the flag finish, new ones wait on the mutex
+    for (int i = 0; i < READER_SLOTS; i++) {
+        while (atomic_load(&lock->slots[i].readers) > 0) {
+            sched_yield();
+        }
+    }
+}
+
+
+void unlockWrite(ReadWriteLock lock) {
+    if (!lock) {
+        return;
+    }
+    atomic_store_explicit(&lock->writing, false, memory_order_release);
+    pthread_mutex_unlock(&lock->writers);
+}
@@ -0,0 +1,58 @@
+#ifndef READWRITELOCK_H
+#define READWRITELOCK_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the ReadWriteLock module!
+ * This module lets many threads read shared state at once while a writer changes it alone.
+ * Readers never write to a shared line of memory: every thread counts its readers in a slot of its own,
+ * each slot on its own cache line, so read locks taken on many cores don't slow each other down.
+ * A writer raises a flag, then waits for every slot to empty; a reader that sees the flag steps back and
+ * waits for the writer, so writers are never starved by a stream of readers.
+ * Writers take turns on a mutex, and a read lock is never held by a thread that asks for the write lock.
+ */
+
+
+/**
+ * A reader-writer lock
+ */
+typedef struct ReadWriteLock_s* ReadWriteLock;
+
+
+
+/**
+ * Creates an unlocked lock
+ * @return The lock, or NULL if memory ran out
+ */
+ReadWriteLock createReadWriteLock();
+
+
+
+/**
+ * Frees a lock, which must not be held
+ * @param lock The lock (may be NULL)
+ */
+void destroyReadWriteLock(ReadWriteLock lock);
+
+
+
+/**
+ * Takes the lock for reading, waiting while a writer holds it or waits for it
+ * A thread may hold one read lock of a lock at a time
+ * @param lock The lock (NULL is ignored, so unshared state needs no lock)
+ */
+void lockRead(ReadWriteLock lock);
+void unlockRead(ReadWriteLock lock);
+
+
+
+/**
+ * Takes the lock for writing, waiting until no reader or other writer holds it
+ * @param lock The lock (NULL is ignored)
+ */
+void lockWrite(ReadWriteLock lock);
+void unlockWrite(ReadWriteLock lock);
+
+
+#endif //READWRITELOCK_H
@@ -0,0 +1,259 @@
+#include "Render.h"
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define RENDER_DIRECT_SIZE 4096 // blocks at least this large skip the stream's buffer
+#define STANDARD_RENDER_SIZE 262144 // buffer of the standard output renderer
+#define MAX_NUMBER_LENGTH 512 // "%.2f" of the largest double, with room to spare
+#define FAST_FIXED_LIMIT 1e15 // below it a value times 100 fits in 64 bits, larger ones go to snprintf
+
+
+struct Renderer_s {
+    FILE* stream; // NULL for a text renderer, which keeps its text and grows instead
+    char* data;
+    size_t length;
+    size_t capacity;
+};
+
+
+// the renderer of the standard output, its stream is set on first use
+static char standardBuffer[STANDARD_RENDER_SIZE];
+static struct Renderer_s standardRenderer = { NULL, standardBuffer, 0, STANDARD_RENDER_SIZE };
+
+// what a thread renders to the standard renderer goes here instead when it is set
+static _Thread_local Renderer threadRenderer;
+
+
+// writes a block after the text already waiting in the stream
+static status writeOut(FILE* stream, const char* text, size_t length) {
+    if (length < RENDER_DIRECT_SIZE) {
+        return fwrite(text, 1, length, stream) == length ? success : failure;
+    }
+    if (fflush(stream) != 0) {
+        return failure;
+    }
+    int fd = fileno(stream);
+    while (length > 0) {
+        ssize_t written = write(fd, text, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return failure;
+        }
+        text += written;
+        length -= (size_t)written;
+    }
+    return success;
+}
+
+
+// formats a value like "%.2f" without going through printf, returns the length or 0 if the value is left to snprintf
+// a double has 53 significant bits and 100 has 7, so when long double holds 60 bits the value times 100 is exact,
+// and it is rounded to a whole number of hundredths on its exact value, ties to even like printf
+static size_t formatFixed(double value, char* text) {
+#if LDBL_MANT_DIG >= 60
+    double magnitude = value < 0 ? -value : value;
+    if (!(magnitude < FAST_FIXED_LIMIT)) { // NaN fails every comparison
+        return 0;
+    }
+    long double scaled = (long double)magnitude * 100;
+    uint64_t hundredths = (uint64_t)scaled;
+    long double rest = scaled - (long double)hundredths;
+    if (rest > 0.5L || (rest == 0.5L && (hundredths & 1))) {
+        hundredths++;
+    }
+
+    // written backwards from the last digit
+    char digits[32];
+    size_t start = sizeof(digits);
+    digits[--start] = (char)('0' + hundredths % 10);
+    digits[--start] = (char)('0' + hundredths / 10 % 10);
+    digits[--start] = '.';
+    uint64_t whole = hundredths / 100;
+    do {
+        digits[--start] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+    if (signbit(value)) { // printf keeps the sign of -0.0 and of negatives that round to zero
+        digits[--start] = '-';
+    }
+    size_t length = sizeof(digits) - start;
+    memcpy(text, digits + start, length);
+    return length;
+#else
+    return 0;
+#endif
+}
+
+
+
+// Interface Functions:
+
+Renderer createRenderer(FILE* stream, size_t capacity) {
+    if (!stream || capacity == 0) {
+        return NULL;
+    }
+    Renderer renderer = (Renderer)malloc(sizeof(struct Renderer_s));
+    if (!renderer) {
+        return NULL;
+    }
+    renderer->data = (char*)malloc(capacity);
+    if (!renderer->data) {
+        free(renderer);
+        return NULL;
+    }
+    renderer->stream = stream;
+    renderer->length = 0;
+    renderer->capacity = capacity;
+    return renderer;
+}
+
+
+void destroyRenderer(Renderer renderer) {
+    if (!renderer || renderer == &standardRenderer) {
+        return;
+    }
+    flushRenderer(renderer);
+    free(renderer->data);
+    free(renderer);
+}
+
+
+Renderer createTextRenderer(size_t capacity) {
+    Renderer renderer = (Renderer)malloc(sizeof(struct Renderer_s));
+    if (!renderer) {
+        return NULL;
+    }
+    renderer->data = (char*)malloc(capacity > 0 ? capacity : 1);
+    if (!renderer->data) {
+        free(renderer);
+        return NULL;
+    }
+    renderer->stream = NULL;
+    renderer->length = 0;
+    renderer->capacity = capacity > 0 ? capacity : 1;
+    return renderer;
+}
+
+
+char* takeRenderedText(Renderer renderer, size_t* length) {
+    if (!renderer || !length || renderer->stream) {
+        return NULL;
+    }
+    // the text keeps only the memory it uses
+    char* text = (char*)realloc(renderer->data, renderer->length > 0 ? renderer->length : 1);
+    if (!text) {
+        text = renderer->data;
+    }
+    *length = renderer->length;
+    free(renderer);
+    return text;
+}
+
+
+size_t getRenderedLength(Renderer renderer) {
+    return renderer ? renderer->length : 0;
+}
+
+
+Renderer getStandardRenderer() {
+    if (threadRenderer) {
+        return threadRenderer;
+    }
+    if (!standardRenderer.stream) {
+        standardRenderer.stream = stdout;
+    }
+    return &standardRenderer;
+}
+
+
+void setThreadRenderer(Renderer renderer) {
+    threadRenderer = renderer;
+}
+
+
+status renderText(Renderer renderer, const char* text, size_t length) {
+    if (!renderer || !text) {
+        return null_pointer;
+    }
+    if (length > renderer->capacity - renderer->length && !renderer->stream) {
+        size_t capacity = renderer->capacity * 2;
+        while (capacity - renderer->length < length) {
+            capacity *= 2;
+        }
+        char* data = (char*)realloc(renderer->data, capacity);
+        if (!data) {
+            return memory_problem;
+        }
+        renderer->data = data;
+        renderer->capacity = capacity;
+    }
+    else if (length > renderer->capacity - renderer->length) {
+        status flushed = flushRenderer(renderer);
+        if (flushed != success) {
+            return flushed;
+        }
+        // the buffer is empty now, a text larger than all of it is written out as it is
+        if (length > renderer->capacity) {
+            return writeOut(renderer->stream, text, length);
+        }
+    }
+    memcpy(renderer->data + renderer->length, text, length);
+    renderer->length += length;
+    return success;
+}
+
+
+status renderString(Renderer renderer, const char* text) {
+    if (!text) {
+        return null_pointer;
+    }
+    return renderText(renderer, text, strlen(text));
+}
+
+
+status renderInt(Renderer renderer, int value) {
+    char digits[16];
+    size_t start = sizeof(digits);
+    // the magnitude is taken as unsigned, so the smallest int doesn't overflow
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[--start] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[--start] = '-';
+    }
+    return renderText(renderer, digits + start, sizeof(digits) - start);
+}
+
+
+status renderFixed(Renderer renderer, double value) {
+    char number[MAX_NUMBER_LENGTH];
+    size_t fast = formatFixed(value, number);
+    if (fast > 0) {
+        return renderText(renderer, number, fast);
+    }
+    int length = snprintf(number, sizeof(number), "%.2f", value);
+    if (length < 0 || (size_t)length >= sizeof(number)) {
+        return failure;
+    }
+    return renderText(renderer, number, (size_t)length);
+}
+
+
+status flushRenderer(Renderer renderer) {
+    if (!renderer) {
+        return null_pointer;
+    }
+    if (!renderer->stream) {
+        return success; // a text renderer keeps its text
+    }
+    status written = renderer->length > 0 ? writeOut(renderer->stream, renderer->data, renderer->length) : success;
+    renderer->length = 0;
+    return written;
+}
@@ -0,0 +1,108 @@
+#ifndef RENDER_H
+#define RENDER_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the Render module!
+ * This module formats output text into a large reusable buffer instead of calling printf for every field.
+ * The buffer is written out when it fills up or when the renderer is flushed: a large block goes straight
+ * to the file descriptor of the stream with write, after whatever the stream itself still holds, and a
+ * small one is handed to the stream, so rendered text and text printed with stdio always come out in order.
+ * Whoever renders must flush before printing anything else with stdio.
+ * A text renderer has no stream: it keeps its text in memory and grows, so text can be rendered once and kept.
+ * The numbers are formatted exactly like printf's "%d" and "%.2f".
+ */
+
+
+/**
+ * A buffer of text waiting to be written to a stream
+ */
+typedef struct Renderer_s* Renderer;
+
+
+
+/**
+ * Creates a renderer for a stream
+ * @param stream The stream the text is written to
+ * @param capacity Size of the buffer in bytes, the text is written out whenever it is full
+ * @return The renderer, or NULL if stream is NULL, capacity is 0 or memory ran out
+ */
+Renderer createRenderer(FILE* stream, size_t capacity);
+
+
+
+/**
+ * Flushes and frees a renderer
+ * @param renderer The renderer (may be NULL)
+ */
+void destroyRenderer(Renderer renderer);
+
+
+
+/**
+ * Creates a text renderer, which keeps everything rendered to it in memory
+ * @param capacity Initial size of the buffer in bytes, it doubles when it is full
+ * @return The renderer, or NULL if memory ran out
+ */
+Renderer createTextRenderer(size_t capacity);
+
+
+
+/**
+ * Takes the text of a text renderer and frees the renderer
+ * @param renderer A text renderer
+ * @param length Set to the length of the text
+ * @return The text (not terminated), to be freed by the caller, or NULL if renderer is not a text renderer
+ */
+char* takeRenderedText(Renderer renderer, size_t* length);
+
+
+
+/**
+ * @param renderer The renderer
+ * @return The number of bytes rendered since it was last flushed (all of them for a text renderer), 0 if renderer is NULL
+ */
+size_t getRenderedLength(Renderer renderer);
+
+
+
+/**
+ * @return The renderer of the standard output, created on first use and shared by every module,
+ * or the renderer the calling thread set in its place
+ */
+Renderer getStandardRenderer();
+
+
+
+/**
+ * Sets the renderer that getStandardRenderer returns to the calling thread, so code that renders to the
+ * standard output can run on many threads at once, each with a text renderer of its own
+ * The standard output renderer itself must only be used by one thread
+ * @param renderer The renderer of the thread, NULL to go back to the standard output
+ */
+void setThreadRenderer(Renderer renderer);
+
+
+
+/**
+ * Appends text to the buffer, writing the buffer out first if there is no room for it
+ * Every render function returns success, failure if the text could not be written out,
+ * memory problem if a text renderer could not grow, or null pointer if received NULL in parameters
+ */
+status renderText(Renderer renderer, const char* text, size_t length);
+status renderString(Renderer renderer, const char* text);
+status renderInt(Renderer renderer, int value);    // like "%d"
+status renderFixed(Renderer renderer, double value); // like "%.2f"
+
+
+
+/**
+ * Writes out the text rendered so far, a text renderer keeps it
+ * @param renderer The renderer
+ * @return Operation status indicating success, failure if the text could not be written, null pointer if renderer is NULL
+ */
+status flushRenderer(Renderer renderer);
+
+
+#endif //RENDER_H
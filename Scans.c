@@ -0,0 +1,192 @@
+#include "Scans.h"
+#include <math.h>
+
+#define SHARD_MIN_JERRIES 1024 // a list with fewer Jerries than this per shard is scanned on the calling thread
+#define SHARD_TEXT_SIZE 262144 // starting size of the text a shard renders its Jerries to
+#define SHARD_RUN_STARTS 4 // lists whose run start every shard's thread keeps
+
+
+/* The best Jerry a shard found for a scan */
+typedef struct ShardCandidate_t {
+    Jerry* jerry;    // NULL if the shard has no Jerry for the scan
+    double distance; // how far the Jerry is from what the scan looks for, the smallest wins
+    int position;    // the Jerry's place in the scanned list, breaks ties like a single scan would, the first one wins
+} ShardCandidate;
+
+
+/* What the shards need for a scan of a list of Jerries, every shard only writes its own parts */
+typedef struct ShardScan_t {
+    LinkedList jerries; // every shard scans an even run of its positions
+    int shards;
+    int activity;       // the activity the Jerries play
+    int (*happinessAfter)(int happiness, int activity);
+    char* name;         // the characteristic a similar Jerry is found by
+    double value;       // the value the characteristic is compared to
+    ShardCandidate candidates[MAX_SHARDS];
+    Renderer texts[MAX_SHARDS]; // what the shards after the first rendered, the first renders to the caller's renderer
+} ShardScan;
+
+
+// where the runs of the last lists a thread scanned started, so its next run of a list seldom walks from the head
+static _Thread_local ListCursor runStarts[SHARD_RUN_STARTS];
+static _Thread_local int nextRunStart; // the start replaced by a list the thread has none of
+
+
+bool isWorthSharding(ShardPool shards, LinkedList jerries) {
+    return shards && getLengthList(jerries) / getShardCount(shards) >= SHARD_MIN_JERRIES;
+}
+
+
+// the positions of the list a shard scans, last is before first if the shard has none
+// the thread's position is left on the first one, so the run goes on from there
+static void getShardRun(ShardScan* scan, int shard, int* first, int* last) {
+    long length = getLengthList(scan->jerries);
+    *first = (int)(length * shard / scan->shards) + 1;
+    *last = (int)(length * (shard + 1) / scan->shards);
+    if (*last < *first) {
+        return;
+    }
+    ListCursor* start = NULL;
+    for (int i = 0; i < SHARD_RUN_STARTS && !start; i++) {
+        if (runStarts[i].list == scan->jerries) {
+            start = &runStarts[i];
+        }
+    }
+    if (!start) {
+        start = &runStarts[nextRunStart];
+        nextRunStart = (nextRunStart + 1) % SHARD_RUN_STARTS;
+        *start = (ListCursor){ .list = NULL };
+    }
+    getDataByCursor(scan->jerries, start, *first);
+}
+
+
+// keeps a Jerry if it beats the candidate
+static void offerCandidate(ShardCandidate* candidate, Jerry* jerry, double distance, int position) {
+    if (!candidate->jerry || distance < candidate->distance || (distance == candidate->distance && position < candidate->position)) {
+        candidate->jerry = jerry;
+        candidate->distance = distance;
+        candidate->position = position;
+    }
+}
+
+
+// the saddest Jerry of a shard's run, among the equally sad the first one
+static status findSaddestInRun(void* context, int shard) {
+    ShardScan* scan = (ShardScan*)context;
+    ShardCandidate* candidate = &scan->candidates[shard];
+    int first, last;
+    getShardRun(scan, shard, &first, &last);
+    candidate->jerry = NULL;
+    for (int i = first; i <= last; i++) {
+        Jerry* jerry = getDataByIndex(scan->jerries, i);
+        offerCandidate(candidate, jerry, jerry->happiness, i);
+    }
+    return success;
+}
+
+
+// the Jerry of a shard's run whose characteristic is closest to the value, among the equally close the first one
+static status findSimilarInRun(void* context, int shard) {
+    ShardScan* scan = (ShardScan*)context;
+    ShardCandidate* candidate = &scan->candidates[shard];
+    int first, last;
+    getShardRun(scan, shard, &first, &last);
+    candidate->jerry = NULL;
+    for (int i = first; i <= last; i++) {
+        Jerry* jerry = getDataByIndex(scan->jerries, i);
+        PhysicalCharacteristic* pc = jerry ? getPhysicalCharacteristic(jerry, scan->name) : NULL;
+        if (pc) {
+            offerCandidate(candidate, jerry, fabs(pc->value - scan->value), i);
+        }
+    }
+    return success;
+}
+
+
+// scatters a scan to the shards and merges their candidates, NULL if no shard found a Jerry
+static Jerry* scanShards(ShardPool shards, ShardScan* scan, status (*findInRun)(void* context, int shard)) {
+    scan->shards = getShardCount(shards);
+    if (runOnShards(shards, findInRun, scan) != success) {
+        return NULL;
+    }
+    ShardCandidate best = { .jerry = NULL };
+    for (int i = 0; i < scan->shards; i++) {
+        ShardCandidate* candidate = &scan->candidates[i];
+        if (candidate->jerry) {
+            offerCandidate(&best, candidate->jerry, candidate->distance, candidate->position);
+        }
+    }
+    return best.jerry;
+}
+
+
+Jerry* findSaddestOnShards(ShardPool shards, LinkedList jerries) {
+    ShardScan scan = { .jerries = jerries };
+    return scanShards(shards, &scan, findSaddestInRun);
+}
+
+
+Jerry* findSimilarOnShards(ShardPool shards, LinkedList jerries, char* name, double value) {
+    ShardScan scan = { .jerries = jerries, .name = name, .value = value };
+    return scanShards(shards, &scan, findSimilarInRun);
+}
+
+
+// renders a shard's run, the shards after the first to a text of their own that the caller adds after the run before
+static status renderRun(void* context, int shard) {
+    ShardScan* scan = (ShardScan*)context;
+    int first, last;
+    getShardRun(scan, shard, &first, &last);
+    if (last < first) {
+        return success;
+    }
+    if (shard == 0) {
+        return displayListRange(scan->jerries, NULL, first, last - first + 1);
+    }
+    scan->texts[shard] = createTextRenderer(SHARD_TEXT_SIZE);
+    if (!scan->texts[shard]) {
+        return memory_problem;
+    }
+    setThreadRenderer(scan->texts[shard]);
+    status state = displayListRange(scan->jerries, NULL, first, last - first + 1);
+    setThreadRenderer(NULL);
+    return state;
+}
+
+
+status displayOnShards(ShardPool shards, LinkedList jerries) {
+    ShardScan scan = { .jerries = jerries, .shards = getShardCount(shards) };
+    status state = runOnShards(shards, renderRun, &scan);
+    Renderer out = getStandardRenderer();
+    for (int i = 1; i < scan.shards; i++) {
+        size_t length;
+        char* text = scan.texts[i] ? takeRenderedText(scan.texts[i], &length) : NULL;
+        if (text && state == success) {
+            state = renderText(out, text, length);
+        }
+        free(text);
+    }
+    status written = flushRenderer(out);
+    return state != success ? state : written;
+}
+
+
+// the Jerries of a shard's run play the activity of the scan
+static status playRun(void* context, int shard) {
+    ShardScan* scan = (ShardScan*)context;
+    int first, last;
+    getShardRun(scan, shard, &first, &last);
+    for (int i = first; i <= last; i++) {
+        Jerry* jerry = getDataByIndex(scan->jerries, i);
+        jerry->happiness = scan->happinessAfter(jerry->happiness, scan->activity);
+    }
+    return success;
+}
+
+
+status playOnShards(ShardPool shards, LinkedList jerries, int activity, int (*happinessAfter)(int happiness, int activity)) {
+    ShardScan scan = { .jerries = jerries, .shards = getShardCount(shards), .activity = activity,
+                       .happinessAfter = happinessAfter };
+    return runOnShards(shards, playRun, &scan);
+}
@@ -0,0 +1,75 @@
+#ifndef SCANS_H
+#define SCANS_H
+#include "Jerry.h"
+#include "LinkedList.h"
+#include "Shards.h"
+#define MAX_SHARDS 64 // threads a scan may be split between
+
+
+/**
+ * Welcome to the Scans module!
+ * This module runs the full scans over a list of Jerries in parallel, on a pool of shards (Shards).
+ * When a scan starts, every shard takes an even run of the positions of the list, and the results of the runs are
+ * merged in the order of the list, so a scan gives the answer a single scan on one thread would give.
+ * The shards own no Jerries: the list stays where the caller keeps it, and adding or taking out a Jerry costs nothing.
+ * A shard's thread goes on from where its run of a list started last time, even after a Jerry before it was taken out.
+ * The caller keeps the list from changing while a scan runs, but for the happiness a played activity changes.
+ */
+
+
+
+/**
+ * Tells whether a list is long enough for its scans to be worth splitting between the shards
+ * @param shards The shards (may be NULL, then no list is)
+ * @param jerries The list of Jerries
+ * @return true if the scans of the list should run on the shards
+ */
+bool isWorthSharding(ShardPool shards, LinkedList jerries);
+
+
+
+/**
+ * Finds the saddest Jerry of a list, among the equally sad the first one
+ * @param shards The shards
+ * @param jerries The list of Jerries
+ * @return The Jerry, or NULL if the list is empty or a shard failed
+ */
+Jerry* findSaddestOnShards(ShardPool shards, LinkedList jerries);
+
+
+
+/**
+ * Finds the Jerry of a list whose characteristic is the closest to a value, among the equally close the first one
+ * @param shards The shards
+ * @param jerries The list of Jerries
+ * @param name The name of the characteristic
+ * @param value The value it is compared to
+ * @return The Jerry, or NULL if no Jerry of the list has the characteristic or a shard failed
+ */
+Jerry* findSimilarOnShards(ShardPool shards, LinkedList jerries, char* name, double value);
+
+
+
+/**
+ * Prints every Jerry of a list to the standard renderer, in the order of the list, and flushes it
+ * Every shard renders its run to a text of its own, and the texts are joined in order
+ * @param shards The shards
+ * @param jerries The list of Jerries
+ * @return Operation status indicating success, or memory problem / failure if the output could not be written
+ */
+status displayOnShards(ShardPool shards, LinkedList jerries);
+
+
+
+/**
+ * Lets every Jerry of a list play an activity
+ * @param shards The shards
+ * @param jerries The list of Jerries
+ * @param activity The activity
+ * @param happinessAfter Gives the happiness of a Jerry after the activity
+ * @return Operation status indicating success, or the status of the first shard that failed
+ */
+status playOnShards(ShardPool shards, LinkedList jerries, int activity, int (*happinessAfter)(int happiness, int activity));
+
+
+#endif //SCANS_H
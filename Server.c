@@ -0,0 +1,667 @@
+#include "Server.h"
+#include "Render.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 64 // events taken from epoll at once
+#define READ_SIZE 65536 // bytes read from a client at once
+#define MAX_LINE_SIZE 1048576 // a client whose line grows past this is dropped
+#define MAX_PENDING_ANSWERS 16777216 // unsent bytes of answers past which a client is not read
+#define IDLE_MILLISECONDS 1000
+#define ANSWER_END ".\n" // ends the answer of every line
+#define WORKER_ANSWER_SIZE 4096 // first size of the text renderer of a line run on a worker
+
+
+/* Bytes waiting in memory, the ones before start are already used */
+typedef struct Buffer_t {
+    char* data;
+    size_t start;
+    size_t length; // bytes from start
+    size_t capacity;
+} Buffer;
+
+
+typedef struct Connection_t {
+    int socket;
+    Buffer input;  // received text, from the first line not run yet
+    Buffer output; // answers not sent yet
+    int lines;     // lines run so far
+    bool ended;    // the client sent everything it will send
+    bool busy;     // a line of the connection is running on a worker, the next ones wait for it
+    bool dropped;  // closed while busy, freed once its line is done
+    uint32_t events; // the events the connection is registered for
+    struct Connection_t* previous;
+    struct Connection_t* next;
+} Connection;
+
+
+/* A shared line run by a worker, and its answer */
+typedef struct Job_t {
+    Connection* connection;
+    char* line;
+    int number;
+    char* answer;
+    size_t length;
+    status result;
+    struct Job_t* next;
+} Job;
+
+
+typedef struct Server_t {
+    int epoll;
+    int listener;
+    int signals;
+    int finished;       // an eventfd, counts the jobs the workers finished
+    pthread_t* workers;
+    int running;        // workers started
+    pthread_mutex_t jobsLock;
+    pthread_cond_t jobsReady;
+    Job* waiting;       // jobs not started yet, oldest first
+    Job* lastWaiting;
+    Job* done;          // finished jobs, taken by the loop
+    bool stopping;
+    const char* path;   // set once the socket file is created
+    FILE* capture;      // the standard output of the lines goes here while they run
+    int standardOutput; // copy of the real standard output
+    Connection* connections;
+    ServerHandlers* handlers;
+} Server;
+
+
+
+/** buffers **/
+
+
+// makes room for extra bytes after the text, the used bytes are dropped first
+static status reserveBuffer(Buffer* buffer, size_t extra) {
+    if (buffer->start > 0) {
+        memmove(buffer->data, buffer->data + buffer->start, buffer->length);
+        buffer->start = 0;
+    }
+    if (buffer->capacity - buffer->length >= extra) {
+        return success;
+    }
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity * 2 : READ_SIZE;
+    while (capacity - buffer->length < extra) {
+        capacity *= 2;
+    }
+    char* data = (char*)realloc(buffer->data, capacity);
+    if (!data) {
+        return memory_problem;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return success;
+}
+
+
+static status appendBuffer(Buffer* buffer, const char* text, size_t length) {
+    if (length == 0) {
+        return success;
+    }
+    status reserved = reserveBuffer(buffer, length);
+    if (reserved != success) {
+        return reserved;
+    }
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+    return success;
+}
+
+
+// uses up bytes from the front of the buffer
+static void consumeBuffer(Buffer* buffer, size_t length) {
+    buffer->start += length;
+    buffer->length -= length;
+    if (buffer->length == 0) {
+        buffer->start = 0;
+    }
+}
+
+
+
+/** connections **/
+
+
+static void freeConnection(Connection* connection) {
+    free(connection->input.data);
+    free(connection->output.data);
+    free(connection);
+}
+
+
+static void closeConnection(Server* server, Connection* connection) {
+    epoll_ctl(server->epoll, EPOLL_CTL_DEL, connection->socket, NULL);
+    close(connection->socket);
+    if (connection->previous) {
+        connection->previous->next = connection->next;
+    }
+    else {
+        server->connections = connection->next;
+    }
+    if (connection->next) {
+        connection->next->previous = connection->previous;
+    }
+    // a worker still holds it
+    if (connection->busy) {
+        connection->dropped = true;
+        return;
+    }
+    freeConnection(connection);
+}
+
+
+static void acceptConnections(Server* server) {
+    int client;
+    while ((client = accept(server->listener, NULL, NULL)) >= 0) {
+        Connection* connection = (Connection*)calloc(1, sizeof(Connection));
+        struct epoll_event event = { EPOLLIN, { .ptr = connection } };
+        if (!connection || fcntl(client, F_SETFL, O_NONBLOCK) != 0 || fcntl(client, F_SETFD, FD_CLOEXEC) != 0 ||
+            epoll_ctl(server->epoll, EPOLL_CTL_ADD, client, &event) != 0) {
+            free(connection);
+            close(client);
+            continue;
+        }
+        connection->socket = client;
+        connection->events = EPOLLIN;
+        connection->next = server->connections;
+        if (server->connections) {
+            server->connections->previous = connection;
+        }
+        server->connections = connection;
+    }
+}
+
+
+// runs a line with the standard output captured, and adds what it printed to the answers of the connection
+static status answerLine(Server* server, Connection* connection, char* line) {
+    int capture = fileno(server->capture);
+    fflush(stdout);
+    if (dup2(capture, STDOUT_FILENO) < 0) {
+        return failure;
+    }
+    status result = server->handlers->onLine(server->handlers->context, line, ++connection->lines);
+    fflush(stdout);
+    dup2(server->standardOutput, STDOUT_FILENO);
+
+    // the line wrote through a copy of the capture, which shares its offset
+    off_t length = lseek(capture, 0, SEEK_CUR);
+    status added = length >= 0 ? reserveBuffer(&connection->output, (size_t)length + strlen(ANSWER_END)) : failure;
+    if (added == success && pread(capture, connection->output.data + connection->output.length, (size_t)length, 0) != length) {
+        added = failure;
+    }
+    if (added == success) {
+        connection->output.length += (size_t)length;
+        added = appendBuffer(&connection->output, ANSWER_END, strlen(ANSWER_END));
+    }
+    if (ftruncate(capture, 0) != 0 || lseek(capture, 0, SEEK_SET) != 0) {
+        added = failure;
+    }
+    return result != success ? result : added;
+}
+
+
+// hands a shared line to the workers, the connection waits for it before running its next line
+static status startJob(Server* server, Connection* connection, const char* line) {
+    Job* job = (Job*)calloc(1, sizeof(Job));
+    if (!job || !(job->line = (char*)malloc(strlen(line) + 1))) {
+        free(job);
+        return memory_problem;
+    }
+    strcpy(job->line, line);
+    job->connection = connection;
+    job->number = ++connection->lines;
+    connection->busy = true;
+
+    pthread_mutex_lock(&server->jobsLock);
+    if (server->lastWaiting) {
+        server->lastWaiting->next = job;
+    }
+    else {
+        server->waiting = job;
+    }
+    server->lastWaiting = job;
+    pthread_cond_signal(&server->jobsReady);
+    pthread_mutex_unlock(&server->jobsLock);
+    return success;
+}
+
+
+// runs the complete lines of a connection, until its unsent answers grow too large or a line goes to a worker
+static status runLines(Server* server, Connection* connection) {
+    while (connection->input.length > 0 && connection->output.length < MAX_PENDING_ANSWERS && !connection->busy) {
+        char* line = connection->input.data + connection->input.start;
+        char* end = (char*)memchr(line, '\n', connection->input.length);
+        // the last line of a client that ended may have no newline
+        if (!end && !connection->ended) {
+            break;
+        }
+        size_t length = end ? (size_t)(end - line) + 1 : connection->input.length;
+        if (!end) {
+            status reserved = reserveBuffer(&connection->input, 1);
+            if (reserved != success) {
+                return reserved;
+            }
+            line = connection->input.data;
+            end = line + length;
+        }
+        *end = '\0';
+        ServerHandlers* handlers = server->handlers;
+        bool shared = server->running > 0 && handlers->isShared && handlers->isShared(handlers->context, line);
+        status result = shared ? startJob(server, connection, line) : answerLine(server, connection, line);
+        consumeBuffer(&connection->input, length);
+        if (result != success) {
+            return result;
+        }
+    }
+    return success;
+}
+
+
+// reads what the client sent, returns false if the connection failed or sent a line too long
+static bool readConnection(Connection* connection) {
+    if (reserveBuffer(&connection->input, READ_SIZE) != success) {
+        return false;
+    }
+    ssize_t received = read(connection->socket, connection->input.data + connection->input.length, READ_SIZE);
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    if (received == 0) {
+        connection->ended = true;
+        return true;
+    }
+    connection->input.length += (size_t)received;
+    return connection->input.length <= MAX_LINE_SIZE ||
+           memchr(connection->input.data, '\n', connection->input.length) != NULL;
+}
+
+
+// writes as much of the answers as the client takes, returns false if the connection failed
+static bool sendAnswers(Connection* connection) {
+    while (connection->output.length > 0) {
+        ssize_t sent = send(connection->socket, connection->output.data + connection->output.start,
+                            connection->output.length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        consumeBuffer(&connection->output, (size_t)sent);
+    }
+    return true;
+}
+
+
+// the connection is read while it may send more and its answers are not too far behind, and written while it has answers
+static void updateEvents(Server* server, Connection* connection) {
+    uint32_t events = 0;
+    if (!connection->ended && connection->output.length < MAX_PENDING_ANSWERS) {
+        events |= EPOLLIN;
+    }
+    if (connection->output.length > 0) {
+        events |= EPOLLOUT;
+    }
+    if (events != connection->events) {
+        struct epoll_event event = { events, { .ptr = connection } };
+        epoll_ctl(server->epoll, EPOLL_CTL_MOD, connection->socket, &event);
+        connection->events = events;
+    }
+}
+
+
+static status serveConnection(Server* server, Connection* connection, uint32_t events) {
+    bool open = true;
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR) && connection->events & EPOLLIN) {
+        open = readConnection(connection);
+    }
+    status result = success;
+    while (open && result == success) {
+        size_t waiting = connection->input.length;
+        bool heldBack = connection->output.length >= MAX_PENDING_ANSWERS;
+        result = runLines(server, connection);
+        open = sendAnswers(connection);
+        // lines held back until the answers before them were sent are run right away
+        if (connection->output.length > 0 || (connection->input.length == waiting && !heldBack)) {
+            break;
+        }
+    }
+    // a client that ended is closed once all of its lines are answered
+    bool done = connection->ended && connection->input.length == 0 && connection->output.length == 0 && !connection->busy;
+    if (!open || done || result != success) {
+        closeConnection(server, connection);
+    }
+    else {
+        updateEvents(server, connection);
+    }
+    return result;
+}
+
+
+
+/** workers **/
+
+
+static void* runWorker(void* context) {
+    Server* server = (Server*)context;
+    ServerHandlers* handlers = server->handlers;
+    while (true) {
+        pthread_mutex_lock(&server->jobsLock);
+        while (!server->waiting && !server->stopping) {
+            pthread_cond_wait(&server->jobsReady, &server->jobsLock);
+        }
+        if (server->stopping) {
+            pthread_mutex_unlock(&server->jobsLock);
+            return NULL;
+        }
+        Job* job = server->waiting;
+        server->waiting = job->next;
+        if (!server->waiting) {
+            server->lastWaiting = NULL;
+        }
+        pthread_mutex_unlock(&server->jobsLock);
+
+        // the line renders its answer to a renderer of this thread
+        Renderer answer = createTextRenderer(WORKER_ANSWER_SIZE);
+        if (answer) {
+            setThreadRenderer(answer);
+            job->result = handlers->onLine(handlers->context, job->line, job->number);
+            setThreadRenderer(NULL);
+            job->answer = takeRenderedText(answer, &job->length);
+        }
+        if (!job->answer && job->result == success) {
+            job->result = memory_problem;
+        }
+
+        pthread_mutex_lock(&server->jobsLock);
+        job->next = server->done;
+        server->done = job;
+        pthread_mutex_unlock(&server->jobsLock);
+        uint64_t one = 1;
+        write(server->finished, &one, sizeof(one));
+    }
+}
+
+
+static void freeJobs(Job* job) {
+    while (job) {
+        Job* next = job->next;
+        free(job->line);
+        free(job->answer);
+        free(job);
+        job = next;
+    }
+}
+
+
+// adds the answers of the finished jobs to their connections, and goes on with the lines that waited for them
+static status finishJobs(Server* server) {
+    uint64_t count;
+    read(server->finished, &count, sizeof(count));
+    pthread_mutex_lock(&server->jobsLock);
+    Job* done = server->done;
+    server->done = NULL;
+    pthread_mutex_unlock(&server->jobsLock);
+
+    status result = success;
+    while (done) {
+        Job* job = done;
+        done = job->next;
+        job->next = NULL;
+        Connection* connection = job->connection;
+        connection->busy = false;
+        if (result == success) {
+            result = job->result;
+        }
+        if (connection->dropped) {
+            freeConnection(connection);
+        }
+        else {
+            status added = appendBuffer(&connection->output, job->answer, job->length);
+            if (added == success) {
+                added = appendBuffer(&connection->output, ANSWER_END, strlen(ANSWER_END));
+            }
+            if (result == success) {
+                result = added;
+            }
+            if (result == success) {
+                result = serveConnection(server, connection, 0);
+            }
+        }
+        freeJobs(job);
+    }
+    freeJobs(done);
+    return result;
+}
+
+
+static status startWorkers(Server* server) {
+    int count = server->handlers->workers;
+    if (count <= 0) {
+        return success;
+    }
+    server->workers = (pthread_t*)malloc(sizeof(pthread_t) * count);
+    if (!server->workers) {
+        return memory_problem;
+    }
+    server->finished = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event event = { EPOLLIN, { .ptr = &server->finished } };
+    if (server->finished < 0 || epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->finished, &event) != 0) {
+        return failure;
+    }
+    for (; server->running < count; server->running++) {
+        if (pthread_create(&server->workers[server->running], NULL, runWorker, server) != 0) {
+            return failure;
+        }
+    }
+    return success;
+}
+
+
+// the workers finish the lines they are running, the lines still waiting are dropped
+static void stopWorkers(Server* server) {
+    pthread_mutex_lock(&server->jobsLock);
+    server->stopping = true;
+    pthread_cond_broadcast(&server->jobsReady);
+    pthread_mutex_unlock(&server->jobsLock);
+    for (int i = 0; i < server->running; i++) {
+        pthread_join(server->workers[i], NULL);
+    }
+    server->running = 0;
+    free(server->workers);
+    // a connection whose line never finished is freed with the others
+    for (Job* job = server->waiting; job; job = job->next) {
+        job->connection->busy = false;
+    }
+    for (Job* job = server->done; job; job = job->next) {
+        job->connection->busy = false;
+    }
+    for (Job* job = server->waiting; job; job = job->next) {
+        if (job->connection->dropped) {
+            freeConnection(job->connection);
+        }
+    }
+    for (Job* job = server->done; job; job = job->next) {
+        if (job->connection->dropped) {
+            freeConnection(job->connection);
+        }
+    }
+    freeJobs(server->waiting);
+    freeJobs(server->done);
+    server->waiting = server->lastWaiting = server->done = NULL;
+    if (server->finished >= 0) {
+        close(server->finished);
+    }
+}
+
+
+
+/** setup **/
+
+
+static status openListener(Server* server, const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return failure;
+    }
+    strcpy(address.sun_path, path);
+
+    // only a socket is replaced, never a file that happens to have the name
+    struct stat existing;
+    if (lstat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        unlink(path);
+    }
+    server->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server->listener < 0) {
+        return failure;
+    }
+    if (bind(server->listener, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        return failure;
+    }
+    server->path = path;
+    if (listen(server->listener, SOMAXCONN) != 0) {
+        return failure;
+    }
+    struct epoll_event event = { EPOLLIN, { .ptr = &server->listener } };
+    return epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->listener, &event) == 0 ? success : failure;
+}
+
+
+// the stop signals are read from a descriptor in the loop instead of interrupting it
+static status openSignals(Server* server, sigset_t* previousMask) {
+    sigset_t stop;
+    sigemptyset(&stop);
+    sigaddset(&stop, SIGINT);
+    sigaddset(&stop, SIGTERM);
+    if (sigprocmask(SIG_BLOCK, &stop, previousMask) != 0) {
+        return failure;
+    }
+    server->signals = signalfd(-1, &stop, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (server->signals < 0) {
+        return failure;
+    }
+    struct epoll_event event = { EPOLLIN, { .ptr = &server->signals } };
+    return epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->signals, &event) == 0 ? success : failure;
+}
+
+
+static status serve(Server* server) {
+    struct epoll_event events[MAX_EVENTS];
+    while (true) {
+        int count = epoll_wait(server->epoll, events, MAX_EVENTS, IDLE_MILLISECONDS);
+        if (count < 0 && errno != EINTR) {
+            return failure;
+        }
+        bool finished = false;
+        for (int i = 0; i < count; i++) {
+            void* source = events[i].data.ptr;
+            if (source == &server->signals) {
+                // taken from the descriptor, or it is delivered once the signals are unblocked
+                struct signalfd_siginfo signal;
+                if (read(server->signals, &signal, sizeof(signal)) == (ssize_t)sizeof(signal)) {
+                    return success;
+                }
+                continue;
+            }
+            if (source == &server->listener) {
+                acceptConnections(server);
+                continue;
+            }
+            if (source == &server->finished) {
+                finished = true;
+                continue;
+            }
+            status result = serveConnection(server, (Connection*)source, events[i].events);
+            if (result != success) {
+                return result;
+            }
+        }
+        // last, as going on with the lines of a connection may close it while it still has events in this batch
+        if (finished) {
+            status result = finishJobs(server);
+            if (result != success) {
+                return result;
+            }
+        }
+        if (server->handlers->onIdle) {
+            server->handlers->onIdle(server->handlers->context);
+        }
+    }
+}
+
+
+
+// Interface Functions:
+
+status runServer(const char* path, ServerHandlers* handlers) {
+    if (!path || !handlers || !handlers->onLine) {
+        return null_pointer;
+    }
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.epoll = server.listener = server.signals = server.finished = server.standardOutput = -1;
+    server.handlers = handlers;
+    pthread_mutex_init(&server.jobsLock, NULL);
+    pthread_cond_init(&server.jobsReady, NULL);
+    sigset_t previousMask;
+    bool masked = false;
+
+    server.epoll = epoll_create1(EPOLL_CLOEXEC);
+    server.capture = tmpfile();
+    server.standardOutput = dup(STDOUT_FILENO);
+    status result = server.epoll >= 0 && server.capture && server.standardOutput >= 0 ? success : failure;
+    if (result == success) {
+        result = openListener(&server, path);
+    }
+    if (result == success) {
+        result = openSignals(&server, &previousMask);
+        masked = true;
+    }
+    // the workers start with the stop signals blocked, so the signals always reach the loop
+    if (result == success) {
+        result = startWorkers(&server);
+    }
+    if (result == success) {
+        result = serve(&server);
+    }
+
+    // answers the clients did not take yet are dropped
+    while (server.connections) {
+        closeConnection(&server, server.connections);
+    }
+    stopWorkers(&server);
+    pthread_cond_destroy(&server.jobsReady);
+    pthread_mutex_destroy(&server.jobsLock);
+    if (server.listener >= 0) {
+        close(server.listener);
+    }
+    if (server.path) {
+        unlink(server.path);
+    }
+    if (server.signals >= 0) {
+        close(server.signals);
+    }
+    if (masked) {
+        sigprocmask(SIG_SETMASK, &previousMask, NULL);
+    }
+    if (server.standardOutput >= 0) {
+        close(server.standardOutput);
+    }
+    if (server.capture) {
+        fclose(server.capture);
+    }
+    if (server.epoll >= 0) {
+        close(server.epoll);
+    }
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef SERVER_H
+#define SERVER_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the Server module!
+ * This module serves text commands over a Unix domain socket, so many clients share one long lived program.
+ * A client sends one command per line and may send many lines without waiting for their answers (pipelining).
+ * Every line is answered, in order, with what its command printed followed by a line holding a single dot.
+ * One thread runs an epoll loop over all the connections: lines are run as soon as they are complete, and
+ * answers are kept per connection and written whenever the client can take them, so a slow client never
+ * stops the others. A client that leaves its answers unread stops being read until it catches up.
+ * While a command runs, its standard output (printf and direct writes alike) is captured as its answer.
+ * Lines the user marks as shared run on a pool of worker threads instead, many at once (one per connection
+ * at a time, so every client still gets its answers in order). A shared line must write its output through
+ * the standard renderer only: on a worker it renders to a text renderer of its own, which becomes its answer.
+ * The server stops on SIGINT or SIGTERM, after answering the lines it already ran.
+ * To serve, users must provide callback functions for:
+ * - Running a line
+ * - Periodic work between events
+ */
+
+
+/**
+ * Callbacks and context of a server
+ */
+typedef struct ServerHandlers_t {
+    void* context; // passed back as the first argument of every callback
+    // runs one line (without its newline), the line number counts the lines of its connection from 1
+    // a callback that does not return success stops the server, and its status is returned by runServer
+    status (*onLine)(void* context, char* line, int number);
+    void (*onIdle)(void* context); // called between events, at least once a second
+    // tells whether a line may run on a worker, the line must not be changed (may be NULL)
+    bool (*isShared)(void* context, const char* line);
+    int workers; // worker threads for the shared lines, 0 runs every line on the thread of the loop
+} ServerHandlers;
+
+
+
+/**
+ * Listens on a Unix domain socket and serves its clients until the server is stopped
+ * A socket file left at the path by an earlier server is replaced, the socket file is removed when the server stops
+ * @param path Path of the socket
+ * @param handlers The callbacks to run the lines with (onLine must be non-NULL, onIdle and isShared may be NULL)
+ * @return Operation status indicating success once stopped by a signal, failure if the socket can't be set up,
+ * memory problem, null pointer if received NULL in parameters, or the first non success status of onLine
+ */
+status runServer(const char* path, ServerHandlers* handlers);
+
+
+#endif //SERVER_H
@@ -0,0 +1,174 @@
+#include "Shards.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdatomic.h>
+
+#define SHARD_QUEUE_SIZE 8 // tasks a ring holds, a power of two so the positions may wrap around
+#define CACHE_LINE 64
+
+
+/* A task sent to a shard, a task with no function stops the shard's thread */
+typedef struct ShardTask_t {
+    status (*run)(void* context, int shard);
+    void* context;
+} ShardTask;
+
+
+/* A shard's ring of tasks and its thread, alone on its cache lines */
+typedef struct Shard_t {
+    _Alignas(CACHE_LINE) ShardTask tasks[SHARD_QUEUE_SIZE];
+    atomic_uint tail;  // next free place, only moved by the producer
+    _Alignas(CACHE_LINE) atomic_uint head; // next task to run, only moved by the shard's thread
+    sem_t ready;       // counts the tasks waiting in the ring
+    status result;     // of the last task, read once it is gathered
+    int index;
+    pthread_t thread;
+    struct ShardPool_s* pool;
+} Shard;
+
+
+struct ShardPool_s {
+    Shard* shards; // the first one runs on the caller's thread
+    int count;
+    int started;   // threads running, for shards 1 to started
+    pthread_mutex_t scattering; // held by the caller that scatters, the one producer of every ring
+    atomic_int pending; // shards still running the task scattered last
+    sem_t gathered;     // posted by the last of them
+};
+
+
+// waits on a semaphore until it is taken, a signal that interrupts the wait does not count
+static void waitSemaphore(sem_t* semaphore) {
+    while (sem_wait(semaphore) != 0 && errno == EINTR) {
+    }
+}
+
+
+// puts a task at the tail of a shard's ring, waiting for room if the ring is full
+static void sendToShard(Shard* shard, ShardTask task) {
+    unsigned int tail = atomic_load_explicit(&shard->tail, memory_order_relaxed);
+    while (tail - atomic_load_explicit(&shard->head, memory_order_acquire) == SHARD_QUEUE_SIZE) {
+        sched_yield();
+    }
+    shard->tasks[tail % SHARD_QUEUE_SIZE] = task;
+    atomic_store_explicit(&shard->tail, tail + 1, memory_order_release);
+    sem_post(&shard->ready);
+}
+
+
+static void* runShard(void* context) {
+    Shard* shard = (Shard*)context;
+    while (true) {
+        waitSemaphore(&shard->ready);
+        unsigned int head = atomic_load_explicit(&shard->head, memory_order_relaxed);
+        ShardTask task = shard->tasks[head % SHARD_QUEUE_SIZE];
+        atomic_store_explicit(&shard->head, head + 1, memory_order_release);
+        if (!task.run) {
+            return NULL;
+        }
+        shard->result = task.run(task.context, shard->index);
+        if (atomic_fetch_sub(&shard->pool->pending, 1) == 1) {
+            sem_post(&shard->pool->gathered);
+        }
+    }
+}
+
+
+
+// Interface Functions:
+
+ShardPool createShardPool(int shards) {
+    if (shards <= 0) {
+        return NULL;
+    }
+    ShardPool pool = (ShardPool)calloc(1, sizeof(struct ShardPool_s));
+    if (!pool) {
+        return NULL;
+    }
+    pool->shards = (Shard*)aligned_alloc(CACHE_LINE, shards * sizeof(Shard));
+    if (!pool->shards) {
+        free(pool);
+        return NULL;
+    }
+    memset(pool->shards, 0, shards * sizeof(Shard));
+    pool->count = shards;
+    pthread_mutex_init(&pool->scattering, NULL);
+    sem_init(&pool->gathered, 0, 0);
+    atomic_init(&pool->pending, 0);
+    for (int i = 0; i < shards; i++) {
+        Shard* shard = &pool->shards[i];
+        atomic_init(&shard->head, 0);
+        atomic_init(&shard->tail, 0);
+        sem_init(&shard->ready, 0, 0);
+        shard->index = i;
+        shard->pool = pool;
+    }
+    // the threads inherit a mask that blocks every signal, so signals are left to the threads of the program
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    bool started = true;
+    for (int i = 1; i < shards && started; i++) {
+        started = pthread_create(&pool->shards[i].thread, NULL, runShard, &pool->shards[i]) == 0;
+        if (started) {
+            pool->started = i;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (!started) {
+        destroyShardPool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+
+void destroyShardPool(ShardPool pool) {
+    if (!pool) {
+        return;
+    }
+    ShardTask stop = { NULL, NULL };
+    for (int i = 1; i <= pool->started; i++) {
+        sendToShard(&pool->shards[i], stop);
+    }
+    for (int i = 1; i <= pool->started; i++) {
+        pthread_join(pool->shards[i].thread, NULL);
+    }
+    for (int i = 0; i < pool->count; i++) {
+        sem_destroy(&pool->shards[i].ready);
+    }
+    sem_destroy(&pool->gathered);
+    pthread_mutex_destroy(&pool->scattering);
+    free(pool->shards);
+    free(pool);
+}
+
+
+int getShardCount(ShardPool pool) {
+    return pool ? pool->count : 0;
+}
+
+
+status runOnShards(ShardPool pool, status (*task)(void* context, int shard), void* context) {
+    if (!pool || !task) {
+        return null_pointer;
+    }
+    pthread_mutex_lock(&pool->scattering);
+    atomic_store(&pool->pending, pool->count - 1);
+    ShardTask scattered = { task, context };
+    for (int i = 1; i < pool->count; i++) {
+        sendToShard(&pool->shards[i], scattered);
+    }
+    status result = task(context, 0);
+    if (pool->count > 1) {
+        waitSemaphore(&pool->gathered);
+    }
+    for (int i = 1; i < pool->count && result == success; i++) {
+        result = pool->shards[i].result;
+    }
+    pthread_mutex_unlock(&pool->scattering);
+    return result;
+}
@@ -0,0 +1,64 @@
+#ifndef SHARDS_H
+#define SHARDS_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the Shards module!
+ * This module splits the work over a set of elements between threads that each take a part of them (a shard).
+ * The user picks the part of every shard, for example an even run of the positions of a list, so while a task
+ * runs every element is only visited by its shard's thread. A shard owns no elements: it only holds its part for
+ * the length of a task, so the elements stay wherever the user keeps them.
+ * A task is scattered to every shard at once and the caller waits until all of them are done (gather),
+ * then merges what each shard found. The first shard runs on the caller's thread, so one shard has no thread.
+ * Every shard thread takes its tasks from a ring of its own. Scatters take turns, so every ring has a single
+ * producer and a single consumer and needs no lock.
+ * The shard threads block every signal, so a program that waits for its signals is never stopped by a shard.
+ */
+
+
+/**
+ * The threads of a set of shards
+ */
+typedef struct ShardPool_s* ShardPool;
+
+
+
+/**
+ * Creates the shards and starts a thread for every shard but the first
+ * @param shards Number of shards (must be positive)
+ * @return The pool, or NULL if memory ran out or a thread could not be started
+ */
+ShardPool createShardPool(int shards);
+
+
+
+/**
+ * Stops the threads and frees the pool, no task may be running
+ * @param pool The pool (may be NULL)
+ */
+void destroyShardPool(ShardPool pool);
+
+
+
+/**
+ * @param pool The pool
+ * @return The number of shards
+ */
+int getShardCount(ShardPool pool);
+
+
+
+/**
+ * Runs a task on every shard at once and waits for all of them
+ * The task may only change the elements of its shard and its own part of the context
+ * @param pool The pool
+ * @param task Runs on one shard, given the context and the index of the shard
+ * @param context Passed to every run of the task
+ * @return Operation status indicating success, null pointer if received NULL in parameters,
+ * or the first non success status of the task by order of the shards
+ */
+status runOnShards(ShardPool pool, status (*task)(void* context, int shard), void* context);
+
+
+#endif //SHARDS_H
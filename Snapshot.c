@@ -0,0 +1,804 @@
+#include "Snapshot.h"
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_MAGIC "JBSNAP\r\n" // 8 bytes, the line end catches files mangled by a text mode transfer
+#define SNAPSHOT_MAGIC_LENGTH 8
+#define SNAPSHOT_VERSION 2
+#define INITIAL_INDEX_SIZE 64 // slots of a new index, always a power of two
+#define INITIAL_BUFFER_SIZE 4096
+
+
+/*
+ * File layout, in the byte order of the machine that wrote it:
+ * [header][planet records][origin records][Jerry records][characteristic records][name records]
+ * [ID index][name index][postings][string pool]
+ * The records have fixed sizes that are multiples of 8 and come first, so every section stays aligned.
+ * The indexes are open addressing tables of record number + 1 (0 marks an empty slot), hashed with hashString.
+ * The postings hold the Jerry record numbers of every characteristic name, in file order.
+ */
+typedef struct SnapshotHeader_t {
+    char magic[SNAPSHOT_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t planets;
+    uint32_t origins;
+    uint32_t jerries;
+    uint32_t characteristics;     // also the number of postings
+    uint32_t characteristicNames;
+    uint32_t idIndexSize;         // slots, a power of two
+    uint32_t nameIndexSize;       // slots, a power of two
+    uint64_t stringBytes;
+} SnapshotHeader;
+
+typedef struct PlanetRecord_t {
+    uint32_t name; // offset in the string pool
+    uint32_t unused;
+    double x;
+    double y;
+    double z;
+} PlanetRecord;
+
+typedef struct OriginRecord_t {
+    uint32_t planet;    // index of the planet record
+    uint32_t dimension; // offset in the string pool
+} OriginRecord;
+
+typedef struct JerryRecord_t {
+    uint32_t id;                  // offset in the string pool
+    uint32_t origin;              // index of the origin record
+    int32_t happiness;
+    uint32_t characteristics;     // number of characteristic records that belong to this Jerry
+    uint32_t firstCharacteristic; // index of the first of them
+    uint32_t unused;
+} JerryRecord;
+
+typedef struct CharacteristicRecord_t {
+    uint32_t name; // offset in the string pool
+    uint32_t unused;
+    double value;
+} CharacteristicRecord;
+
+typedef struct NameRecord_t {
+    uint32_t name;     // offset in the string pool
+    uint32_t postings; // number of Jerries with this characteristic
+    uint32_t first;    // index of the first of their postings
+    uint32_t unused;
+} NameRecord;
+
+
+/* Growable array of bytes, a section of the snapshot while it is written */
+typedef struct ByteBuffer_t {
+    char* data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+
+/* Open addressing index from a non zero key (an object address or a string offset + 1) to a record number */
+typedef struct KeyIndex_t {
+    uintptr_t* keys; // 0 marks an empty slot
+    uint32_t* values;
+    size_t size;     // number of slots, a power of two
+    size_t count;
+} KeyIndex;
+
+
+/* String pool that stores every interned string once */
+typedef struct StringPool_t {
+    ByteBuffer bytes;
+    uint32_t* slots; // offset + 1 of an interned string, 0 marks an empty slot
+    size_t size;     // number of slots, a power of two
+    size_t count;
+} StringPool;
+
+
+/* Everything that is written to the snapshot, built in memory first so the file is written in a few large writes */
+typedef struct SnapshotWriter_t {
+    ByteBuffer planets;
+    ByteBuffer origins;
+    ByteBuffer jerries;
+    ByteBuffer characteristics;
+    ByteBuffer names;
+    uint32_t* idIndex;
+    uint32_t* nameIndex;
+    uint32_t* postings;
+    uint32_t idIndexSize;
+    uint32_t nameIndexSize;
+    StringPool strings;
+    KeyIndex planetIndex;  // Planet* to planet record
+    KeyIndex originIndex;  // Origin* to origin record
+    KeyIndex nameNumbers;  // offset of a characteristic name + 1 to its name record
+} SnapshotWriter;
+
+
+/* A snapshot mapped into memory, the records are read in place */
+struct SnapshotImage_s {
+    char* data;
+    size_t length;
+    SnapshotHeader* header;
+    PlanetRecord* planetRecords;
+    OriginRecord* originRecords;
+    JerryRecord* jerryRecords;
+    CharacteristicRecord* characteristicRecords;
+    NameRecord* nameRecords;
+    uint32_t* idIndex;
+    uint32_t* nameIndex;
+    uint32_t* postings;
+    char* pool;
+    Planet** planets; // the planet built from every planet record, owned by the handlers
+    SnapshotHandlers handlers;
+};
+
+
+
+// Buffer helper functions:
+
+static status appendBytes(ByteBuffer* buffer, const void* data, size_t length) {
+    if (buffer->length + length > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : INITIAL_BUFFER_SIZE;
+        while (capacity < buffer->length + length) {
+            capacity *= 2;
+        }
+        char* grown = (char*)realloc(buffer->data, capacity);
+        if (!grown) {
+            return memory_problem;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    return success;
+}
+
+
+
+// Index helper functions:
+
+static size_t hashKey(uintptr_t key) {
+    // multiplicative hashing, the low bits of an address are always the same
+    return (size_t)((uint64_t)key * 0x9E3779B97F4A7C15ULL >> 17);
+}
+
+static status createKeyIndex(KeyIndex* index) {
+    index->keys = (uintptr_t*)calloc(INITIAL_INDEX_SIZE, sizeof(uintptr_t));
+    index->values = (uint32_t*)malloc(INITIAL_INDEX_SIZE * sizeof(uint32_t));
+    index->size = INITIAL_INDEX_SIZE;
+    index->count = 0;
+    return (index->keys && index->values) ? success : memory_problem;
+}
+
+static void destroyKeyIndex(KeyIndex* index) {
+    free(index->keys);
+    free(index->values);
+}
+
+static bool findKey(KeyIndex* index, uintptr_t key, uint32_t* value) {
+    size_t mask = index->size - 1;
+    for (size_t slot = hashKey(key) & mask; index->keys[slot] != 0; slot = (slot + 1) & mask) {
+        if (index->keys[slot] == key) {
+            *value = index->values[slot];
+            return true;
+        }
+    }
+    return false;
+}
+
+// adds a key that is not in the index yet, the index is kept at most half full
+static status addKey(KeyIndex* index, uintptr_t key, uint32_t value) {
+    if ((index->count + 1) * 2 > index->size) {
+        KeyIndex grown = { NULL, NULL, index->size * 2, 0 };
+        grown.keys = (uintptr_t*)calloc(grown.size, sizeof(uintptr_t));
+        grown.values = (uint32_t*)malloc(grown.size * sizeof(uint32_t));
+        if (!grown.keys || !grown.values) {
+            destroyKeyIndex(&grown);
+            return memory_problem;
+        }
+        for (size_t i = 0; i < index->size; i++) {
+            if (index->keys[i] != 0) {
+                addKey(&grown, index->keys[i], index->values[i]);
+            }
+        }
+        destroyKeyIndex(index);
+        *index = grown;
+    }
+    size_t mask = index->size - 1;
+    size_t slot = hashKey(key) & mask;
+    while (index->keys[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    index->keys[slot] = key;
+    index->values[slot] = value;
+    index->count++;
+    return success;
+}
+
+
+
+// String pool helper functions:
+
+static size_t hashString(const char* string) {
+    // djb2, like the daycare's tables
+    size_t hash = 5381;
+    for (; *string; string++) {
+        hash = hash * 33 + (unsigned char)*string;
+    }
+    return hash;
+}
+
+// appends a string without interning it, used for the IDs that are unique anyway
+static status appendString(StringPool* pool, const char* string, uint32_t* offset) {
+    size_t length = strlen(string) + 1;
+    if (pool->bytes.length + length > UINT32_MAX) {
+        return failure;
+    }
+    *offset = (uint32_t)pool->bytes.length;
+    return appendBytes(&pool->bytes, string, length);
+}
+
+static status growStringPool(StringPool* pool) {
+    size_t size = pool->size * 2;
+    uint32_t* slots = (uint32_t*)calloc(size, sizeof(uint32_t));
+    if (!slots) {
+        return memory_problem;
+    }
+    for (size_t i = 0; i < pool->size; i++) {
+        if (pool->slots[i] == 0) continue;
+        size_t slot = hashString(pool->bytes.data + pool->slots[i] - 1) & (size - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+        slots[slot] = pool->slots[i];
+    }
+    free(pool->slots);
+    pool->slots = slots;
+    pool->size = size;
+    return success;
+}
+
+// returns the offset of a string in the pool, adding it the first time it is seen
+static status internString(StringPool* pool, const char* string, uint32_t* offset) {
+    if ((pool->count + 1) * 2 > pool->size && growStringPool(pool) != success) {
+        return memory_problem;
+    }
+    size_t mask = pool->size - 1;
+    size_t slot = hashString(string) & mask;
+    while (pool->slots[slot] != 0) {
+        if (strcmp(pool->bytes.data + pool->slots[slot] - 1, string) == 0) {
+            *offset = pool->slots[slot] - 1;
+            return success;
+        }
+        slot = (slot + 1) & mask;
+    }
+    status state = appendString(pool, string, offset);
+    if (state != success) {
+        return state;
+    }
+    pool->slots[slot] = *offset + 1;
+    pool->count++;
+    return success;
+}
+
+
+
+// Writer helper functions:
+
+static status createSnapshotWriter(SnapshotWriter* writer) {
+    memset(writer, 0, sizeof(SnapshotWriter));
+    writer->strings.slots = (uint32_t*)calloc(INITIAL_INDEX_SIZE, sizeof(uint32_t));
+    writer->strings.size = INITIAL_INDEX_SIZE;
+    if (!writer->strings.slots || createKeyIndex(&writer->planetIndex) != success
+        || createKeyIndex(&writer->originIndex) != success || createKeyIndex(&writer->nameNumbers) != success) {
+        return memory_problem;
+    }
+    return success;
+}
+
+static void destroySnapshotWriter(SnapshotWriter* writer) {
+    free(writer->planets.data);
+    free(writer->origins.data);
+    free(writer->jerries.data);
+    free(writer->characteristics.data);
+    free(writer->names.data);
+    free(writer->idIndex);
+    free(writer->nameIndex);
+    free(writer->postings);
+    free(writer->strings.bytes.data);
+    free(writer->strings.slots);
+    destroyKeyIndex(&writer->planetIndex);
+    destroyKeyIndex(&writer->originIndex);
+    destroyKeyIndex(&writer->nameNumbers);
+}
+
+static status writePlanet(SnapshotWriter* writer, Planet* planet) {
+    PlanetRecord record = { 0, 0, planet->x, planet->y, planet->z };
+    status state = internString(&writer->strings, planet->name, &record.name);
+    if (state != success) {
+        return state;
+    }
+    state = addKey(&writer->planetIndex, (uintptr_t)planet, (uint32_t)(writer->planets.length / sizeof(PlanetRecord)));
+    if (state != success) {
+        return state;
+    }
+    return appendBytes(&writer->planets, &record, sizeof(record));
+}
+
+// returns the record number of a Jerry's origin, writing the origin the first time it is seen
+static status writeOrigin(SnapshotWriter* writer, Origin* origin, uint32_t* number) {
+    if (findKey(&writer->originIndex, (uintptr_t)origin, number)) {
+        return success;
+    }
+    OriginRecord record;
+    if (!findKey(&writer->planetIndex, (uintptr_t)origin->planet, &record.planet)) {
+        return failure; // the planet was not saved
+    }
+    status state = internString(&writer->strings, origin->dimension, &record.dimension);
+    if (state != success) {
+        return state;
+    }
+    *number = (uint32_t)(writer->origins.length / sizeof(OriginRecord));
+    state = addKey(&writer->originIndex, (uintptr_t)origin, *number);
+    if (state != success) {
+        return state;
+    }
+    return appendBytes(&writer->origins, &record, sizeof(record));
+}
+
+// returns the name record of a characteristic name, writing it the first time it is seen
+static status writeName(SnapshotWriter* writer, uint32_t name, uint32_t* number) {
+    if (findKey(&writer->nameNumbers, (uintptr_t)name + 1, number)) {
+        return success;
+    }
+    NameRecord record = { name, 0, 0, 0 };
+    *number = (uint32_t)(writer->names.length / sizeof(NameRecord));
+    status state = addKey(&writer->nameNumbers, (uintptr_t)name + 1, *number);
+    if (state != success) {
+        return state;
+    }
+    return appendBytes(&writer->names, &record, sizeof(record));
+}
+
+static status writeJerry(SnapshotWriter* writer, Jerry* jerry) {
+    JerryRecord record = { 0, 0, jerry->happiness, (uint32_t)jerry->num_characteristics,
+                           (uint32_t)(writer->characteristics.length / sizeof(CharacteristicRecord)), 0 };
+    status state = writeOrigin(writer, jerry->origin, &record.origin);
+    if (state == success) {
+        state = appendString(&writer->strings, jerry->id, &record.id);
+    }
+    if (state == success) {
+        state = appendBytes(&writer->jerries, &record, sizeof(record));
+    }
+
+    for (int i = 0; i < jerry->num_characteristics && state == success; i++) {
+        CharacteristicRecord characteristic = { 0, 0, jerry->characteristics[i]->value };
+        uint32_t number;
+        state = internString(&writer->strings, jerry->characteristics[i]->name, &characteristic.name);
+        if (state == success) {
+            state = writeName(writer, characteristic.name, &number);
+        }
+        if (state == success) {
+            ((NameRecord*)writer->names.data)[number].postings++;
+            state = appendBytes(&writer->characteristics, &characteristic, sizeof(characteristic));
+        }
+    }
+    return state;
+}
+
+// the smallest power of two with at least two slots per entry, so the probes stay short
+static uint32_t getIndexSize(uint32_t entries) {
+    uint32_t size = 2;
+    while (size < entries * 2) {
+        size *= 2;
+    }
+    return size;
+}
+
+static void addToIndex(uint32_t* index, uint32_t size, const char* key, uint32_t record) {
+    size_t slot = hashString(key) & (size - 1);
+    while (index[slot] != 0) {
+        slot = (slot + 1) & (size - 1);
+    }
+    index[slot] = record + 1;
+}
+
+// builds the ID index, the name index and the postings once every Jerry is written
+static status writeIndexes(SnapshotWriter* writer) {
+    uint32_t jerries = (uint32_t)(writer->jerries.length / sizeof(JerryRecord));
+    uint32_t names = (uint32_t)(writer->names.length / sizeof(NameRecord));
+    uint32_t characteristics = (uint32_t)(writer->characteristics.length / sizeof(CharacteristicRecord));
+    if (jerries > UINT32_MAX / 2 || names > UINT32_MAX / 2) {
+        return failure;
+    }
+    writer->idIndexSize = getIndexSize(jerries);
+    writer->nameIndexSize = getIndexSize(names);
+    writer->idIndex = (uint32_t*)calloc(writer->idIndexSize, sizeof(uint32_t));
+    writer->nameIndex = (uint32_t*)calloc(writer->nameIndexSize, sizeof(uint32_t));
+    writer->postings = (uint32_t*)malloc((characteristics + 1) * sizeof(uint32_t));
+    uint32_t* next = (uint32_t*)malloc((names + 1) * sizeof(uint32_t)); // next free posting of every name
+    if (!writer->idIndex || !writer->nameIndex || !writer->postings || !next) {
+        free(next);
+        return memory_problem;
+    }
+
+    char* pool = writer->strings.bytes.data;
+    NameRecord* nameRecords = (NameRecord*)writer->names.data;
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < names; i++) {
+        nameRecords[i].first = first;
+        next[i] = first;
+        first += nameRecords[i].postings;
+        addToIndex(writer->nameIndex, writer->nameIndexSize, pool + nameRecords[i].name, i);
+    }
+
+    JerryRecord* jerryRecords = (JerryRecord*)writer->jerries.data;
+    CharacteristicRecord* characteristicRecords = (CharacteristicRecord*)writer->characteristics.data;
+    for (uint32_t i = 0; i < jerries; i++) {
+        addToIndex(writer->idIndex, writer->idIndexSize, pool + jerryRecords[i].id, i);
+        for (uint32_t j = 0; j < jerryRecords[i].characteristics; j++) {
+            uint32_t number;
+            if (!findKey(&writer->nameNumbers, (uintptr_t)characteristicRecords[jerryRecords[i].firstCharacteristic + j].name + 1, &number)) {
+                free(next);
+                return failure;
+            }
+            writer->postings[next[number]++] = i;
+        }
+    }
+    free(next);
+    return success;
+}
+
+static bool writeAll(int fd, const void* data, size_t length) {
+    const char* current = (const char*)data;
+    while (length > 0) {
+        ssize_t written = write(fd, current, length);
+        if (written <= 0) {
+            return false;
+        }
+        current += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// writes the sections to a temporary file, flushes it to the disk and renames it over the snapshot
+static status writeSnapshotFile(const char* filename, SnapshotWriter* writer, size_t* bytesWritten) {
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH);
+    header.version = SNAPSHOT_VERSION;
+    header.planets = (uint32_t)(writer->planets.length / sizeof(PlanetRecord));
+    header.origins = (uint32_t)(writer->origins.length / sizeof(OriginRecord));
+    header.jerries = (uint32_t)(writer->jerries.length / sizeof(JerryRecord));
+    header.characteristics = (uint32_t)(writer->characteristics.length / sizeof(CharacteristicRecord));
+    header.characteristicNames = (uint32_t)(writer->names.length / sizeof(NameRecord));
+    header.idIndexSize = writer->idIndexSize;
+    header.nameIndexSize = writer->nameIndexSize;
+    header.stringBytes = writer->strings.bytes.length;
+
+    size_t length = strlen(filename);
+    char* temporary = (char*)malloc(length + sizeof(".tmp"));
+    if (!temporary) {
+        return memory_problem;
+    }
+    memcpy(temporary, filename, length);
+    memcpy(temporary + length, ".tmp", sizeof(".tmp"));
+
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(temporary);
+        return failure;
+    }
+    const void* sections[] = { writer->planets.data, writer->origins.data, writer->jerries.data,
+                               writer->characteristics.data, writer->names.data, writer->idIndex,
+                               writer->nameIndex, writer->postings, writer->strings.bytes.data };
+    size_t lengths[] = { writer->planets.length, writer->origins.length, writer->jerries.length,
+                         writer->characteristics.length, writer->names.length, header.idIndexSize * sizeof(uint32_t),
+                         header.nameIndexSize * sizeof(uint32_t), header.characteristics * sizeof(uint32_t),
+                         writer->strings.bytes.length };
+    bool written = writeAll(fd, &header, sizeof(header));
+    size_t total = sizeof(header);
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]) && written; i++) {
+        written = writeAll(fd, sections[i], lengths[i]);
+        total += lengths[i];
+    }
+    written = written && fsync(fd) == 0;
+    written = (close(fd) == 0) && written;
+
+    if (!written || rename(temporary, filename) != 0) {
+        unlink(temporary);
+        free(temporary);
+        return failure;
+    }
+    free(temporary);
+    if (bytesWritten) {
+        *bytesWritten = total;
+    }
+    return success;
+}
+
+
+
+// Reader helper functions:
+
+static bool isValidHeader(const SnapshotHeader* header) {
+    return memcmp(header->magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH) == 0 && header->version == SNAPSHOT_VERSION
+           && header->planets <= INT32_MAX && header->origins <= INT32_MAX && header->jerries <= INT32_MAX
+           && header->characteristics <= INT32_MAX && header->characteristicNames <= INT32_MAX
+           && header->idIndexSize > 0 && (header->idIndexSize & (header->idIndexSize - 1)) == 0
+           && header->nameIndexSize > 0 && (header->nameIndexSize & (header->nameIndexSize - 1)) == 0
+           && header->stringBytes <= UINT32_MAX;
+}
+
+// the size a snapshot must have according to its header
+static uint64_t getSnapshotLength(const SnapshotHeader* header) {
+    return sizeof(SnapshotHeader) + (uint64_t)header->planets * sizeof(PlanetRecord)
+           + (uint64_t)header->origins * sizeof(OriginRecord) + (uint64_t)header->jerries * sizeof(JerryRecord)
+           + (uint64_t)header->characteristics * (sizeof(CharacteristicRecord) + sizeof(uint32_t))
+           + (uint64_t)header->characteristicNames * sizeof(NameRecord)
+           + ((uint64_t)header->idIndexSize + header->nameIndexSize) * sizeof(uint32_t) + header->stringBytes;
+}
+
+// turns a string offset back into a pointer, NULL if it points outside the pool
+static char* getPoolString(SnapshotImage image, uint32_t offset) {
+    return offset < image->header->stringBytes ? image->pool + offset : NULL;
+}
+
+// finds the record of a key in one of the indexes, -1 if it is not there
+// every probed record is checked before it is used, so a corrupted index can only miss
+static int findInIndex(SnapshotImage image, const uint32_t* index, uint32_t size, uint32_t records, const char* key,
+                       uint32_t (*getKey)(SnapshotImage image, uint32_t record)) {
+    size_t slot = hashString(key) & (size - 1);
+    for (uint32_t probes = 0; probes < size && index[slot] != 0; probes++) {
+        uint32_t record = index[slot] - 1;
+        if (record < records) {
+            char* stored = getPoolString(image, getKey(image, record));
+            if (stored && strcmp(stored, key) == 0) {
+                return (int)record;
+            }
+        }
+        slot = (slot + 1) & (size - 1);
+    }
+    return -1;
+}
+
+static uint32_t getJerryKey(SnapshotImage image, uint32_t record) {
+    return image->jerryRecords[record].id;
+}
+
+static uint32_t getNameKey(SnapshotImage image, uint32_t record) {
+    return image->nameRecords[record].name;
+}
+
+// builds the planets of the image and hands them to the handlers
+static status loadImagePlanets(SnapshotImage image) {
+    for (uint32_t i = 0; i < image->header->planets; i++) {
+        PlanetRecord* record = &image->planetRecords[i];
+        char* name = getPoolString(image, record->name);
+        image->planets[i] = name ? createPlanet(name, record->x, record->y, record->z) : NULL;
+        if (!image->planets[i]) {
+            return failure;
+        }
+        status state = image->handlers.onPlanet(image->handlers.context, image->planets[i]);
+        if (state != success) {
+            return state;
+        }
+    }
+    return success;
+}
+
+
+
+// Interface Functions:
+
+status readSnapshotCounts(const char* filename, SnapshotCounts* counts) {
+    if (!filename || !counts) {
+        return null_pointer;
+    }
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return failure;
+    }
+    SnapshotHeader header;
+    ssize_t got = read(fd, &header, sizeof(header));
+    close(fd);
+    if (got != (ssize_t)sizeof(header) || !isValidHeader(&header)) {
+        return failure;
+    }
+    counts->planets = (int)header.planets;
+    counts->origins = (int)header.origins;
+    counts->jerries = (int)header.jerries;
+    counts->characteristics = (int)header.characteristics;
+    counts->characteristicNames = (int)header.characteristicNames;
+    return success;
+}
+
+
+status saveSnapshot(const char* filename, LinkedList planets, LinkedList jerries, size_t* bytesWritten) {
+    if (!filename || !planets || !jerries) {
+        return null_pointer;
+    }
+    SnapshotWriter writer;
+    status state = createSnapshotWriter(&writer);
+
+    // reading the lists in order is linear, getDataByIndex continues from the last position
+    int numPlanets = getLengthList(planets);
+    for (int i = 1; i <= numPlanets && state == success; i++) {
+        Planet* planet = getDataByIndex(planets, i);
+        state = planet ? writePlanet(&writer, planet) : failure;
+    }
+    int numJerries = getLengthList(jerries);
+    for (int i = 1; i <= numJerries && state == success; i++) {
+        Jerry* jerry = getDataByIndex(jerries, i);
+        state = jerry ? writeJerry(&writer, jerry) : failure;
+    }
+
+    if (state == success) {
+        state = writeIndexes(&writer);
+    }
+    if (state == success) {
+        state = writeSnapshotFile(filename, &writer, bytesWritten);
+    }
+    destroySnapshotWriter(&writer);
+    return state;
+}
+
+
+SnapshotImage openSnapshotImage(const char* filename, SnapshotHandlers* handlers) {
+    if (!filename || !handlers || !handlers->onPlanet || !handlers->getOrigin) {
+        return NULL;
+    }
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    char* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(SnapshotHeader)) {
+        // read only and private, the pages are only read from the file when a record on them is used
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    SnapshotHeader* header = (SnapshotHeader*)data;
+    if (!isValidHeader(header) || getSnapshotLength(header) != (uint64_t)info.st_size
+        || (header->stringBytes > 0 && data[info.st_size - 1] != '\0')) { // every string must end inside the pool
+        munmap(data, (size_t)info.st_size);
+        return NULL;
+    }
+
+    SnapshotImage image = (SnapshotImage)calloc(1, sizeof(struct SnapshotImage_s));
+    Planet** planets = (Planet**)malloc((header->planets + 1) * sizeof(Planet*));
+    if (!image || !planets) {
+        free(image);
+        free(planets);
+        munmap(data, (size_t)info.st_size);
+        return NULL;
+    }
+    image->data = data;
+    image->length = (size_t)info.st_size;
+    image->header = header;
+    image->planetRecords = (PlanetRecord*)(header + 1);
+    image->originRecords = (OriginRecord*)(image->planetRecords + header->planets);
+    image->jerryRecords = (JerryRecord*)(image->originRecords + header->origins);
+    image->characteristicRecords = (CharacteristicRecord*)(image->jerryRecords + header->jerries);
+    image->nameRecords = (NameRecord*)(image->characteristicRecords + header->characteristics);
+    image->idIndex = (uint32_t*)(image->nameRecords + header->characteristicNames);
+    image->nameIndex = image->idIndex + header->idIndexSize;
+    image->postings = image->nameIndex + header->nameIndexSize;
+    image->pool = (char*)(image->postings + header->characteristics);
+    image->planets = planets;
+    image->handlers = *handlers;
+
+    if (loadImagePlanets(image) != success) {
+        closeSnapshotImage(image);
+        return NULL;
+    }
+    return image;
+}
+
+
+void closeSnapshotImage(SnapshotImage image) {
+    if (!image) {
+        return;
+    }
+    munmap(image->data, image->length);
+    free(image->planets);
+    free(image);
+}
+
+
+int getSnapshotJerryCount(SnapshotImage image) {
+    return image ? (int)image->header->jerries : 0;
+}
+
+
+int findSnapshotJerry(SnapshotImage image, const char* id) {
+    if (!image || !id) {
+        return -1;
+    }
+    return findInIndex(image, image->idIndex, image->header->idIndexSize, image->header->jerries, id, getJerryKey);
+}
+
+
+int findSnapshotCharacteristic(SnapshotImage image, const char* name, const uint32_t** records) {
+    if (!image || !name || !records) {
+        return 0;
+    }
+    int number = findInIndex(image, image->nameIndex, image->header->nameIndexSize, image->header->characteristicNames,
+                             name, getNameKey);
+    if (number < 0) {
+        return 0;
+    }
+    NameRecord* record = &image->nameRecords[number];
+    if (record->first > image->header->characteristics || record->postings > image->header->characteristics - record->first) {
+        return 0;
+    }
+    *records = image->postings + record->first;
+    return (int)record->postings;
+}
+
+
+Jerry* buildSnapshotJerry(SnapshotImage image, int record) {
+    if (!image || record < 0 || (uint32_t)record >= image->header->jerries) {
+        return NULL;
+    }
+    JerryRecord* jerryRecord = &image->jerryRecords[record];
+    if (jerryRecord->origin >= image->header->origins || jerryRecord->firstCharacteristic > image->header->characteristics
+        || jerryRecord->characteristics > image->header->characteristics - jerryRecord->firstCharacteristic) {
+        return NULL;
+    }
+    OriginRecord* originRecord = &image->originRecords[jerryRecord->origin];
+    char* dimension = getPoolString(image, originRecord->dimension);
+    char* id = getPoolString(image, jerryRecord->id);
+    if (!dimension || !id || originRecord->planet >= image->header->planets) {
+        return NULL;
+    }
+
+    Origin* origin = image->handlers.getOrigin(image->handlers.context, image->planets[originRecord->planet], dimension);
+    Jerry* jerry = origin ? createJerryWithOrigin(id, jerryRecord->happiness, origin) : NULL;
+    if (!jerry || jerryRecord->characteristics == 0) {
+        return jerry;
+    }
+
+    // all of the characteristics go into one array of their final size
+    jerry->characteristics = (PhysicalCharacteristic**)malloc(jerryRecord->characteristics * sizeof(PhysicalCharacteristic*));
+    if (!jerry->characteristics) {
+        destroyJerry(jerry);
+        return NULL;
+    }
+    CharacteristicRecord* characteristics = image->characteristicRecords + jerryRecord->firstCharacteristic;
+    for (uint32_t i = 0; i < jerryRecord->characteristics; i++) {
+        char* name = getPoolString(image, characteristics[i].name);
+        PhysicalCharacteristic* characteristic = name ? createPhysicalCharacteristic(name, characteristics[i].value) : NULL;
+        if (!characteristic) {
+            destroyJerry(jerry);
+            return NULL;
+        }
+        jerry->characteristics[jerry->num_characteristics++] = characteristic;
+    }
+    return jerry;
+}
+
+
+status loadSnapshot(const char* filename, SnapshotHandlers* handlers) {
+    if (!filename || !handlers || !handlers->onPlanet || !handlers->getOrigin || !handlers->onJerry) {
+        return null_pointer;
+    }
+    SnapshotImage image = openSnapshotImage(filename, handlers);
+    if (!image) {
+        return failure;
+    }
+    madvise(image->data, image->length, MADV_SEQUENTIAL);
+
+    status state = success;
+    for (int i = 0; i < getSnapshotJerryCount(image) && state == success; i++) {
+        Jerry* jerry = buildSnapshotJerry(image, i);
+        state = jerry ? handlers->onJerry(handlers->context, jerry) : failure;
+    }
+    closeSnapshotImage(image);
+    return state;
+}
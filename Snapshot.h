@@ -0,0 +1,157 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include "Jerry.h"
+#include "LinkedList.h"
+#include <stdint.h>
+
+
+/**
+ * Welcome to the Snapshot module!
+ * This module saves the planets and Jerries of a daycare to a compact binary file, and loads them back
+ * without any text parsing. The file holds fixed size records that refer to each other by index:
+ * - planets (name and coordinates)
+ * - origins (planet index and dimension), one record per shared origin
+ * - Jerries (ID, origin index, happiness and their characteristic records)
+ * - characteristics (name and value), the characteristics of every Jerry follow each other
+ * - characteristic names, each with the Jerries that have it
+ * followed by an index of the IDs, an index of the characteristic names, and a pool of interned strings,
+ * every name, dimension and ID is stored once and referred to by offset.
+ * A snapshot is opened by mapping it into memory, which costs the same for any size: only the planets are built,
+ * and the pages of a record are read from the disk the first time it is used.
+ * Any Jerry can then be built from its record, found by ID or by characteristic through the stored indexes,
+ * so a daycare can be used before (or without) loading all of its Jerries.
+ * To load a snapshot, users must provide callback functions that take:
+ * - A planet
+ * - A planet and a dimension, and return the shared origin of the Jerries from there
+ * - A Jerry, with its characteristics already attached (only for loading all of them)
+ */
+
+
+/**
+ * Number of records in a snapshot, used to size the structures before it is loaded
+ */
+typedef struct SnapshotCounts_t {
+    int planets;
+    int origins;
+    int jerries;
+    int characteristics;
+    int characteristicNames; // distinct characteristic names
+} SnapshotCounts;
+
+
+/**
+ * Callbacks and context for loading a snapshot.
+ * onPlanet and onJerry take ownership of the object they are given, whether they succeed or not,
+ * and a status other than success stops the loading.
+ * getOrigin returns an origin the caller keeps a reference to (the Jerries take their own), or NULL on failure.
+ */
+typedef struct SnapshotHandlers_t {
+    void* context; // passed back as the first argument of every callback
+    status (*onPlanet)(void* context, Planet* planet);
+    Origin* (*getOrigin)(void* context, Planet* planet, char* dimension);
+    status (*onJerry)(void* context, Jerry* jerry);
+} SnapshotHandlers;
+
+
+/**
+ * A snapshot mapped into memory
+ */
+typedef struct SnapshotImage_s* SnapshotImage;
+
+
+
+/**
+ * Reads the record counts of a snapshot without loading it
+ * @param filename Path of the snapshot
+ * @param counts Filled with the counts of the snapshot
+ * @return Operation status indicating success, failure if the file can't be read or is not a snapshot,
+ * null pointer if received NULL in parameters
+ */
+status readSnapshotCounts(const char* filename, SnapshotCounts* counts);
+
+
+
+/**
+ * Saves planets and Jerries to a snapshot
+ * The snapshot is written to a temporary file next to the target and renamed over it once complete,
+ * so an existing snapshot is never left half written
+ * @param filename Path of the snapshot
+ * @param planets List of Planet*, in the order they are loaded back
+ * @param jerries List of Jerry*, in the order they are loaded back, every Jerry's planet must be in planets
+ * @param bytesWritten Set to the size of the snapshot (may be NULL)
+ * @return Operation status indicating success, failure if the file can't be written or a Jerry's planet is unknown,
+ * memory problem, null pointer if received NULL in parameters
+ */
+status saveSnapshot(const char* filename, LinkedList planets, LinkedList jerries, size_t* bytesWritten);
+
+
+
+/**
+ * Opens a snapshot by mapping it into memory, and hands its planets to the handlers in the order they were saved
+ * @param filename Path of the snapshot
+ * @param handlers The callbacks to call (onPlanet and getOrigin must be non-NULL), copied into the image
+ * @return The image, or NULL if the file can't be mapped, is corrupted, or a planet could not be loaded
+ */
+SnapshotImage openSnapshotImage(const char* filename, SnapshotHandlers* handlers);
+
+
+
+/**
+ * Unmaps a snapshot, the objects built from it stay valid
+ * @param image The image to close (may be NULL)
+ */
+void closeSnapshotImage(SnapshotImage image);
+
+
+
+/**
+ * @param image The image
+ * @return The number of Jerry records in the image, 0 if image is NULL
+ */
+int getSnapshotJerryCount(SnapshotImage image);
+
+
+
+/**
+ * Finds the record of a Jerry through the stored ID index
+ * @param image The image
+ * @param id The ID to look for
+ * @return The record number of the Jerry, or -1 if it is not in the snapshot
+ */
+int findSnapshotJerry(SnapshotImage image, const char* id);
+
+
+
+/**
+ * Finds the Jerries that have a characteristic through the stored name index
+ * @param image The image
+ * @param name The characteristic name to look for
+ * @param records Set to the record numbers of the Jerries, in the order they were saved (points into the image)
+ * @return The number of records, 0 if no Jerry in the snapshot has the characteristic
+ */
+int findSnapshotCharacteristic(SnapshotImage image, const char* name, const uint32_t** records);
+
+
+
+/**
+ * Builds a Jerry from its record, with its characteristics attached and the origin given by getOrigin
+ * @param image The image
+ * @param record The record number of the Jerry
+ * @return The Jerry, owned by the caller, or NULL if the record is out of range or corrupted or memory ran out
+ */
+Jerry* buildSnapshotJerry(SnapshotImage image, int record);
+
+
+
+/**
+ * Loads a whole snapshot and hands every object to the handlers, planets first, then Jerries,
+ * each in the order they were saved
+ * @param filename Path of the snapshot
+ * @param handlers The callbacks to call (all must be non-NULL)
+ * @return Operation status indicating success, failure if the file can't be read or is corrupted,
+ * memory problem, null pointer if received NULL in parameters, or the first non success status of a callback
+ */
+status loadSnapshot(const char* filename, SnapshotHandlers* handlers);
+
+
+#endif //SNAPSHOT_H
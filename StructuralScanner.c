@@ -0,0 +1,104 @@
+#include "StructuralScanner.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define STRUCTURAL_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+
+static bool isStructural(char c) {
+    return c == '\n' || c == ',' || c == ':';
+}
+
+
+// appends the offset of every set bit of a block mask, base is the offset of the block's first byte
+static size_t appendMaskOffsets(unsigned long long mask, size_t base, size_t* offsets) {
+    size_t count = 0;
+    while (mask) {
+        offsets[count++] = base + (size_t)__builtin_ctzll(mask);
+        mask &= mask - 1; // clear the lowest set bit
+    }
+    return count;
+}
+
+
+size_t scanStructuralsScalar(const char* data, size_t start, size_t end, size_t* offsets) {
+    size_t count = 0;
+    for (size_t i = start; i < end; i++) {
+        if (isStructural(data[i])) {
+            offsets[count++] = i;
+        }
+    }
+    return count;
+}
+
+
+#ifdef STRUCTURAL_SCANNER_X86
+
+// SSE2 is part of x86-64, so this scanner is always available there
+static size_t scanStructuralsSse2(const char* data, size_t start, size_t end, size_t* offsets) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i colon = _mm_set1_epi8(':');
+
+    size_t count = 0;
+    size_t i = start;
+    for (; i + 16 <= end; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, newline), _mm_cmpeq_epi8(block, comma)),
+                                       _mm_cmpeq_epi8(block, colon));
+        count += appendMaskOffsets((unsigned int)_mm_movemask_epi8(matches), i, offsets + count);
+    }
+    return count + scanStructuralsScalar(data, i, end, offsets + count);
+}
+
+
+static inline __attribute__((target("avx2"))) unsigned int structuralMask32(const char* block, __m256i newline,
+                                                                             __m256i comma, __m256i colon) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i*)block);
+    __m256i matches = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, newline), _mm256_cmpeq_epi8(bytes, comma)),
+                                      _mm256_cmpeq_epi8(bytes, colon));
+    return (unsigned int)_mm256_movemask_epi8(matches);
+}
+
+// scans 64 bytes per iteration as two 32 byte halves merged into one mask
+static __attribute__((target("avx2"))) size_t scanStructuralsAvx2(const char* data, size_t start, size_t end, size_t* offsets) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i colon = _mm256_set1_epi8(':');
+
+    size_t count = 0;
+    size_t i = start;
+    for (; i + 64 <= end; i += 64) {
+        unsigned long long low = structuralMask32(data + i, newline, comma, colon);
+        unsigned long long high = structuralMask32(data + i + 32, newline, comma, colon);
+        count += appendMaskOffsets(low | (high << 32), i, offsets + count);
+    }
+    return count + scanStructuralsSse2(data, i, end, offsets + count);
+}
+
+#endif
+
+
+size_t scanStructurals(const char* data, size_t start, size_t end, size_t* offsets) {
+    if (!data || !offsets || start >= end) {
+        return 0;
+    }
+#ifdef STRUCTURAL_SCANNER_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return scanStructuralsAvx2(data, start, end, offsets);
+    }
+    return scanStructuralsSse2(data, start, end, offsets);
+#else
+    return scanStructuralsScalar(data, start, end, offsets);
+#endif
+}
+
+
+const char* getStructuralScannerName(void) {
+#ifdef STRUCTURAL_SCANNER_X86
+    return __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
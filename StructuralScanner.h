@@ -0,0 +1,48 @@
+#ifndef STRUCTURALSCANNER_H
+#define STRUCTURALSCANNER_H
+#include "Defs.h"
+
+
+/**
+ * Welcome to the Structural Scanner module!
+ * This module is the first stage of the configuration parser. It finds the structural characters
+ * of the configuration format - line ends ('\n') and field delimiters (',' and ':') - and reports
+ * their offsets, so the record builder can jump from field to field instead of inspecting every byte.
+ * On x86-64 the scan compares 64 bytes at a time with AVX2 when the CPU supports it, or 16 bytes at a
+ * time with SSE2 otherwise. Other platforms, and the tail of every range, use a scalar loop.
+ * Leading tabs are not reported: a characteristic line is recognized by the byte right after a line end.
+ */
+
+
+/**
+ * Finds the structural characters in data[start, end) with the fastest scanner the CPU supports
+ * @param data The buffer to scan
+ * @param start Offset of the first byte to scan
+ * @param end Offset one past the last byte to scan
+ * @param offsets Output array with room for at least (end - start) offsets
+ * @return The number of offsets written, in increasing order
+ */
+size_t scanStructurals(const char* data, size_t start, size_t end, size_t* offsets);
+
+
+
+/**
+ * Finds the structural characters in data[start, end) one byte at a time, used as the reference implementation
+ * @param data The buffer to scan
+ * @param start Offset of the first byte to scan
+ * @param end Offset one past the last byte to scan
+ * @param offsets Output array with room for at least (end - start) offsets
+ * @return The number of offsets written, in increasing order
+ */
+size_t scanStructuralsScalar(const char* data, size_t start, size_t end, size_t* offsets);
+
+
+
+/**
+ * Returns the name of the scanner used by scanStructurals on this CPU
+ * @return "avx2", "sse2" or "scalar"
+ */
+const char* getStructuralScannerName(void);
+
+
+#endif //STRUCTURALSCANNER_H